@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "allocationcounter.hpp"
+
+namespace {
+std::atomic<std::size_t> allocations {0};
+}
+
+std::size_t allocation_count() { return allocations.load(); }
+
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) { // NOLINT
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+
+void operator delete(void* ptr) noexcept { std::free(ptr); } // NOLINT
+
+void operator delete[](void* ptr) noexcept { operator delete(ptr); }
+
+void operator delete(void* ptr, std::size_t /*size*/) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t /*size*/) noexcept
+{
+    operator delete(ptr);
+}
+
+// std::pmr::new_delete_resource() allocates through the aligned forms, so they
+// are counted too.
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    const auto align = static_cast<std::size_t>(alignment);
+    // aligned_alloc needs the size to be a multiple of the alignment.
+    const auto rounded_size = (std::max<std::size_t>(size, 1) + align - 1)
+        / align * align;
+#ifdef _MSC_VER
+    void* ptr = _aligned_malloc(rounded_size, align);
+#else
+    void* ptr = std::aligned_alloc(align, rounded_size); // NOLINT
+#endif
+    if (ptr != nullptr) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void operator delete(void* ptr, std::align_val_t /*alignment*/) noexcept
+{
+#ifdef _MSC_VER
+    _aligned_free(ptr);
+#else
+    std::free(ptr); // NOLINT
+#endif
+}
+
+void operator delete[](void* ptr, std::align_val_t alignment) noexcept
+{
+    operator delete(ptr, alignment);
+}
+
+void operator delete(void* ptr, std::size_t /*size*/,
+                     std::align_val_t alignment) noexcept
+{
+    operator delete(ptr, alignment);
+}
+
+void operator delete[](void* ptr, std::size_t /*size*/,
+                       std::align_val_t alignment) noexcept
+{
+    operator delete(ptr, alignment);
+}
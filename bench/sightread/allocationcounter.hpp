@@ -0,0 +1,10 @@
+#ifndef SIGHTREAD_BENCH_ALLOCATIONCOUNTER_HPP
+#define SIGHTREAD_BENCH_ALLOCATIONCOUNTER_HPP
+
+#include <cstddef>
+
+// The number of calls to the global operator new so far. The benchmark binary
+// replaces operator new and delete to count these.
+std::size_t allocation_count();
+
+#endif
@@ -0,0 +1,481 @@
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+#include <iostream>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "allocationcounter.hpp"
+#include "sightread/detail/chart.hpp"
+#include "sightread/detail/chartconverter.hpp"
+#include "sightread/detail/midi.hpp"
+#include "sightread/detail/midiconverter.hpp"
+#include "sightread/detail/textencoding.hpp"
+#include "sightread/song.hpp"
+#include "sightread/songparts.hpp"
+#include "sightread/tempomap.hpp"
+
+namespace {
+struct BenchConfig {
+    int note_count = 10000;
+    int bpm_count = 500;
+    int track_count = 4;
+    std::string filter;
+};
+
+// Runs each benchmark for at least MIN_DURATION and prints the time,
+// throughput and allocations per operation. Benchmarks return a value derived
+// from their result so the work cannot be optimised away.
+class BenchRunner {
+private:
+    static constexpr std::chrono::milliseconds MIN_DURATION {500};
+
+    std::string m_filter;
+    volatile std::size_t m_sink {0};
+
+public:
+    explicit BenchRunner(std::string filter)
+        : m_filter {std::move(filter)}
+    {
+    }
+
+    template <typename F>
+    void run(std::string_view name, std::size_t bytes_per_op, F func)
+    {
+        constexpr double NS_PER_SECOND = 1e9;
+        constexpr double BYTES_PER_MB = 1e6;
+
+        if (!m_filter.empty()
+            && name.find(m_filter) == std::string_view::npos) {
+            return;
+        }
+
+        m_sink = m_sink + func();
+        const auto allocations_before = allocation_count();
+        const auto start = std::chrono::steady_clock::now();
+        std::size_t iterations = 0;
+        std::chrono::steady_clock::duration elapsed {};
+        do {
+            m_sink = m_sink + func();
+            ++iterations;
+            elapsed = std::chrono::steady_clock::now() - start;
+        } while (elapsed < MIN_DURATION);
+        const auto allocations = allocation_count() - allocations_before;
+
+        const auto seconds = std::chrono::duration<double>(elapsed).count();
+        const auto ns_per_op
+            = seconds * NS_PER_SECOND / static_cast<double>(iterations);
+        std::printf("%-32.*s %10zu iters %14.0f ns/op", // NOLINT
+                    static_cast<int>(name.size()), name.data(), iterations,
+                    ns_per_op);
+        if (bytes_per_op > 0) {
+            const auto mb_per_second = static_cast<double>(bytes_per_op)
+                * static_cast<double>(iterations) / seconds / BYTES_PER_MB;
+            std::printf(" %10.1f MB/s", mb_per_second); // NOLINT
+        } else {
+            std::printf(" %10s     ", "-"); // NOLINT
+        }
+        std::printf(" %10.1f allocs/op\n", // NOLINT
+                    static_cast<double>(allocations)
+                        / static_cast<double>(iterations));
+    }
+};
+
+constexpr int RESOLUTION = 192;
+constexpr int NOTE_GAP = 96;
+constexpr int SP_PHRASE_GAP = 64;
+constexpr int BPM_GAP = 3840;
+constexpr int BASE_BPM = 120000;
+constexpr std::array<std::string_view, 4> CHART_DIFFICULTIES {
+    "Easy", "Medium", "Hard", "Expert"};
+constexpr std::array<std::string_view, 6> CHART_INSTRUMENTS {
+    "Single", "DoubleBass", "Drums", "Keyboard", "DoubleRhythm",
+    "DoubleGuitar"};
+constexpr std::array<std::string_view, 6> MIDI_TRACK_NAMES {
+    "PART GUITAR", "PART BASS",   "PART DRUMS",
+    "PART KEYS",   "PART RHYTHM", "PART GUITAR COOP"};
+
+int bpm_at(int index)
+{
+    constexpr int BPM_STEP = 1000;
+    constexpr int BPM_STEP_COUNT = 60;
+    return BASE_BPM + (index % BPM_STEP_COUNT) * BPM_STEP;
+}
+
+std::string chart_note_section(int note_count, bool is_drums)
+{
+    constexpr int CHORD_PERIOD = 8;
+    constexpr int SUSTAIN_PERIOD = 4;
+    constexpr int SUSTAIN_LENGTH = 48;
+    constexpr int FIRST_CYMBAL_KEY = 66;
+    constexpr int LANE_COUNT = 5;
+
+    std::string section;
+    for (auto i = 0; i < note_count; ++i) {
+        const auto position = std::to_string(i * NOTE_GAP);
+        const auto fret = i % LANE_COUNT;
+        const auto length
+            = (!is_drums && i % SUSTAIN_PERIOD == 0) ? SUSTAIN_LENGTH : 0;
+        section += position + " = N " + std::to_string(fret) + ' '
+            + std::to_string(length) + '\n';
+        if (i % CHORD_PERIOD == 0) {
+            section += position + " = N "
+                + std::to_string((fret + 2) % LANE_COUNT) + " 0\n";
+        }
+        if (is_drums && fret >= 1 && fret <= 3) {
+            section += position + " = N "
+                + std::to_string(FIRST_CYMBAL_KEY + fret - 1) + " 0\n";
+        }
+        if (i % SP_PHRASE_GAP == 0) {
+            section += position + " = S 2 " + std::to_string(NOTE_GAP * 4)
+                + '\n';
+        }
+    }
+    return section;
+}
+
+std::string make_chart(const BenchConfig& config)
+{
+    std::string chart = "[Song]\n{\n  Resolution = "
+        + std::to_string(RESOLUTION) + "\n}\n[SyncTrack]\n{\n  0 = TS 4\n";
+    for (auto i = 0; i < config.bpm_count; ++i) {
+        chart += "  " + std::to_string(i * BPM_GAP) + " = B "
+            + std::to_string(bpm_at(i)) + '\n';
+    }
+    chart += "}\n[Events]\n{\n  0 = E \"section Intro\"\n}\n";
+    for (auto i = 0; i < config.track_count; ++i) {
+        const auto instrument
+            = CHART_INSTRUMENTS.at(static_cast<std::size_t>(i));
+        for (const auto difficulty : CHART_DIFFICULTIES) {
+            chart += '[';
+            chart += difficulty;
+            chart += instrument;
+            chart += "]\n{\n";
+            chart += chart_note_section(config.note_count,
+                                        instrument == "Drums");
+            chart += "}\n";
+        }
+    }
+    return chart;
+}
+
+void push_variable_length(std::vector<std::uint8_t>& data, int value)
+{
+    constexpr int DATA_BITS = 7;
+    constexpr int DATA_MASK = 0x7F;
+    constexpr int CONTINUATION_BIT = 0x80;
+
+    std::array<std::uint8_t, 4> bytes {};
+    auto byte_count = 0U;
+    do {
+        bytes.at(byte_count++) = static_cast<std::uint8_t>(value & DATA_MASK);
+        value >>= DATA_BITS;
+    } while (value > 0);
+    while (byte_count > 1) {
+        --byte_count;
+        data.push_back(static_cast<std::uint8_t>(bytes.at(byte_count)
+                                                 | CONTINUATION_BIT));
+    }
+    data.push_back(bytes[0]);
+}
+
+void push_event(std::vector<std::uint8_t>& data, int delta_time,
+                std::initializer_list<std::uint8_t> bytes)
+{
+    push_variable_length(data, delta_time);
+    for (const auto byte : bytes) {
+        data.push_back(byte);
+    }
+}
+
+void push_be(std::vector<std::uint8_t>& data, std::uint32_t value, int size)
+{
+    for (auto i = size - 1; i >= 0; --i) {
+        data.push_back(static_cast<std::uint8_t>(value >> (i * 8)));
+    }
+}
+
+void push_track(std::vector<std::uint8_t>& data,
+                const std::vector<std::uint8_t>& events)
+{
+    constexpr std::array<std::uint8_t, 4> TRACK_MAGIC {'M', 'T', 'r', 'k'};
+    constexpr std::array<std::uint8_t, 4> END_OF_TRACK {0, 0xFF, 0x2F, 0};
+
+    data.insert(data.end(), TRACK_MAGIC.cbegin(), TRACK_MAGIC.cend());
+    const auto track_size = events.size() + END_OF_TRACK.size();
+    push_be(data, static_cast<std::uint32_t>(track_size), 4);
+    data.insert(data.end(), events.cbegin(), events.cend());
+    data.insert(data.end(), END_OF_TRACK.cbegin(), END_OF_TRACK.cend());
+}
+
+std::vector<std::uint8_t> make_midi(const BenchConfig& config)
+{
+    constexpr std::uint32_t US_PER_MINUTE = 60000000;
+    constexpr std::array<std::uint8_t, 4> DIFFICULTY_BASE_KEYS {60, 72, 84, 96};
+    constexpr std::uint8_t SP_KEY = 116;
+    constexpr std::uint8_t NOTE_ON = 0x90;
+    constexpr std::uint8_t NOTE_OFF = 0x80;
+    constexpr std::uint8_t VELOCITY = 100;
+    constexpr int LANE_COUNT = 5;
+    constexpr int NOTE_LENGTH = 24;
+
+    std::vector<std::uint8_t> data {'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 1};
+    push_be(data, static_cast<std::uint32_t>(config.track_count + 1), 2);
+    push_be(data, RESOLUTION, 2);
+
+    std::vector<std::uint8_t> tempo_track;
+    for (auto i = 0; i < config.bpm_count; ++i) {
+        const auto us_per_beat = static_cast<std::uint32_t>(
+            static_cast<std::uint64_t>(US_PER_MINUTE) * 1000U / bpm_at(i));
+        push_event(tempo_track, i == 0 ? 0 : BPM_GAP, {0xFF, 0x51, 3});
+        push_be(tempo_track, us_per_beat, 3);
+    }
+    push_track(data, tempo_track);
+
+    for (auto i = 0; i < config.track_count; ++i) {
+        const auto name = MIDI_TRACK_NAMES.at(static_cast<std::size_t>(i));
+        std::vector<std::uint8_t> events;
+        push_event(events, 0,
+                   {0xFF, 3, static_cast<std::uint8_t>(name.size())});
+        for (const auto c : name) {
+            events.push_back(static_cast<std::uint8_t>(c));
+        }
+        for (auto j = 0; j < config.note_count; ++j) {
+            const auto is_sp_start = j % SP_PHRASE_GAP == 0;
+            const auto lane = j % LANE_COUNT;
+            auto delta_time = j == 0 ? 0 : NOTE_GAP - NOTE_LENGTH;
+            if (is_sp_start) {
+                push_event(events, delta_time, {NOTE_ON, SP_KEY, VELOCITY});
+                delta_time = 0;
+            }
+            for (const auto base_key : DIFFICULTY_BASE_KEYS) {
+                const auto key = static_cast<std::uint8_t>(base_key + lane);
+                push_event(events, delta_time, {NOTE_ON, key, VELOCITY});
+                delta_time = 0;
+            }
+            delta_time = NOTE_LENGTH;
+            for (const auto base_key : DIFFICULTY_BASE_KEYS) {
+                const auto key = static_cast<std::uint8_t>(base_key + lane);
+                push_event(events, delta_time, {NOTE_OFF, key, 0});
+                delta_time = 0;
+            }
+            if (is_sp_start) {
+                push_event(events, 0, {NOTE_OFF, SP_KEY, 0});
+            }
+        }
+        push_track(data, events);
+    }
+    return data;
+}
+
+int parse_int_argument(std::string_view name, const char* value)
+{
+    if (value == nullptr) {
+        throw std::invalid_argument(std::string(name) + " needs a value");
+    }
+    const auto result = std::atoi(value); // NOLINT
+    if (result <= 0) {
+        throw std::invalid_argument(std::string(name) + " must be positive");
+    }
+    return result;
+}
+
+BenchConfig parse_arguments(int argc, char** argv)
+{
+    constexpr int MAX_TRACK_COUNT = 6;
+
+    BenchConfig config;
+    for (auto i = 1; i < argc; ++i) {
+        const std::string_view argument {argv[i]}; // NOLINT
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr; // NOLINT
+        if (argument == "--notes") {
+            config.note_count = parse_int_argument(argument, value);
+            ++i;
+        } else if (argument == "--bpms") {
+            config.bpm_count = parse_int_argument(argument, value);
+            ++i;
+        } else if (argument == "--tracks") {
+            config.track_count = parse_int_argument(argument, value);
+            if (config.track_count > MAX_TRACK_COUNT) {
+                throw std::invalid_argument("--tracks must be at most 6");
+            }
+            ++i;
+        } else {
+            config.filter = argument;
+        }
+    }
+    return config;
+}
+
+void run_benchmarks(const BenchConfig& config)
+{
+    constexpr int CONVERSION_COUNT = 10000;
+
+    const auto chart_text = make_chart(config);
+    const auto midi_data = make_midi(config);
+    std::string utf16_chart_text {"\xFF\xFE"};
+    for (const auto c : chart_text) {
+        utf16_chart_text.push_back(c);
+        utf16_chart_text.push_back('\0');
+    }
+    const SightRead::Metadata metadata {"Bench", "SightRead", "SightRead"};
+    const auto chart = SightRead::Detail::parse_chart(chart_text);
+    const auto midi_index = SightRead::Detail::index_midi(midi_data);
+    auto song = SightRead::Detail::ChartConverter(metadata).convert(chart);
+    const auto& guitar_track = song.track(SightRead::Instrument::Guitar,
+                                          SightRead::Difficulty::Expert);
+    const auto& tempo_map = song.global_data().tempo_map();
+
+    std::cout << "notes per track: " << config.note_count
+              << ", BPM changes: " << config.bpm_count
+              << ", instruments: " << config.track_count
+              << ", chart bytes: " << chart_text.size()
+              << ", MIDI bytes: " << midi_data.size() << '\n';
+
+    BenchRunner runner {config.filter};
+    runner.run("parse_chart", chart_text.size(), [&] {
+        return SightRead::Detail::parse_chart(chart_text).sections.size();
+    });
+    runner.run("parse_midi", midi_data.size(), [&] {
+        return SightRead::Detail::parse_midi(midi_data).tracks.size();
+    });
+    runner.run("index_midi", midi_data.size(), [&] {
+        return SightRead::Detail::index_midi(midi_data).tracks.size();
+    });
+    runner.run("to_utf8 from UTF-16", utf16_chart_text.size(), [&] {
+        std::pmr::string buffer;
+        return SightRead::Detail::to_utf8(utf16_chart_text, buffer).size();
+    });
+    runner.run("ChartConverter::convert", chart_text.size(), [&] {
+        return SightRead::Detail::ChartConverter(metadata)
+            .convert(chart)
+            .instruments()
+            .size();
+    });
+    runner.run("MidiConverter::convert", midi_data.size(), [&] {
+        return SightRead::Detail::MidiConverter(metadata)
+            .convert(midi_index)
+            .instruments()
+            .size();
+    });
+    // Includes copying the notes, since the constructor takes them by value.
+    runner.run("NoteTrack constructor", 0, [&] {
+        const SightRead::NoteTrack track {
+            guitar_track.notes(), guitar_track.sp_phrases(),
+            SightRead::TrackType::FiveFret, song.global_data_ptr()};
+        return track.notes().size();
+    });
+    if (song.has_track(SightRead::Instrument::Drums,
+                       SightRead::Difficulty::Expert)) {
+        const auto& drum_track = song.track(SightRead::Instrument::Drums,
+                                            SightRead::Difficulty::Expert);
+        runner.run("generate_drum_fills", 0, [&] {
+            auto track = drum_track;
+            track.generate_drum_fills(tempo_map);
+            return track.drum_fills().size();
+        });
+    }
+    // A long drum track with a tempo change every measure, so looking each
+    // measure up in the TempoMap afresh is as expensive as it gets.
+    constexpr int LONG_DRUM_MEASURES = 20000;
+    constexpr int BEATS_PER_MEASURE = 4;
+    std::vector<SightRead::BPM> long_drum_bpms;
+    std::vector<SightRead::Note> long_drum_notes;
+    for (auto i = 0; i < LONG_DRUM_MEASURES; ++i) {
+        const auto measure_start = i * BEATS_PER_MEASURE * RESOLUTION;
+        long_drum_bpms.push_back({SightRead::Tick {measure_start}, bpm_at(i)});
+        for (auto j = 0; j < BEATS_PER_MEASURE; ++j) {
+            SightRead::Note note;
+            note.position = SightRead::Tick {measure_start + j * RESOLUTION};
+            note.flags = SightRead::FLAGS_DRUMS;
+            note.lengths.at(SightRead::DRUM_RED) = SightRead::Tick {0};
+            long_drum_notes.push_back(note);
+        }
+    }
+    const SightRead::TempoMap long_drum_tempo_map {
+        {{SightRead::Tick {0}, 4, 4}}, long_drum_bpms, {}, RESOLUTION};
+    const SightRead::NoteTrack long_drum_track {
+        long_drum_notes, {}, SightRead::TrackType::Drums,
+        song.global_data_ptr()};
+    runner.run("generate_drum_fills, long track", 0, [&] {
+        auto track = long_drum_track;
+        track.generate_drum_fills(long_drum_tempo_map);
+        return track.drum_fills().size();
+    });
+
+    std::vector<SightRead::Beat> beats;
+    beats.reserve(CONVERSION_COUNT);
+    const auto last_beat
+        = static_cast<double>(config.note_count) * NOTE_GAP / RESOLUTION;
+    for (auto i = 0; i < CONVERSION_COUNT; ++i) {
+        beats.emplace_back(last_beat * i / CONVERSION_COUNT);
+    }
+    std::vector<SightRead::Second> seconds(CONVERSION_COUNT,
+                                           SightRead::Second {0.0});
+    runner.run("TempoMap::to_seconds x10000", 0, [&] {
+        std::size_t total = 0;
+        for (const auto beat : beats) {
+            const auto time = tempo_map.to_seconds(beat);
+            total += static_cast<std::size_t>(time.value());
+        }
+        return total;
+    });
+    runner.run("TempoMap::to_seconds batch", 0, [&] {
+        tempo_map.to_seconds(beats, seconds);
+        return static_cast<std::size_t>(seconds.back().value());
+    });
+    runner.run("TempoMap::to_measures x10000", 0, [&] {
+        std::size_t total = 0;
+        for (const auto beat : beats) {
+            const auto measure = tempo_map.to_measures(beat);
+            total += static_cast<std::size_t>(measure.value());
+        }
+        return total;
+    });
+    runner.run("TempoMap::to_seconds(Measure)", 0, [&] {
+        std::size_t total = 0;
+        for (const auto beat : beats) {
+            const SightRead::Measure measure {beat.value() / 4};
+            const auto time = tempo_map.to_seconds(measure);
+            total += static_cast<std::size_t>(time.value());
+        }
+        return total;
+    });
+    // Most songs only have a handful of tempo changes.
+    const SightRead::TempoMap small_tempo_map {
+        {{SightRead::Tick {0}, 4, 4}},
+        {{SightRead::Tick {0}, 120000},
+         {SightRead::Tick {RESOLUTION * 64}, 150000},
+         {SightRead::Tick {RESOLUTION * 256}, 90000},
+         {SightRead::Tick {RESOLUTION * 512}, 200000}},
+        {},
+        RESOLUTION};
+    runner.run("TempoMap::to_seconds, 4 BPMs", 0, [&] {
+        std::size_t total = 0;
+        for (const auto beat : beats) {
+            const auto time = small_tempo_map.to_seconds(beat);
+            total += static_cast<std::size_t>(time.value());
+        }
+        return total;
+    });
+}
+}
+
+int main(int argc, char** argv)
+{
+    try {
+        run_benchmarks(parse_arguments(argc, argv));
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
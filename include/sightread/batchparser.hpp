@@ -0,0 +1,53 @@
+#ifndef SIGHTREAD_BATCHPARSER_HPP
+#define SIGHTREAD_BATCHPARSER_HPP
+
+#include <cstdint>
+#include <set>
+#include <span>
+#include <vector>
+
+#include "sightread/hopothreshold.hpp"
+#include "sightread/metadata.hpp"
+#include "sightread/song.hpp"
+#include "sightread/songparts.hpp"
+#include "sightread/tempomap.hpp"
+
+namespace SightRead {
+enum class FileFormat { Chart, Midi };
+
+struct ParseJob {
+    // The contents of the .chart/.mid file, which must outlive the call to
+    // BatchParser::parse. .chart files may be UTF-8 or UTF-16, as with
+    // ChartParser.
+    std::span<const std::uint8_t> data;
+    SightRead::FileFormat format;
+    SightRead::Metadata metadata;
+    SightRead::HopoThreshold hopo_threshold {
+        SightRead::HopoThresholdType::Resolution, SightRead::Tick {0}};
+};
+
+// Parses many files at once, spread over a number of threads. Each job is
+// parsed exactly as ChartParser or MidiParser would with the same settings.
+class BatchParser {
+private:
+    std::set<SightRead::Instrument> m_permitted_instruments;
+    bool m_permit_solos;
+    unsigned int m_thread_count;
+
+public:
+    BatchParser();
+    BatchParser&
+    permit_instruments(std::set<SightRead::Instrument> permitted_instruments);
+    BatchParser& parse_solos(bool permit_solos);
+    // The default is std::thread::hardware_concurrency(), or 1 if that is
+    // unknown.
+    BatchParser& threads(unsigned int thread_count);
+    // Returns the results in the same order as the jobs. A ParseError from a
+    // job is returned as its result, while any other exception is rethrown
+    // once all jobs have been tried.
+    [[nodiscard]] std::vector<SightRead::ParseResult>
+    parse(std::span<const SightRead::ParseJob> jobs) const;
+};
+}
+
+#endif
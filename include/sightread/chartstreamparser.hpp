@@ -0,0 +1,101 @@
+#ifndef SIGHTREAD_CHARTSTREAMPARSER_HPP
+#define SIGHTREAD_CHARTSTREAMPARSER_HPP
+
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+namespace SightRead {
+struct BpmEvent {
+    int position;
+    int bpm;
+};
+
+// data borrows from the text the event was read from.
+struct Event {
+    int position;
+    std::string_view data;
+};
+
+struct NoteEvent {
+    int position;
+    int fret;
+    int length;
+};
+
+struct SpecialEvent {
+    int position;
+    int key;
+    int length;
+};
+
+struct TimeSigEvent {
+    int position;
+    int numerator;
+    int denominator;
+};
+
+// Receives the contents of a .chart file from a ChartStreamParser as it is
+// read. The string_views passed point into the chunk the line was read from if
+// the line lay entirely within it, and otherwise are only valid for the
+// duration of the call.
+class ChartVisitor {
+public:
+    virtual ~ChartVisitor() = default;
+
+    // Returns if the section's body should be read. If not, its lines are
+    // skipped over without being tokenized and section_end is not called.
+    virtual bool section_start(std::string_view name) = 0;
+    virtual void section_end() { }
+    virtual void key_value(std::string_view /*key*/, std::string_view /*value*/)
+    {
+    }
+    virtual void bpm(const BpmEvent& /*event*/) { }
+    virtual void event(const Event& /*event*/) { }
+    virtual void note(const NoteEvent& /*event*/) { }
+    virtual void special(const SpecialEvent& /*event*/) { }
+    virtual void time_sig(const TimeSigEvent& /*event*/) { }
+};
+
+// Reads a .chart file given in chunks of any size, passing what it reads to
+// the visitor as soon as each line is complete. Only an unfinished line is
+// buffered between chunks. Throws SightRead::ParseError on malformed input,
+// after which the parser must not be used again. The error's offset is that
+// of the start of the offending line in the whole input. Unlike ChartParser,
+// the input must be UTF-8.
+class ChartStreamParser {
+private:
+    enum class State { Header, Open, Body, SkippedBody };
+
+    ChartVisitor* m_visitor;
+    State m_state {State::Header};
+    std::pmr::string m_section_name;
+    std::pmr::string m_partial_line;
+    bool m_is_skipping_whitespace {false};
+    // The offset in the whole input of the start of the chunk being read, and
+    // of the start of the current line.
+    std::size_t m_position {0};
+    std::size_t m_line_start {0};
+
+    void read_chunk(std::string_view chunk, bool is_last_chunk);
+    void read_line(std::string_view line);
+
+public:
+    explicit ChartStreamParser(
+        ChartVisitor& visitor,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : m_visitor {&visitor}
+        , m_section_name {resource}
+        , m_partial_line {resource}
+    {
+    }
+
+    void feed(std::string_view chunk);
+    // Reads last_chunk then ends the input, throwing if a section is left
+    // unfinished.
+    void finish(std::string_view last_chunk = {});
+};
+}
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef SIGHTREAD_INCREMENTALCHARTPARSER_HPP
+#define SIGHTREAD_INCREMENTALCHARTPARSER_HPP
+
+#include <memory>
+#include <set>
+#include <string_view>
+
+#include "sightread/hopothreshold.hpp"
+#include "sightread/metadata.hpp"
+#include "sightread/song.hpp"
+#include "sightread/songparts.hpp"
+
+namespace SightRead {
+// Parses successive versions of the same .chart file, as an editor would on
+// each save. Sections whose text is unchanged since the previous parse are
+// not tokenized again, and their note tracks are shared with the previous
+// Song rather than converted again, so long as the resolution in effect for
+// them is also unchanged. Each parse gives the same Song as ChartParser with
+// the same settings would. Changing a setting discards what was kept.
+class IncrementalChartParser {
+private:
+    struct State;
+
+    SightRead::Metadata m_metadata;
+    SightRead::HopoThreshold m_hopo_threshold;
+    std::set<SightRead::Instrument> m_permitted_instruments;
+    bool m_permit_solos;
+    unsigned int m_thread_count;
+    std::unique_ptr<State> m_state;
+
+public:
+    explicit IncrementalChartParser(SightRead::Metadata metadata);
+    IncrementalChartParser(IncrementalChartParser&& other) noexcept;
+    IncrementalChartParser& operator=(IncrementalChartParser&& other) noexcept;
+    IncrementalChartParser(const IncrementalChartParser&) = delete;
+    IncrementalChartParser& operator=(const IncrementalChartParser&) = delete;
+    ~IncrementalChartParser();
+
+    IncrementalChartParser&
+    hopo_threshold(SightRead::HopoThreshold hopo_threshold);
+    IncrementalChartParser&
+    permit_instruments(std::set<SightRead::Instrument> permitted_instruments);
+    IncrementalChartParser& parse_solos(bool permit_solos);
+    IncrementalChartParser& threads(unsigned int thread_count);
+    // The text of each section is copied, so data need not outlive the call.
+    // If the parse throws, what was kept from the previous parse is left
+    // as it was.
+    SightRead::Song parse(std::string_view data);
+};
+}
+
+#endif
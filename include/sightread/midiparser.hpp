@@ -2,13 +2,17 @@
 #define SIGHTREAD_MIDIPARSER_HPP
 
 #include <cstdint>
+#include <filesystem>
+#include <memory_resource>
 #include <set>
 #include <span>
 
 #include "sightread/hopothreshold.hpp"
 #include "sightread/metadata.hpp"
+#include "sightread/parsestats.hpp"
 #include "sightread/song.hpp"
 #include "sightread/songparts.hpp"
+#include "sightread/songsummary.hpp"
 
 namespace SightRead {
 class MidiParser {
@@ -17,6 +21,16 @@ private:
     SightRead::HopoThreshold m_hopo_threshold;
     std::set<SightRead::Instrument> m_permitted_instruments;
     bool m_permit_solos;
+    unsigned int m_thread_count;
+    std::pmr::memory_resource* m_resource;
+
+    // ParseCache hashes the settings that affect the result.
+    friend class ParseCache;
+
+    // Does the work of both parse overloads, recording nothing if stats is
+    // null.
+    SightRead::Song parse_with_stats(std::span<const std::uint8_t> data,
+                                     SightRead::ParseStats* stats) const;
 
 public:
     explicit MidiParser(SightRead::Metadata metadata);
@@ -24,7 +38,34 @@ public:
     MidiParser&
     permit_instruments(std::set<SightRead::Instrument> permitted_instruments);
     MidiParser& parse_solos(bool permit_solos);
+    // Converts the instrument tracks on up to thread_count threads. The
+    // resulting Song is the same regardless of the thread count.
+    MidiParser& threads(unsigned int thread_count);
+    // Sets the memory resource that the intermediate representation of the
+    // file is allocated from, so that a caller can e.g. give each parse its
+    // own std::pmr::monotonic_buffer_resource. The resulting Song still uses
+    // the global heap. The default is std::pmr::get_default_resource() at the
+    // time the parser is constructed. If more than one thread is used, the
+    // resource must be thread-safe.
+    MidiParser& memory_resource(std::pmr::memory_resource* resource);
     SightRead::Song parse(std::span<const std::uint8_t> data) const;
+    // As parse, but also adds the time and allocations spent in each phase,
+    // and the number of events read, to stats.
+    SightRead::Song parse(std::span<const std::uint8_t> data,
+                          SightRead::ParseStats& stats) const;
+    // Memory maps the file at path and parses directly from the mapping. Throws
+    // std::system_error if the file cannot be opened.
+    SightRead::Song parse_file(const std::filesystem::path& path) const;
+    // As parse, but a malformed file gives its ParseError as the result
+    // instead of throwing it. Other exceptions, such as std::bad_alloc, are
+    // still thrown.
+    [[nodiscard]] SightRead::ParseResult
+    try_parse(std::span<const std::uint8_t> data) const;
+    // Summarises the song without converting its note tracks, which is much
+    // cheaper than parse. Throws SightRead::ParseError if the file is
+    // malformed.
+    SightRead::SongSummary probe(std::span<const std::uint8_t> data) const;
+    SightRead::SongSummary probe_file(const std::filesystem::path& path) const;
 };
 }
 
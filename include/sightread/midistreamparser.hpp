@@ -0,0 +1,92 @@
+#ifndef SIGHTREAD_MIDISTREAMPARSER_HPP
+#define SIGHTREAD_MIDISTREAMPARSER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace SightRead {
+struct MidiEvent {
+    int status;
+    std::array<std::uint8_t, 2> data;
+};
+
+// The data spans of the event views point into the MIDI data they were read
+// from.
+struct MetaEventView {
+    int type;
+    std::span<const std::uint8_t> data;
+};
+
+struct SysexEventView {
+    std::span<const std::uint8_t> data;
+};
+
+// The undecoded events of a track, along with the track's name (if it has one)
+// so it can be decided if the track needs decoding at all.
+struct MidiTrackIndex {
+    std::span<const std::uint8_t> data;
+    std::optional<std::pmr::string> name;
+};
+
+// Receives the contents of a MIDI file from a MidiStreamParser as it is read.
+// The spans passed point into the chunk the track was read from if the whole
+// track chunk lay within it, and otherwise are only valid for the duration of
+// the call.
+class MidiVisitor {
+public:
+    virtual ~MidiVisitor() = default;
+
+    virtual void header(int /*ticks_per_quarter_note*/, int /*track_count*/) { }
+    // Called once each track chunk has been read in full. Returns if the
+    // track's events should be decoded and passed on; if not, track_end is not
+    // called either.
+    virtual bool track_start(const MidiTrackIndex& track) = 0;
+    virtual void track_end() { }
+    virtual void meta_event(int /*time*/, const MetaEventView& /*event*/) { }
+    virtual void midi_event(int /*time*/, const MidiEvent& /*event*/) { }
+    virtual void sysex_event(int /*time*/, const SysexEventView& /*event*/) { }
+};
+
+// Reads a MIDI file given in chunks of any size, passing each track to the
+// visitor once the whole track chunk has arrived. At most one track chunk is
+// buffered at a time. Throws SightRead::ParseError on malformed input, after
+// which the parser must not be used again. The error's offset is that of the
+// start of the header or track chunk being read in the whole input.
+class MidiStreamParser {
+private:
+    enum class State { Header, TrackHeader, TrackData, Done };
+
+    MidiVisitor* m_visitor;
+    State m_state {State::Header};
+    std::pmr::vector<std::uint8_t> m_buffer;
+    std::size_t m_bytes_needed;
+    int m_tracks_left {0};
+    // The number of bytes of the input taken so far, and the offset of the
+    // header or track chunk being read.
+    std::size_t m_position {0};
+    std::size_t m_chunk_start {0};
+
+    std::span<const std::uint8_t>
+    take_bytes(std::span<const std::uint8_t>& chunk);
+    void read_part(std::span<const std::uint8_t> part);
+    void read_track(std::span<const std::uint8_t> track_data);
+
+public:
+    explicit MidiStreamParser(
+        MidiVisitor& visitor,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    void feed(std::span<const std::uint8_t> chunk);
+    // Ends the input, throwing if the header or a track chunk is left
+    // unfinished.
+    void finish();
+};
+}
+
+#endif
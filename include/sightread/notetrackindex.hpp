@@ -0,0 +1,89 @@
+#ifndef SIGHTREAD_NOTETRACKINDEX_HPP
+#define SIGHTREAD_NOTETRACKINDEX_HPP
+
+#include <span>
+#include <vector>
+
+#include "sightread/drumsettings.hpp"
+#include "sightread/songparts.hpp"
+#include "sightread/tempomap.hpp"
+#include "sightread/time.hpp"
+
+namespace SightRead {
+// Answers "what is within this window?" for a NoteTrack in O(log n + k), where
+// k is the size of the result. Each query is inclusive at both ends and
+// returns a span into the track's own vectors, so the track must outlive the
+// index and not be modified while it is in use. Notes are found by their
+// position, and phrases by whether they overlap the window at all.
+//
+// The times in seconds come from the given TempoMap rather than the track's
+// own global data, so one track can be indexed for each speed of a Song. They
+// are computed once when the index is built, using the same conversions as
+// TempoMap::to_seconds.
+//
+// Phrases are found with a binary search on their starts and on the running
+// maximum of their ends. If phrases of one kind overlap each other, a span can
+// contain one ending before the window that lies within an earlier phrase
+// which does reach it; the parsers never produce overlapping phrases.
+class NoteTrackIndex {
+private:
+    template <typename T> struct Column {
+        std::vector<T> starts;
+        std::vector<T> max_ends;
+    };
+
+    template <typename Item> struct Phrases {
+        std::span<const Item> items;
+        Column<SightRead::Tick> ticks;
+        Column<SightRead::Second> seconds;
+    };
+
+    std::span<const SightRead::Note> m_notes;
+    std::vector<SightRead::Tick> m_note_ticks;
+    std::vector<SightRead::Second> m_note_seconds;
+    Phrases<SightRead::StarPower> m_sp_phrases;
+    Phrases<SightRead::Solo> m_solos;
+    Phrases<SightRead::DrumFill> m_drum_fills;
+    Phrases<SightRead::DiscoFlip> m_disco_flips;
+
+    template <typename Item>
+    static Phrases<Item> index_phrases(std::span<const Item> items,
+                                       const SightRead::TempoMap& tempo_map);
+    template <typename Item, typename Time>
+    static std::span<const Item> window(const Phrases<Item>& phrases,
+                                        const Column<Time>& column, Time start,
+                                        Time end);
+
+public:
+    // Throws std::invalid_argument if the notes or any kind of phrase are not
+    // sorted by their start, which the parsers and NoteTrack's setters for
+    // solos always ensure.
+    NoteTrackIndex(const SightRead::NoteTrack& track,
+                   const SightRead::TempoMap& tempo_map,
+                   const SightRead::DrumSettings& drum_settings
+                   = SightRead::DrumSettings::default_settings());
+
+    [[nodiscard]] std::span<const SightRead::Note>
+    notes(SightRead::Tick start, SightRead::Tick end) const;
+    [[nodiscard]] std::span<const SightRead::Note>
+    notes(SightRead::Second start, SightRead::Second end) const;
+    [[nodiscard]] std::span<const SightRead::StarPower>
+    sp_phrases(SightRead::Tick start, SightRead::Tick end) const;
+    [[nodiscard]] std::span<const SightRead::StarPower>
+    sp_phrases(SightRead::Second start, SightRead::Second end) const;
+    [[nodiscard]] std::span<const SightRead::Solo>
+    solos(SightRead::Tick start, SightRead::Tick end) const;
+    [[nodiscard]] std::span<const SightRead::Solo>
+    solos(SightRead::Second start, SightRead::Second end) const;
+    [[nodiscard]] std::span<const SightRead::DrumFill>
+    drum_fills(SightRead::Tick start, SightRead::Tick end) const;
+    [[nodiscard]] std::span<const SightRead::DrumFill>
+    drum_fills(SightRead::Second start, SightRead::Second end) const;
+    [[nodiscard]] std::span<const SightRead::DiscoFlip>
+    disco_flips(SightRead::Tick start, SightRead::Tick end) const;
+    [[nodiscard]] std::span<const SightRead::DiscoFlip>
+    disco_flips(SightRead::Second start, SightRead::Second end) const;
+};
+}
+
+#endif
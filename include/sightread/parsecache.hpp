@@ -0,0 +1,85 @@
+#ifndef SIGHTREAD_PARSECACHE_HPP
+#define SIGHTREAD_PARSECACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+
+#include "sightread/chartparser.hpp"
+#include "sightread/midiparser.hpp"
+#include "sightread/song.hpp"
+
+namespace SightRead {
+struct ParseCacheStats {
+    std::size_t hits {0};
+    std::size_t misses {0};
+    std::size_t evictions {0};
+    std::size_t entries {0};
+    std::size_t bytes {0};
+};
+
+// A least recently used cache of parsed Songs, keyed on a 128-bit hash of the
+// file and of every parser setting that affects the result, so byte-identical
+// files parsed with the same settings are only parsed once. The thread count
+// and memory resource of the parser are not part of the key, as they do not
+// change the Song. The cache is safe to use from several threads at once;
+// parses happen outside its lock, so two threads missing on the same file may
+// both parse it. ParseErrors are not cached. Copies of a cached Song may be
+// sped up, as Song::speedup gives the copy its own SongGlobalData.
+class ParseCache {
+private:
+    struct Key {
+        std::uint64_t low;
+        std::uint64_t high;
+
+        friend bool operator==(const Key&, const Key&) = default;
+    };
+
+    struct KeyHash {
+        std::size_t operator()(const Key& key) const
+        {
+            return static_cast<std::size_t>(key.low);
+        }
+    };
+
+    struct Entry {
+        Key key;
+        std::shared_ptr<const SightRead::Song> song;
+        std::size_t bytes;
+    };
+
+    std::size_t m_memory_budget;
+    mutable std::mutex m_mutex;
+    std::list<Entry> m_entries;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_index;
+    SightRead::ParseCacheStats m_stats;
+
+    static Key chart_key(const SightRead::ChartParser& parser,
+                         std::string_view data);
+    static Key midi_key(const SightRead::MidiParser& parser,
+                        std::span<const std::uint8_t> data);
+    std::shared_ptr<const SightRead::Song> find(const Key& key);
+    std::shared_ptr<const SightRead::Song>
+    insert(const Key& key, SightRead::Song song);
+
+public:
+    // memory_budget bounds the total size of the cached Songs in bytes, as
+    // estimated from the sizes of their tracks and tempo maps. A Song bigger
+    // than the whole budget is returned without being cached.
+    explicit ParseCache(std::size_t memory_budget);
+    [[nodiscard]] std::shared_ptr<const SightRead::Song>
+    parse(const SightRead::ChartParser& parser, std::string_view data);
+    [[nodiscard]] std::shared_ptr<const SightRead::Song>
+    parse(const SightRead::MidiParser& parser,
+          std::span<const std::uint8_t> data);
+    [[nodiscard]] SightRead::ParseCacheStats stats() const;
+    void clear();
+};
+}
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef SIGHTREAD_PARSESTATS_HPP
+#define SIGHTREAD_PARSESTATS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include "sightread/songparts.hpp"
+
+namespace SightRead {
+// The wall time spent in one phase of parsing, and the allocations made in it
+// if ParseStats::allocation_counter is set.
+struct PhaseStats {
+    std::chrono::nanoseconds time {0};
+    std::size_t allocations {0};
+};
+
+struct TrackParseStats {
+    SightRead::Instrument instrument;
+    // The difficulty of a .chart section. A MIDI track holds every difficulty,
+    // so this is std::nullopt for them.
+    std::optional<SightRead::Difficulty> difficulty;
+    std::size_t event_count;
+    // The whole conversion of the track, including note_track.
+    SightRead::PhaseStats conversion;
+    // Construction of the track's NoteTracks, which includes HOPO calculation.
+    SightRead::PhaseStats note_track;
+};
+
+// Filled in by the ChartParser::parse and MidiParser::parse overloads taking
+// one. Gathering these costs nothing when the other overloads are used.
+struct ParseStats {
+    // SightRead does not count allocations itself. If this is set, it is
+    // called at the start and end of each phase, and should return the number
+    // of allocations so far, e.g., from a replaced operator new. When tracks
+    // are converted on several threads each track's count includes the other
+    // threads' allocations.
+    std::size_t (*allocation_counter)() = nullptr;
+    std::size_t input_bytes {0};
+    // The number of events read from the sections or tracks that were used.
+    std::size_t event_count {0};
+    SightRead::PhaseStats total;
+    // parse_chart for .chart files, indexing the tracks for .mid files.
+    SightRead::PhaseStats tokenize;
+    // Reading [SyncTrack] for .chart files, decoding and reading the tempo
+    // track for .mid files.
+    SightRead::PhaseStats tempo_map;
+    std::vector<SightRead::TrackParseStats> tracks;
+};
+}
+
+#endif
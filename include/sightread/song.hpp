@@ -1,28 +1,138 @@
 #ifndef SIGHTREAD_SONG_HPP
 #define SIGHTREAD_SONG_HPP
 
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <map>
 #include <memory>
-#include <tuple>
+#include <span>
+#include <variant>
 #include <vector>
 
+#include "sightread/hopothreshold.hpp"
 #include "sightread/songparts.hpp"
 #include "sightread/time.hpp"
 
 namespace SightRead {
+// The values of an enum whose bits are set in a mask, in increasing order.
+// This only holds the mask, so it is returned by value without allocating.
+template <typename Enum> class EnumMaskView {
+private:
+    std::uint32_t m_mask;
+
+public:
+    class Iterator {
+    private:
+        std::uint32_t m_mask {0};
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Enum;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Enum*;
+        using reference = Enum;
+
+        Iterator() = default;
+        explicit Iterator(std::uint32_t mask)
+            : m_mask {mask}
+        {
+        }
+
+        Enum operator*() const
+        {
+            return static_cast<Enum>(std::countr_zero(m_mask));
+        }
+        Iterator& operator++()
+        {
+            m_mask &= m_mask - 1;
+            return *this;
+        }
+        Iterator operator++(int)
+        {
+            auto copy = *this;
+            ++*this;
+            return copy;
+        }
+        bool operator==(const Iterator& other) const = default;
+    };
+
+    explicit EnumMaskView(std::uint32_t mask)
+        : m_mask {mask}
+    {
+    }
+
+    [[nodiscard]] Iterator begin() const { return Iterator {m_mask}; }
+    [[nodiscard]] Iterator end() const { return Iterator {}; }
+    [[nodiscard]] Iterator cbegin() const { return begin(); }
+    [[nodiscard]] Iterator cend() const { return end(); }
+    [[nodiscard]] bool empty() const { return m_mask == 0; }
+    [[nodiscard]] std::size_t size() const
+    {
+        return static_cast<std::size_t>(std::popcount(m_mask));
+    }
+    [[nodiscard]] bool contains(Enum value) const
+    {
+        return (m_mask & (1U << static_cast<unsigned int>(value))) != 0U;
+    }
+    [[nodiscard]] std::uint32_t mask() const { return m_mask; }
+};
+
 class Song {
 private:
     std::shared_ptr<SightRead::SongGlobalData> m_global_data
         = std::make_shared<SightRead::SongGlobalData>();
-    std::map<std::tuple<SightRead::Instrument, SightRead::Difficulty>,
-             SightRead::NoteTrack>
-        m_tracks;
+    static constexpr std::size_t INSTRUMENT_COUNT
+        = static_cast<std::size_t>(SightRead::Instrument::FortniteVocals) + 1;
+    static constexpr std::size_t DIFFICULTY_COUNT
+        = static_cast<std::size_t>(SightRead::Difficulty::Expert) + 1;
+    static constexpr std::size_t TRACK_SLOT_COUNT
+        = INSTRUMENT_COUNT * DIFFICULTY_COUNT;
+    static_assert(TRACK_SLOT_COUNT <= 64);
+    static_assert(INSTRUMENT_COUNT <= 32);
+
+    // m_track_indices maps each (instrument, difficulty) slot to its track's
+    // index in m_tracks, or -1 if it has none. Bit i of m_track_mask is set
+    // if slot i has a track. Tracks are never modified once added, so copies
+    // of the Song share them.
+    std::vector<std::shared_ptr<const SightRead::NoteTrack>> m_tracks;
+    std::array<std::int8_t, TRACK_SLOT_COUNT> m_track_indices
+        = empty_track_indices();
+    std::uint64_t m_track_mask {0};
+    // Bitmask of the instruments with an SP phrase starting at each position,
+    // kept up to date as tracks are added.
+    std::map<SightRead::Tick, std::uint32_t> m_sp_phrase_instruments;
+    std::vector<SightRead::Tick> m_unison_phrase_positions;
+
+    static constexpr std::array<std::int8_t, TRACK_SLOT_COUNT>
+    empty_track_indices()
+    {
+        std::array<std::int8_t, TRACK_SLOT_COUNT> indices {};
+        indices.fill(-1);
+        return indices;
+    }
+    static std::size_t track_slot(SightRead::Instrument instrument,
+                                  SightRead::Difficulty difficulty)
+    {
+        return static_cast<std::size_t>(instrument) * DIFFICULTY_COUNT
+            + static_cast<std::size_t>(difficulty);
+    }
+
+    void add_unison_phrases(SightRead::Instrument instrument,
+                            const SightRead::NoteTrack& note_track);
 
 public:
     Song() = default;
     void add_note_track(SightRead::Instrument instrument,
                         SightRead::Difficulty difficulty,
                         SightRead::NoteTrack note_track);
+    // Adds a track that may be shared with other Songs. As above, empty tracks
+    // and tracks for a slot that already has one are ignored.
+    void add_note_track(SightRead::Instrument instrument,
+                        SightRead::Difficulty difficulty,
+                        std::shared_ptr<const SightRead::NoteTrack> note_track);
     [[nodiscard]] SightRead::SongGlobalData& global_data()
     {
         return *m_global_data;
@@ -36,15 +146,52 @@ public:
     {
         return m_global_data;
     }
-    [[nodiscard]] std::vector<SightRead::Instrument> instruments() const;
-    [[nodiscard]] std::vector<SightRead::Difficulty>
-    difficulties(SightRead::Instrument instrument) const;
+    [[nodiscard]] bool has_instrument(SightRead::Instrument instrument) const;
+    [[nodiscard]] bool has_track(SightRead::Instrument instrument,
+                                 SightRead::Difficulty difficulty) const
+    {
+        return (m_track_mask & (1ULL << track_slot(instrument, difficulty)))
+            != 0U;
+    }
+    [[nodiscard]] EnumMaskView<SightRead::Instrument> instruments() const;
+    [[nodiscard]] EnumMaskView<SightRead::Difficulty>
+    difficulties(SightRead::Instrument instrument) const
+    {
+        constexpr std::uint64_t DIFFICULTY_MASK
+            = (1ULL << DIFFICULTY_COUNT) - 1;
+
+        const auto first_slot
+            = track_slot(instrument, SightRead::Difficulty::Easy);
+        return EnumMaskView<SightRead::Difficulty> {static_cast<std::uint32_t>(
+            (m_track_mask >> first_slot) & DIFFICULTY_MASK)};
+    }
     [[nodiscard]] const SightRead::NoteTrack&
     track(SightRead::Instrument instrument,
           SightRead::Difficulty difficulty) const;
-    [[nodiscard]] std::vector<SightRead::Tick> unison_phrase_positions() const;
+    [[nodiscard]] const std::vector<SightRead::Tick>&
+    unison_phrase_positions() const
+    {
+        return m_unison_phrase_positions;
+    }
+    // Speeds up the song in place, renaming it and replacing its tempo map.
+    // The song first takes its own copy of its SongGlobalData, so copies of
+    // it are unaffected.
     void speedup(int speed);
+    // Returns the song at speed%, sharing the note tracks with this one.
+    [[nodiscard]] Song with_speed(int speed) const;
+    // Returns the song as it would be parsed with a different HOPO threshold,
+    // sharing its SongGlobalData and every track the threshold does not
+    // affect. Only FLAGS_HOPO is recomputed, so this is much cheaper than
+    // parsing the file again.
+    [[nodiscard]] Song
+    with_hopo_threshold(const SightRead::HopoThreshold& hopo_threshold) const;
+    // As above for several thresholds, with one pass over each track's notes.
+    [[nodiscard]] std::vector<Song> with_hopo_thresholds(
+        std::span<const SightRead::HopoThreshold> hopo_thresholds) const;
 };
+
+// The outcome of parsing a file without throwing on malformed input.
+using ParseResult = std::variant<SightRead::Song, SightRead::ParseError>;
 }
 
 #endif
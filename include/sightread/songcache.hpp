@@ -0,0 +1,37 @@
+#ifndef SIGHTREAD_SONGCACHE_HPP
+#define SIGHTREAD_SONGCACHE_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#include "sightread/song.hpp"
+
+namespace SightRead {
+// A binary snapshot of an already parsed Song, including the TempoMap's
+// precomputed conversions, so that loading it is a bounds-checked copy rather
+// than a fresh parse. The format is private to SightRead and only meant to be
+// read by the same version of the library on the same platform: arrays are
+// stored in their in-memory layout, 8-byte aligned, so the file can be memory
+// mapped.
+class SongCache {
+public:
+    // Bumped whenever the layout of the snapshot changes. Snapshots with a
+    // different version are rejected rather than converted.
+    static constexpr std::uint32_t VERSION = 3;
+
+    [[nodiscard]] static std::vector<std::uint8_t>
+    save(const SightRead::Song& song);
+    // Throws SightRead::ParseError if the data is not a snapshot of this
+    // version, or is truncated or otherwise malformed.
+    [[nodiscard]] static SightRead::Song
+    load(std::span<const std::uint8_t> data);
+    // Memory maps the file at path and loads from the mapping. Throws
+    // std::system_error if the file cannot be opened.
+    [[nodiscard]] static SightRead::Song
+    load_file(const std::filesystem::path& path);
+};
+}
+
+#endif
@@ -6,6 +6,7 @@
 #include <memory>
 #include <optional>
 #include <set>
+#include <span>
 #include <string>
 #include <utility>
 #include <vector>
@@ -101,6 +102,42 @@ public:
     is_skipped_kick(const SightRead::DrumSettings& settings) const;
 };
 
+// A column-wise copy of a sequence of notes, for scans that only need some of
+// each note's fields. Sustain lengths are stored only for the lanes each note
+// is on, in lane order.
+class NoteColumns {
+private:
+    std::vector<SightRead::Tick> m_positions;
+    std::vector<std::uint8_t> m_colours;
+    std::vector<NoteFlags> m_flags;
+    std::vector<std::uint32_t> m_length_offsets;
+    std::vector<SightRead::Tick> m_lengths;
+
+public:
+    NoteColumns() = default;
+    explicit NoteColumns(std::span<const Note> notes);
+
+    [[nodiscard]] std::size_t size() const { return m_positions.size(); }
+    [[nodiscard]] bool empty() const { return m_positions.empty(); }
+    [[nodiscard]] std::span<const SightRead::Tick> positions() const
+    {
+        return m_positions;
+    }
+    // Bit i of each colour mask is set if the note is on lane i, matching
+    // Note::colours.
+    [[nodiscard]] std::span<const std::uint8_t> colours() const
+    {
+        return m_colours;
+    }
+    [[nodiscard]] std::span<const NoteFlags> flags() const { return m_flags; }
+    [[nodiscard]] std::span<const SightRead::Tick>
+    lengths(std::size_t index) const;
+    // Returns Tick {-1} if the note is not on the lane, as Note::lengths does.
+    [[nodiscard]] SightRead::Tick length(std::size_t index,
+                                         unsigned int lane) const;
+    [[nodiscard]] Note note(std::size_t index) const;
+};
+
 struct StarPower {
     SightRead::Tick position;
     SightRead::Tick length;
@@ -196,8 +233,19 @@ public:
     }
 };
 
+// Changes for NoteTrack::transform to make to a track's notes in one pass.
+// Sustains are trimmed before chords are snapped, as with calling
+// trim_sustains then snap_chords.
+struct NoteTrackTransforms {
+    bool trim_sustains = false;
+    std::optional<SightRead::Tick> snap_gap;
+    bool disable_dynamics = false;
+};
+
 class NoteTrack {
 private:
+    friend class SightRead::SongCache;
+
     std::vector<Note> m_notes;
     std::vector<StarPower> m_sp_phrases;
     std::vector<Solo> m_solos;
@@ -205,26 +253,48 @@ private:
     std::vector<DiscoFlip> m_disco_flips;
     std::optional<BigRockEnding> m_bre;
     TrackType m_track_type;
-    std::shared_ptr<SongGlobalData> m_global_data;
+    int m_resolution;
     int m_base_score_ticks;
-
-    void compute_base_score_ticks();
+    // Lane counts of kick notes, double kick notes and all other notes, so
+    // base_score need not scan the notes.
+    int m_kick_lane_count {0};
+    int m_double_kick_lane_count {0};
+    int m_other_lane_count {0};
+    // Drum solos for each combination of the kick settings, indexed by
+    // drum_solo_index.
+    std::array<std::vector<Solo>, 4> m_drum_solos;
+
+    static std::size_t
+    drum_solo_index(const SightRead::DrumSettings& drum_settings);
+
+    void dedupe_and_merge_notes();
     void merge_same_time_notes();
-    void add_hopos(SightRead::Tick max_hopo_gap);
+    void finish_notes(SightRead::Tick max_hopo_gap);
+    void apply_transforms(const NoteTrackTransforms& transforms);
+    void recompute_hopos(SightRead::Tick max_hopo_gap);
+    void compute_lane_counts();
+    [[nodiscard]] std::vector<Solo>
+    compute_drum_solos(const SightRead::DrumSettings& drum_settings) const;
+    void cache_drum_solos();
 
 public:
     NoteTrack(std::vector<Note> notes, const std::vector<StarPower>& sp_phrases,
-              TrackType track_type, std::shared_ptr<SongGlobalData> global_data,
+              TrackType track_type,
+              const std::shared_ptr<SongGlobalData>& global_data,
               SightRead::Tick max_hopo_gap = SightRead::Tick {65});
     void generate_drum_fills(const SightRead::TempoMap& tempo_map);
     void disable_dynamics();
     [[nodiscard]] const std::vector<Note>& notes() const { return m_notes; }
+    [[nodiscard]] NoteColumns note_columns() const
+    {
+        return NoteColumns {m_notes};
+    }
     [[nodiscard]] const std::vector<StarPower>& sp_phrases() const
     {
         return m_sp_phrases;
     }
 
-    [[nodiscard]] std::vector<Solo>
+    [[nodiscard]] const std::vector<Solo>&
     solos(const SightRead::DrumSettings& drum_settings) const;
     void solos(std::vector<Solo> solos);
 
@@ -250,15 +320,28 @@ public:
     void bre(std::optional<BigRockEnding> bre) { m_bre = std::move(bre); }
 
     [[nodiscard]] TrackType track_type() const { return m_track_type; }
-    [[nodiscard]] const SongGlobalData& global_data() const
-    {
-        return *m_global_data;
-    }
+    // Tracks only keep the resolution of the SongGlobalData they were made
+    // with, so they can be shared between Songs with different tempo maps.
+    // Timing goes through the Song's global_data() instead.
+    [[nodiscard]] int resolution() const { return m_resolution; }
     [[nodiscard]] int
     base_score(SightRead::DrumSettings drum_settings
                = SightRead::DrumSettings::default_settings()) const;
-    [[nodiscard]] NoteTrack trim_sustains() const;
-    [[nodiscard]] NoteTrack snap_chords(SightRead::Tick snap_gap) const;
+    [[nodiscard]] NoteTrack trim_sustains() const&;
+    [[nodiscard]] NoteTrack trim_sustains() &&;
+    [[nodiscard]] NoteTrack snap_chords(SightRead::Tick snap_gap) const&;
+    [[nodiscard]] NoteTrack snap_chords(SightRead::Tick snap_gap) &&;
+    [[nodiscard]] NoteTrack
+    transform(const NoteTrackTransforms& transforms) const&;
+    [[nodiscard]] NoteTrack transform(const NoteTrackTransforms& transforms) &&;
+    // Returns the track with FLAGS_HOPO worked out again for a different HOPO
+    // threshold, from the forcing flags kept on each note. This gives the same
+    // notes as parsing the track with that threshold.
+    [[nodiscard]] NoteTrack with_hopos(SightRead::Tick max_hopo_gap) const&;
+    [[nodiscard]] NoteTrack with_hopos(SightRead::Tick max_hopo_gap) &&;
+    // As above for several thresholds at once, in one pass over the notes.
+    [[nodiscard]] std::vector<NoteTrack>
+    with_hopos(std::span<const SightRead::Tick> max_hopo_gaps) const;
 };
 }
 
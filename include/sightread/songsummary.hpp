@@ -0,0 +1,31 @@
+#ifndef SIGHTREAD_SONGSUMMARY_HPP
+#define SIGHTREAD_SONGSUMMARY_HPP
+
+#include <vector>
+
+#include "sightread/songparts.hpp"
+#include "sightread/time.hpp"
+
+namespace SightRead {
+struct TrackSummary {
+    SightRead::Instrument instrument;
+    SightRead::Difficulty difficulty;
+    // The number of gems, so each lane of a chord counts separately. No
+    // merging or cleanup is done as with NoteTrack, so this can differ a
+    // little from the number of gems in the parsed track.
+    int note_count;
+};
+
+// The overview of a song given by ChartParser::probe and MidiParser::probe,
+// which skip building the Song's note tracks.
+struct SongSummary {
+    int resolution;
+    // Tracks with at least one note, ordered by instrument then difficulty.
+    std::vector<SightRead::TrackSummary> tracks;
+    // The end of the last note, including its sustain.
+    SightRead::Tick length;
+    SightRead::Second length_seconds;
+};
+}
+
+#endif
@@ -1,19 +1,51 @@
 #ifndef SIGHTREAD_TEMPOMAP_HPP
 #define SIGHTREAD_TEMPOMAP_HPP
 
+#include <cstddef>
 #include <cstdint>
+#include <optional>
+#include <span>
 #include <stdexcept>
 #include <vector>
 
 #include "sightread/time.hpp"
 
 namespace SightRead {
+class SongCache;
+
+// The kind of problem a ParseError reports, so callers can sort failures
+// without matching on the message.
+enum class ParseErrorCode {
+    MalformedData,
+    InvalidEncoding,
+    Unsupported,
+    NoNotes
+};
+
 class ParseError : public std::runtime_error {
+private:
+    SightRead::ParseErrorCode m_code;
+    std::optional<std::size_t> m_offset;
+
 public:
-    explicit ParseError(const char* what)
+    explicit ParseError(const char* what,
+                        SightRead::ParseErrorCode code
+                        = SightRead::ParseErrorCode::MalformedData,
+                        std::optional<std::size_t> offset = std::nullopt)
         : std::runtime_error {what}
+        , m_code {code}
+        , m_offset {offset}
     {
     }
+
+    [[nodiscard]] SightRead::ParseErrorCode code() const { return m_code; }
+    // The byte offset in the file of the line (.chart) or chunk (.mid) that
+    // could not be read, if the error is tied to one. For UTF-16 .chart files
+    // this is an offset into the text transcoded to UTF-8.
+    [[nodiscard]] std::optional<std::size_t> offset() const
+    {
+        return m_offset;
+    }
 };
 
 struct TimeSignature {
@@ -37,19 +69,83 @@ struct BPM {
 // time_sigs() is never empty.
 class TempoMap {
 private:
-    struct BeatTimestamp {
-        SightRead::Beat beat;
-        SightRead::Second time;
-    };
+    friend class SightRead::SongCache;
 
-    struct MeasureTimestamp {
-        SightRead::Measure measure;
-        SightRead::Beat beat;
-    };
+    // A piecewise linear function through the points (xs[i], ys[i]), with the
+    // span of each piece between points precomputed. Evaluating it is a search
+    // for the piece followed by the same interpolation the conversions have
+    // always done, so the results match them to the last bit. Outside the
+    // points it carries on at a fixed rate.
+    class PiecewiseLinear {
+    public:
+        // A rate kept as a fraction, so extrapolating multiplies and divides
+        // in the same order as Beat::to_second and friends.
+        struct Rate {
+            double numerator;
+            double denominator;
+        };
+
+    private:
+        // Below this many points, a linear scan over them is faster than a
+        // binary search, and the compiler can vectorise it.
+        static constexpr std::size_t LINEAR_SEARCH_LIMIT = 16;
 
-    struct OdBeatTimestamp {
-        SightRead::OdBeat od_beat;
-        SightRead::Beat beat;
+        std::vector<double> m_xs;
+        std::vector<double> m_ys;
+        // m_x_spans[i] is xs[i] - xs[i - 1], and likewise for m_y_spans. The
+        // first entry of each is unused.
+        std::vector<double> m_x_spans;
+        std::vector<double> m_y_spans;
+        Rate m_lead_rate {1.0, 1.0};
+        Rate m_tail_rate {1.0, 1.0};
+
+        friend class SightRead::SongCache;
+
+        void compute_spans();
+
+    public:
+        PiecewiseLinear() = default;
+        // xs must be non-empty and increasing, and the same size as ys.
+        // lead_rate is the rate before xs.front(), and tail_rate the rate
+        // after xs.back().
+        PiecewiseLinear(std::vector<double> xs, std::vector<double> ys,
+                        Rate lead_rate, Rate tail_rate);
+
+        // The index of the piece x is in: the number of points before x.
+        // Piece 0 is before the first point and piece xs.size() after the
+        // last; piece i otherwise runs from xs[i - 1] up to and including
+        // xs[i].
+        [[nodiscard]] std::size_t piece_index(double x) const;
+        // As piece_index, given that prev_index was the piece of the last
+        // input. Only searches forward from there, unless x is earlier.
+        [[nodiscard]] std::size_t advance_piece_index(std::size_t prev_index,
+                                                      double x) const;
+        [[nodiscard]] double evaluate(std::size_t index, double x) const
+        {
+            if (index == 0) {
+                return m_ys.front()
+                    + (x - m_xs.front()) * m_lead_rate.numerator
+                    / m_lead_rate.denominator;
+            }
+            if (index == m_xs.size()) {
+                return m_ys.back()
+                    + (x - m_xs.back()) * m_tail_rate.numerator
+                    / m_tail_rate.denominator;
+            }
+            return m_ys[index - 1]
+                + m_y_spans[index]
+                * ((x - m_xs[index - 1]) / m_x_spans[index]);
+        }
+        [[nodiscard]] double operator()(double x) const
+        {
+            return evaluate(piece_index(x), x);
+        }
+
+        // The inverse function. Requires ys to be increasing.
+        [[nodiscard]] PiecewiseLinear inverse() const;
+        // Multiply the outputs by a positive scale, and replace the rate after
+        // the last point.
+        void scale_outputs(double scale, Rate tail_rate);
     };
 
     static constexpr double DEFAULT_BEAT_RATE = 4.0;
@@ -61,16 +157,48 @@ private:
     std::vector<SightRead::Tick> m_od_beats;
     int m_resolution;
 
-    std::vector<BeatTimestamp> m_beat_timestamps;
-    std::int64_t m_last_bpm;
+    // The conversions, precomputed when the TempoMap is built. They are shared
+    // between the single value conversions and the Cursor so both give
+    // identical results.
+    PiecewiseLinear m_beats_to_seconds;
+    PiecewiseLinear m_seconds_to_beats;
+    PiecewiseLinear m_measures_to_beats;
+    PiecewiseLinear m_beats_to_measures;
+    PiecewiseLinear m_od_beats_to_beats;
+    PiecewiseLinear m_beats_to_od_beats;
 
-    std::vector<MeasureTimestamp> m_measure_timestamps;
-    double m_last_beat_rate;
+public:
+    // Converts positions that are mostly non-decreasing, remembering where in
+    // the TempoMap the last conversion of each kind was so the next one only
+    // needs to look forwards from there. If a position is earlier than the
+    // previous one of the same kind, it falls back to a binary search, so the
+    // results are always identical to the TempoMap's own methods. The TempoMap
+    // must outlive the Cursor.
+    class Cursor {
+    private:
+        const TempoMap* m_tempo_map;
+        std::size_t m_beat_index {0};
+        std::size_t m_measure_index {0};
+        std::size_t m_od_beat_index {0};
+        std::size_t m_seconds_index {0};
+        std::size_t m_time_index {0};
 
-    std::vector<OdBeatTimestamp> m_od_beat_timestamps;
-    double m_last_od_beat_rate;
+    public:
+        explicit Cursor(const TempoMap& tempo_map)
+            : m_tempo_map {&tempo_map}
+        {
+        }
+
+        [[nodiscard]] SightRead::Beat to_beats(SightRead::Measure measures);
+        [[nodiscard]] SightRead::Beat to_beats(SightRead::Second seconds);
+        [[nodiscard]] SightRead::Measure to_measures(SightRead::Beat beats);
+        [[nodiscard]] SightRead::OdBeat to_od_beats(SightRead::Beat beats);
+        [[nodiscard]] SightRead::Second to_seconds(SightRead::Beat beats);
+        [[nodiscard]] SightRead::Second to_seconds(SightRead::Measure measures);
+        [[nodiscard]] SightRead::Second to_seconds(SightRead::Tick ticks);
+        [[nodiscard]] SightRead::Tick to_ticks(SightRead::Second seconds);
+    };
 
-public:
     TempoMap()
         : TempoMap({}, {}, {}, DEFAULT_RESOLUTION)
     {
@@ -83,7 +211,9 @@ public:
     }
     [[nodiscard]] const std::vector<BPM>& bpms() const { return m_bpms; }
 
-    // Return the TempoMap for a speedup of speed% (normal speed is 100).
+    // Return the TempoMap for a speedup of speed% (normal speed is 100). This
+    // is a copy with its BPMs and conversions rescaled, so costs no more than
+    // copying the TempoMap.
     [[nodiscard]] TempoMap speedup(int speed) const;
 
     [[nodiscard]] SightRead::Beat to_beats(SightRead::Measure measures) const;
@@ -111,6 +241,22 @@ public:
         return SightRead::Tick {static_cast<int>(beats.value() * m_resolution)};
     }
     [[nodiscard]] SightRead::Tick to_ticks(SightRead::Second seconds) const;
+
+    [[nodiscard]] Cursor cursor() const { return Cursor {*this}; }
+
+    // Batch conversions, writing the conversion of input[i] to output[i]. Meant
+    // for sorted input, for which they take linear time. Throws
+    // std::invalid_argument if input and output have different sizes.
+    void to_beats(std::span<const SightRead::Second> input,
+                  std::span<SightRead::Beat> output) const;
+    void to_measures(std::span<const SightRead::Beat> input,
+                     std::span<SightRead::Measure> output) const;
+    void to_od_beats(std::span<const SightRead::Beat> input,
+                     std::span<SightRead::OdBeat> output) const;
+    void to_seconds(std::span<const SightRead::Beat> input,
+                    std::span<SightRead::Second> output) const;
+    void to_seconds(std::span<const SightRead::Tick> input,
+                    std::span<SightRead::Second> output) const;
 };
 }
 
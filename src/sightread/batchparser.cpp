@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#include "sightread/batchparser.hpp"
+#include "sightread/chartparser.hpp"
+#include "sightread/detail/parallel.hpp"
+#include "sightread/midiparser.hpp"
+
+namespace {
+SightRead::Song parse_job(const SightRead::ParseJob& job,
+                          const std::set<SightRead::Instrument>& instruments,
+                          bool permit_solos)
+{
+    // Everything allocated from the arena is gone once the Song is built, so
+    // it is all freed at once when the job is done.
+    std::pmr::monotonic_buffer_resource arena;
+    if (job.format == SightRead::FileFormat::Chart) {
+        const std::string_view chart_data {
+            reinterpret_cast<const char*>(job.data.data()), // NOLINT
+            job.data.size()};
+        return SightRead::ChartParser(job.metadata)
+            .hopo_threshold(job.hopo_threshold)
+            .permit_instruments(instruments)
+            .parse_solos(permit_solos)
+            .memory_resource(&arena)
+            .parse(chart_data);
+    }
+    return SightRead::MidiParser(job.metadata)
+        .hopo_threshold(job.hopo_threshold)
+        .permit_instruments(instruments)
+        .parse_solos(permit_solos)
+        .memory_resource(&arena)
+        .parse(job.data);
+}
+}
+
+SightRead::BatchParser::BatchParser()
+    : m_permitted_instruments {SightRead::all_instruments()}
+    , m_permit_solos {true}
+    , m_thread_count {std::max(std::thread::hardware_concurrency(), 1U)}
+{
+}
+
+SightRead::BatchParser& SightRead::BatchParser::permit_instruments(
+    std::set<SightRead::Instrument> permitted_instruments)
+{
+    m_permitted_instruments = std::move(permitted_instruments);
+    return *this;
+}
+
+SightRead::BatchParser& SightRead::BatchParser::parse_solos(bool permit_solos)
+{
+    m_permit_solos = permit_solos;
+    return *this;
+}
+
+SightRead::BatchParser&
+SightRead::BatchParser::threads(unsigned int thread_count)
+{
+    m_thread_count = thread_count;
+    return *this;
+}
+
+std::vector<SightRead::ParseResult>
+SightRead::BatchParser::parse(std::span<const SightRead::ParseJob> jobs) const
+{
+    return SightRead::Detail::parallel_map(
+        jobs.size(), m_thread_count,
+        [&](std::size_t i) -> SightRead::ParseResult {
+            try {
+                return parse_job(jobs[i], m_permitted_instruments,
+                                 m_permit_solos);
+            } catch (const SightRead::ParseError& error) {
+                return error;
+            }
+        });
+}
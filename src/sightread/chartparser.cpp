@@ -3,6 +3,9 @@
 #include "sightread/chartparser.hpp"
 #include "sightread/detail/chart.hpp"
 #include "sightread/detail/chartconverter.hpp"
+#include "sightread/detail/mappedfile.hpp"
+#include "sightread/detail/phasetimer.hpp"
+#include "sightread/detail/textencoding.hpp"
 
 SightRead::ChartParser::ChartParser(SightRead::Metadata metadata)
     : m_metadata {std::move(metadata)}
@@ -10,6 +13,8 @@ SightRead::ChartParser::ChartParser(SightRead::Metadata metadata)
                         SightRead::Tick {0}}
     , m_permitted_instruments {SightRead::all_instruments()}
     , m_permit_solos {true}
+    , m_thread_count {1}
+    , m_resource {std::pmr::get_default_resource()}
 {
 }
 
@@ -33,13 +38,99 @@ SightRead::ChartParser& SightRead::ChartParser::parse_solos(bool permit_solos)
     return *this;
 }
 
-SightRead::Song SightRead::ChartParser::parse(std::string_view data) const
+SightRead::ChartParser&
+SightRead::ChartParser::threads(unsigned int thread_count)
+{
+    m_thread_count = thread_count;
+    return *this;
+}
+
+SightRead::ChartParser&
+SightRead::ChartParser::memory_resource(std::pmr::memory_resource* resource)
+{
+    m_resource = resource;
+    return *this;
+}
+
+SightRead::Song
+SightRead::ChartParser::parse_with_stats(std::string_view data,
+                                         SightRead::ParseStats* stats) const
 {
-    const auto chart = SightRead::Detail::parse_chart(data);
+    const SightRead::Detail::PhaseTimer timer {
+        SightRead::Detail::phase_sink(stats, &SightRead::ParseStats::total)};
+    if (stats != nullptr) {
+        stats->input_bytes += data.size();
+    }
+
+    // The chart's tokens borrow from the transcoded text, so it must live
+    // until the conversion is done.
+    std::pmr::string utf8_buffer {m_resource};
+    const auto chart = [&] {
+        const SightRead::Detail::PhaseTimer tokenize_timer {
+            SightRead::Detail::phase_sink(stats,
+                                          &SightRead::ParseStats::tokenize)};
+        return SightRead::Detail::parse_chart(
+            SightRead::Detail::to_utf8(data, utf8_buffer),
+            m_permitted_instruments, m_resource);
+    }();
 
     const auto converter = SightRead::Detail::ChartConverter(m_metadata)
                                .hopo_threshold(m_hopo_threshold)
                                .permit_instruments(m_permitted_instruments)
-                               .parse_solos(m_permit_solos);
-    return converter.convert(chart);
+                               .parse_solos(m_permit_solos)
+                               .threads(m_thread_count);
+    return converter.convert(chart, stats);
+}
+
+SightRead::Song SightRead::ChartParser::parse(std::string_view data) const
+{
+    return parse_with_stats(data, nullptr);
+}
+
+SightRead::Song
+SightRead::ChartParser::parse(std::string_view data,
+                              SightRead::ParseStats& stats) const
+{
+    return parse_with_stats(data, &stats);
+}
+
+SightRead::ParseResult
+SightRead::ChartParser::try_parse(std::string_view data) const
+{
+    try {
+        return parse(data);
+    } catch (const SightRead::ParseError& error) {
+        return error;
+    }
+}
+
+SightRead::Song
+SightRead::ChartParser::parse_file(const std::filesystem::path& path) const
+{
+    const SightRead::Detail::MappedFile file {path};
+    const auto data = file.data();
+    return parse({reinterpret_cast<const char*>(data.data()), // NOLINT
+                  data.size()});
+}
+
+SightRead::SongSummary
+SightRead::ChartParser::probe(std::string_view data) const
+{
+    std::pmr::string utf8_buffer {m_resource};
+    const auto chart = SightRead::Detail::parse_chart(
+        SightRead::Detail::to_utf8(data, utf8_buffer), m_permitted_instruments,
+        m_resource);
+
+    return SightRead::Detail::ChartConverter(m_metadata)
+        .permit_instruments(m_permitted_instruments)
+        .summarise(chart);
+}
+
+SightRead::SongSummary
+SightRead::ChartParser::probe_file(const std::filesystem::path& path) const
+{
+    const SightRead::Detail::MappedFile file {path};
+    const auto data = file.data();
+    return probe({reinterpret_cast<const char*>(data.data()), // NOLINT
+                  data.size()});
 }
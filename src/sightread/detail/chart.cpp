@@ -1,41 +1,46 @@
+#include <algorithm>
+#include <array>
 #include <charconv>
+#include <memory_resource>
 #include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
 
 #include "sightread/detail/chart.hpp"
 #include "sightread/songparts.hpp"
 
 namespace {
-std::string_view skip_whitespace(std::string_view input)
+// The same characters as std::isspace in the C locale, without the locale
+// lookup or find_first_not_of's search of a set for each character.
+bool is_whitespace(char c)
 {
-    const auto first_non_ws_location = input.find_first_not_of(" \f\n\r\t\v");
-    input.remove_prefix(std::min(first_non_ws_location, input.size()));
-    return input;
+    return c == ' ' || (c >= '\t' && c <= '\r');
 }
 
-std::string_view break_off_newline(std::string_view& input)
+std::string_view skip_whitespace(std::string_view input)
 {
-    if (input.empty()) {
-        throw SightRead::ParseError("No lines left");
-    }
-
-    const auto newline_location
-        = std::min(input.find('\n'), input.find("\r\n"));
-    if (newline_location == std::string_view::npos) {
-        const auto line = input;
-        input.remove_prefix(input.size());
-        return line;
+    std::size_t i = 0;
+    while (i < input.size() && is_whitespace(input[i])) {
+        ++i;
     }
+    input.remove_prefix(i);
+    return input;
+}
 
-    const auto line = input.substr(0, newline_location);
-    input.remove_prefix(newline_location);
-    input = skip_whitespace(input);
-    return line;
+// Errors are thrown with the offset of the line they are on, so that no
+// caller needs to catch and rethrow them to add it.
+[[noreturn]] void throw_line_error(const char* what, std::size_t line_start)
+{
+    throw SightRead::ParseError(what, SightRead::ParseErrorCode::MalformedData,
+                                line_start);
 }
 
-std::string_view strip_square_brackets(std::string_view input)
+std::string_view strip_square_brackets(std::string_view input,
+                                       std::size_t line_start)
 {
     if (input.empty()) {
-        throw SightRead::ParseError("Header string empty");
+        throw_line_error("Header string empty", line_start);
     }
     return input.substr(1, input.size() - 2);
 }
@@ -53,170 +58,448 @@ std::optional<int> string_view_to_int(std::string_view input)
     return result;
 }
 
-// Split input by space characters, similar to .Split(' ') in C#. Note that
-// the lifetime of the string_views in the output is the same as that of the
-// input.
-std::vector<std::string_view> split_by_space(std::string_view input)
-{
-    std::vector<std::string_view> substrings;
+// Reads the tokens of a line in place, splitting by space characters similar
+// to .Split(' ') in C#. Note that the lifetime of the string_views returned is
+// the same as that of the line.
+class LineTokenizer {
+private:
+    std::string_view m_rest;
+    std::size_t m_line_start;
+    bool m_is_exhausted {false};
 
-    while (true) {
-        const auto space_location = input.find(' ');
-        if (space_location == std::string_view::npos) {
-            break;
+public:
+    LineTokenizer(std::string_view line, std::size_t line_start)
+        : m_rest {line}
+        , m_line_start {line_start}
+    {
+    }
+
+    // The offset of the line in the whole input, for errors.
+    [[nodiscard]] std::size_t line_start() const { return m_line_start; }
+
+    // Returns std::nullopt once every token has been read.
+    std::optional<std::string_view> next()
+    {
+        if (m_is_exhausted) {
+            return std::nullopt;
+        }
+        // Tokens are a few bytes long, so a plain loop beats the call to
+        // memchr that find makes.
+        const auto space_location = static_cast<std::size_t>(
+            std::find(m_rest.cbegin(), m_rest.cend(), ' ') - m_rest.cbegin());
+        if (space_location == m_rest.size()) {
+            m_is_exhausted = true;
+            return m_rest;
         }
-        substrings.push_back(input.substr(0, space_location));
-        input.remove_prefix(space_location + 1);
+        const auto token = m_rest.substr(0, space_location);
+        m_rest.remove_prefix(space_location + 1);
+        return token;
     }
 
-    substrings.push_back(input);
-    return substrings;
-}
+    // The unread remainder of the line, or std::nullopt if there are no tokens
+    // left.
+    [[nodiscard]] std::optional<std::string_view> rest() const
+    {
+        if (m_is_exhausted) {
+            return std::nullopt;
+        }
+        return m_rest;
+    }
+};
 
-SightRead::Detail::NoteEvent
-convert_line_to_note(int position,
-                     const std::vector<std::string_view>& split_line)
+std::string_view next_token(LineTokenizer& tokenizer)
 {
-    constexpr int MAX_NORMAL_EVENT_SIZE = 5;
-
-    if (split_line.size() < MAX_NORMAL_EVENT_SIZE) {
-        throw SightRead::ParseError("Line incomplete");
+    const auto token = tokenizer.next();
+    if (!token.has_value()) {
+        throw_line_error("Line incomplete", tokenizer.line_start());
     }
-    const auto fret = string_view_to_int(split_line[3]);
-    const auto length = string_view_to_int(split_line[4]);
-    if (!fret.has_value() || !length.has_value()) {
-        throw SightRead::ParseError("Bad note event");
+    return *token;
+}
+
+// Reads an int field, throwing a ParseError with the given message if it is
+// malformed.
+int next_int_field(LineTokenizer& tokenizer, const char* error_message)
+{
+    const auto value = string_view_to_int(next_token(tokenizer));
+    if (!value.has_value()) {
+        throw_line_error(error_message, tokenizer.line_start());
     }
-    return {position, *fret, *length};
+    return *value;
 }
 
-SightRead::Detail::SpecialEvent
-convert_line_to_special(int position,
-                        const std::vector<std::string_view>& split_line)
+// Reads the two int fields of a line, checking both are present before either
+// is parsed.
+std::tuple<int, int> next_two_int_fields(LineTokenizer& tokenizer,
+                                         const char* error_message)
 {
-    constexpr int MAX_NORMAL_EVENT_SIZE = 5;
+    const auto first = string_view_to_int(next_token(tokenizer));
+    const auto second = string_view_to_int(next_token(tokenizer));
+    if (!first.has_value() || !second.has_value()) {
+        throw_line_error(error_message, tokenizer.line_start());
+    }
+    return {*first, *second};
+}
 
-    if (split_line.size() < MAX_NORMAL_EVENT_SIZE) {
-        throw SightRead::ParseError("Line incomplete");
+SightRead::Detail::TimeSigEvent
+convert_line_to_timesig(int position, LineTokenizer& tokenizer)
+{
+    const auto numer = string_view_to_int(next_token(tokenizer));
+    std::optional<int> denom = 2;
+    const auto denom_token = tokenizer.next();
+    if (denom_token.has_value()) {
+        denom = string_view_to_int(*denom_token);
+    }
+    if (!numer.has_value() || !denom.has_value()) {
+        throw_line_error("Bad TS event", tokenizer.line_start());
     }
-    const auto sp_key = string_view_to_int(split_line[3]);
-    const auto length = string_view_to_int(split_line[4]);
-    if (!sp_key.has_value() || !length.has_value()) {
-        throw SightRead::ParseError("Bad SP event");
+    return {position, *numer, *denom};
+}
+
+SightRead::Detail::Event convert_line_to_event(int position,
+                                               const LineTokenizer& tokenizer)
+{
+    const auto data = tokenizer.rest();
+    if (!data.has_value()) {
+        throw_line_error("Line incomplete", tokenizer.line_start());
     }
-    return {position, *sp_key, *length};
+    return {position, *data};
 }
 
-SightRead::Detail::BpmEvent
-convert_line_to_bpm(int position,
-                    const std::vector<std::string_view>& split_line)
+// Returns true if the section is one parse_chart should tokenize, i.e., it is
+// not an instrument track for an instrument outside permitted_instruments.
+bool is_section_wanted(
+    std::string_view name,
+    const std::set<SightRead::Instrument>* permitted_instruments)
 {
-    if (split_line.size() < 4) {
-        throw SightRead::ParseError("Line incomplete");
+    if (permitted_instruments == nullptr) {
+        return true;
     }
-    const auto bpm = string_view_to_int(split_line[3]);
-    if (!bpm.has_value()) {
-        throw SightRead::ParseError("Bad BPM event");
+    const auto diff_inst = SightRead::Detail::diff_inst_from_header(name);
+    if (!diff_inst.has_value()) {
+        return true;
     }
-    return {position, *bpm};
+    return permitted_instruments->contains(std::get<1>(*diff_inst));
 }
 
-SightRead::Detail::TimeSigEvent
-convert_line_to_timesig(int position,
-                        const std::vector<std::string_view>& split_line)
+// ChartSection is not allocator-aware, so each of its members is given the
+// resource explicitly.
+SightRead::Detail::ChartSection
+empty_section(std::string_view name, std::pmr::memory_resource* resource)
 {
-    constexpr int MAX_NORMAL_EVENT_SIZE = 5;
+    return {std::pmr::string {name, resource},
+            std::pmr::map<std::pmr::string, std::pmr::string> {resource},
+            std::pmr::vector<SightRead::Detail::BpmEvent> {resource},
+            std::pmr::vector<SightRead::Detail::Event> {resource},
+            std::pmr::vector<SightRead::Detail::NoteEvent> {resource},
+            std::pmr::vector<SightRead::Detail::SpecialEvent> {resource},
+            std::pmr::vector<SightRead::Detail::TimeSigEvent> {resource}};
+}
+
+class ChartBuilder : public SightRead::ChartVisitor {
+private:
+    SightRead::Detail::Chart m_chart;
+    const std::set<SightRead::Instrument>* m_permitted_instruments;
+    std::pmr::memory_resource* m_resource;
 
-    if (split_line.size() < 4) {
-        throw SightRead::ParseError("Line incomplete");
+    SightRead::Detail::ChartSection& section()
+    {
+        return m_chart.sections.back();
     }
-    const auto numer = string_view_to_int(split_line[3]);
-    std::optional<int> denom = 2;
-    if (split_line.size() >= MAX_NORMAL_EVENT_SIZE) {
-        denom = string_view_to_int(split_line[4]);
+
+public:
+    ChartBuilder(const std::set<SightRead::Instrument>* permitted_instruments,
+                 std::pmr::memory_resource* resource)
+        : m_chart {std::pmr::vector<SightRead::Detail::ChartSection> {
+            resource}}
+        , m_permitted_instruments {permitted_instruments}
+        , m_resource {resource}
+    {
     }
-    if (!numer.has_value() || !denom.has_value()) {
-        throw SightRead::ParseError("Bad TS event");
+
+    bool section_start(std::string_view name) override
+    {
+        if (!is_section_wanted(name, m_permitted_instruments)) {
+            return false;
+        }
+        m_chart.sections.push_back(empty_section(name, m_resource));
+        return true;
     }
-    return {position, *numer, *denom};
+
+    void key_value(std::string_view key, std::string_view value) override
+    {
+        section().key_value_pairs[std::pmr::string {key, m_resource}] = value;
+    }
+
+    void bpm(const SightRead::Detail::BpmEvent& event) override
+    {
+        section().bpm_events.push_back(event);
+    }
+
+    void event(const SightRead::Detail::Event& event) override
+    {
+        section().events.push_back(event);
+    }
+
+    void note(const SightRead::Detail::NoteEvent& event) override
+    {
+        section().note_events.push_back(event);
+    }
+
+    void special(const SightRead::Detail::SpecialEvent& event) override
+    {
+        section().special_events.push_back(event);
+    }
+
+    void time_sig(const SightRead::Detail::TimeSigEvent& event) override
+    {
+        section().ts_events.push_back(event);
+    }
+
+    SightRead::Detail::Chart take() && { return std::move(m_chart); }
+};
+
+SightRead::Detail::Chart parse_chart_sections(
+    std::string_view data,
+    const std::set<SightRead::Instrument>* permitted_instruments,
+    std::pmr::memory_resource* resource)
+{
+    ChartBuilder builder {permitted_instruments, resource};
+    SightRead::ChartStreamParser parser {builder, resource};
+    // Giving all the data as one chunk means every Event's data borrows from
+    // data itself.
+    parser.finish(data);
+    return std::move(builder).take();
+}
 }
 
-SightRead::Detail::Event
-convert_line_to_event(int position,
-                      const std::vector<std::string_view>& split_line)
+std::optional<std::tuple<SightRead::Difficulty, SightRead::Instrument>>
+SightRead::Detail::diff_inst_from_header(std::string_view header)
 {
-    if (split_line.size() < 4) {
-        throw SightRead::ParseError("Line incomplete");
+    using namespace std::literals;
+
+    constexpr std::array<std::tuple<std::string_view, SightRead::Difficulty>, 4>
+        DIFFICULTIES {std::tuple {"Easy"sv, SightRead::Difficulty::Easy},
+                      {"Medium"sv, SightRead::Difficulty::Medium},
+                      {"Hard"sv, SightRead::Difficulty::Hard},
+                      {"Expert"sv, SightRead::Difficulty::Expert}};
+    constexpr std::array<std::tuple<std::string_view, SightRead::Instrument>,
+                         10>
+        INSTRUMENTS {std::tuple {"Single"sv, SightRead::Instrument::Guitar},
+                     {"DoubleGuitar"sv, SightRead::Instrument::GuitarCoop},
+                     {"DoubleBass"sv, SightRead::Instrument::Bass},
+                     {"DoubleRhythm"sv, SightRead::Instrument::Rhythm},
+                     {"Keyboard"sv, SightRead::Instrument::Keys},
+                     {"GHLGuitar"sv, SightRead::Instrument::GHLGuitar},
+                     {"GHLBass"sv, SightRead::Instrument::GHLBass},
+                     {"GHLRhythm"sv, SightRead::Instrument::GHLRhythm},
+                     {"GHLCoop"sv, SightRead::Instrument::GHLGuitarCoop},
+                     {"Drums"sv, SightRead::Instrument::Drums}};
+    // NOLINT is required because following clang-tidy here causes the
+    // VS2017 compile to fail.
+    auto diff_iter = std::find_if( // NOLINT
+        DIFFICULTIES.cbegin(), DIFFICULTIES.cend(), [&](const auto& pair) {
+            return header.starts_with(std::get<0>(pair));
+        });
+    if (diff_iter == DIFFICULTIES.cend()) {
+        return std::nullopt;
+    }
+    auto inst_iter = std::find_if( // NOLINT
+        INSTRUMENTS.cbegin(), INSTRUMENTS.cend(),
+        [&](const auto& pair) { return header.ends_with(std::get<0>(pair)); });
+    if (inst_iter == INSTRUMENTS.cend()) {
+        return std::nullopt;
     }
-    SightRead::Detail::Event event;
-    event.position = position;
-    for (auto i = 3U; i < split_line.size(); ++i) {
-        event.data += split_line[i];
-        if (i + 1 != split_line.size()) {
-            event.data += ' ';
+    return std::tuple {std::get<1>(*diff_iter), std::get<1>(*inst_iter)};
+}
+
+SightRead::Detail::Chart
+SightRead::Detail::parse_chart(std::string_view data,
+                               std::pmr::memory_resource* resource)
+{
+    return parse_chart_sections(data, nullptr, resource);
+}
+
+SightRead::Detail::Chart SightRead::Detail::parse_chart(
+    std::string_view data,
+    const std::set<SightRead::Instrument>& permitted_instruments,
+    std::pmr::memory_resource* resource)
+{
+    return parse_chart_sections(data, &permitted_instruments, resource);
+}
+
+std::vector<std::string_view>
+SightRead::Detail::split_chart_sections(std::string_view data)
+{
+    enum class State { Header, Open, Body };
+
+    std::vector<std::string_view> sections;
+    auto state = State::Header;
+    std::size_t section_start = 0;
+    std::size_t position = 0;
+    bool is_after_newline = false;
+    while (position < data.size()) {
+        if (is_after_newline) {
+            const auto rest = skip_whitespace(data.substr(position));
+            position = data.size() - rest.size();
+            if (position == data.size()) {
+                break;
+            }
+        }
+        const auto line_start = position;
+        const auto newline_location = data.find('\n', position);
+        auto line = data.substr(line_start, newline_location - line_start);
+        position = line_start + line.size();
+        is_after_newline = true;
+        if (line.ends_with('\r')) {
+            line.remove_suffix(1);
+        }
+        switch (state) {
+        case State::Header:
+            section_start = line_start;
+            state = State::Open;
+            break;
+        case State::Open:
+            state = State::Body;
+            break;
+        case State::Body:
+            if (line == "}") {
+                sections.push_back(data.substr(
+                    section_start, line_start + line.size() - section_start));
+                state = State::Header;
+            }
+            break;
         }
     }
-    return event;
+    if (state != State::Header) {
+        sections.push_back(data.substr(section_start));
+    }
+    return sections;
 }
 
-SightRead::Detail::ChartSection read_section(std::string_view& input)
+void SightRead::ChartStreamParser::feed(std::string_view chunk)
 {
-    SightRead::Detail::ChartSection section;
-    section.name = strip_square_brackets(break_off_newline(input));
+    read_chunk(chunk, false);
+}
 
-    if (break_off_newline(input) != "{") {
-        throw SightRead::ParseError("Section does not open with {");
+void SightRead::ChartStreamParser::finish(std::string_view last_chunk)
+{
+    read_chunk(last_chunk, true);
+    if (!m_partial_line.empty()) {
+        const auto line = std::move(m_partial_line);
+        m_partial_line.clear();
+        read_line(line);
     }
+    if (m_state != State::Header) {
+        throw_line_error("No lines left", m_position);
+    }
+}
 
-    while (true) {
-        const auto next_line = break_off_newline(input);
-        if (next_line == "}") {
-            break;
+// Lines end at a \n or \r\n, and any whitespace after a line break (so
+// leading whitespace and blank lines) is skipped, even across chunks.
+void SightRead::ChartStreamParser::read_chunk(std::string_view chunk,
+                                              bool is_last_chunk)
+{
+    while (!chunk.empty()) {
+        if (m_is_skipping_whitespace) {
+            const auto rest = skip_whitespace(chunk);
+            m_position += chunk.size() - rest.size();
+            chunk = rest;
+            if (chunk.empty()) {
+                return;
+            }
+            m_is_skipping_whitespace = false;
+            m_line_start = m_position;
         }
-        const auto separated_line = split_by_space(next_line);
-        if (separated_line.size() < 3) {
-            throw SightRead::ParseError("Line incomplete");
+        const auto newline_location = chunk.find('\n');
+        if (newline_location == std::string_view::npos) {
+            m_position += chunk.size();
+            if (is_last_chunk && m_partial_line.empty()) {
+                read_line(chunk);
+            } else {
+                m_partial_line.append(chunk);
+            }
+            return;
         }
-        const auto key = separated_line[0];
-        const auto key_val = string_view_to_int(key);
-        if (key_val.has_value()) {
-            const auto pos = *key_val;
-            if (separated_line[2] == "N") {
-                section.note_events.push_back(
-                    convert_line_to_note(pos, separated_line));
-            } else if (separated_line[2] == "S") {
-                section.special_events.push_back(
-                    convert_line_to_special(pos, separated_line));
-            } else if (separated_line[2] == "B") {
-                section.bpm_events.push_back(
-                    convert_line_to_bpm(pos, separated_line));
-            } else if (separated_line[2] == "TS") {
-                section.ts_events.push_back(
-                    convert_line_to_timesig(pos, separated_line));
-            } else if (separated_line[2] == "E") {
-                section.events.push_back(
-                    convert_line_to_event(pos, separated_line));
+        m_is_skipping_whitespace = true;
+        m_position += newline_location;
+        if (m_partial_line.empty()) {
+            auto line = chunk.substr(0, newline_location);
+            if (line.ends_with('\r')) {
+                line.remove_suffix(1);
             }
+            chunk.remove_prefix(newline_location);
+            read_line(line);
         } else {
-            std::string value {separated_line[2]};
-            for (auto i = 3U; i < separated_line.size(); ++i) {
-                value.append(separated_line[i]);
+            m_partial_line.append(chunk.substr(0, newline_location));
+            chunk.remove_prefix(newline_location);
+            if (m_partial_line.ends_with('\r')) {
+                m_partial_line.pop_back();
             }
-            section.key_value_pairs[std::string(key)] = value;
+            const auto line = std::move(m_partial_line);
+            m_partial_line.clear();
+            read_line(line);
         }
     }
-
-    return section;
-}
 }
 
-SightRead::Detail::Chart SightRead::Detail::parse_chart(std::string_view data)
+void SightRead::ChartStreamParser::read_line(std::string_view line)
 {
-    SightRead::Detail::Chart chart;
+    switch (m_state) {
+    case State::Header:
+        m_section_name = strip_square_brackets(line, m_line_start);
+        m_state = State::Open;
+        return;
+    case State::Open:
+        if (line != "{") {
+            throw_line_error("Section does not open with {", m_line_start);
+        }
+        m_state = m_visitor->section_start(m_section_name)
+            ? State::Body
+            : State::SkippedBody;
+        return;
+    case State::SkippedBody:
+        if (line == "}") {
+            m_state = State::Header;
+        }
+        return;
+    case State::Body:
+        if (line == "}") {
+            m_state = State::Header;
+            m_visitor->section_end();
+            return;
+        }
+        break;
+    }
 
-    while (!data.empty()) {
-        chart.sections.push_back(read_section(data));
+    LineTokenizer tokenizer {line, m_line_start};
+    const auto key = next_token(tokenizer);
+    next_token(tokenizer);
+    const auto type = next_token(tokenizer);
+
+    const auto key_val = string_view_to_int(key);
+    if (!key_val.has_value()) {
+        std::string value {type};
+        while (const auto token = tokenizer.next()) {
+            value.append(*token);
+        }
+        m_visitor->key_value(key, value);
+        return;
     }
 
-    return chart;
+    const auto pos = *key_val;
+    if (type == "N") {
+        const auto [fret, length]
+            = next_two_int_fields(tokenizer, "Bad note event");
+        m_visitor->note({pos, fret, length});
+    } else if (type == "S") {
+        const auto [sp_key, length]
+            = next_two_int_fields(tokenizer, "Bad SP event");
+        m_visitor->special({pos, sp_key, length});
+    } else if (type == "B") {
+        m_visitor->bpm({pos, next_int_field(tokenizer, "Bad BPM event")});
+    } else if (type == "TS") {
+        m_visitor->time_sig(convert_line_to_timesig(pos, tokenizer));
+    } else if (type == "E") {
+        m_visitor->event(convert_line_to_event(pos, tokenizer));
+    }
 }
@@ -2,54 +2,61 @@
 #define SIGHTREAD_DETAIL_CHART_HPP
 
 #include <map>
+#include <memory_resource>
+#include <optional>
+#include <set>
 #include <string>
 #include <string_view>
+#include <tuple>
 #include <vector>
 
-namespace SightRead::Detail {
-struct BpmEvent {
-    int position;
-    int bpm;
-};
-
-struct Event {
-    int position;
-    std::string data;
-};
-
-struct NoteEvent {
-    int position;
-    int fret;
-    int length;
-};
-
-struct SpecialEvent {
-    int position;
-    int key;
-    int length;
-};
-
-struct TimeSigEvent {
-    int position;
-    int numerator;
-    int denominator;
-};
+#include "sightread/chartstreamparser.hpp"
+#include "sightread/songparts.hpp"
 
+namespace SightRead::Detail {
+// The event types are shared with the public ChartStreamParser.
+using SightRead::BpmEvent;
+using SightRead::Event;
+using SightRead::NoteEvent;
+using SightRead::SpecialEvent;
+using SightRead::TimeSigEvent;
+
+// Everything in a Chart is allocated from the memory resource given to
+// parse_chart.
 struct ChartSection {
-    std::string name;
-    std::map<std::string, std::string> key_value_pairs;
-    std::vector<BpmEvent> bpm_events;
-    std::vector<Event> events;
-    std::vector<NoteEvent> note_events;
-    std::vector<SpecialEvent> special_events;
-    std::vector<TimeSigEvent> ts_events;
+    std::pmr::string name;
+    std::pmr::map<std::pmr::string, std::pmr::string> key_value_pairs;
+    std::pmr::vector<BpmEvent> bpm_events;
+    std::pmr::vector<Event> events;
+    std::pmr::vector<NoteEvent> note_events;
+    std::pmr::vector<SpecialEvent> special_events;
+    std::pmr::vector<TimeSigEvent> ts_events;
 };
 
 struct Chart {
-    std::vector<ChartSection> sections;
+    std::pmr::vector<ChartSection> sections;
 };
 
-Chart parse_chart(std::string_view data);
+Chart parse_chart(
+    std::string_view data,
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+// As above, but the bodies of instrument sections for instruments not in
+// permitted_instruments are skipped over without being read, and the sections
+// are left out of the result.
+Chart parse_chart(
+    std::string_view data,
+    const std::set<SightRead::Instrument>& permitted_instruments,
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+// Splits data into the text of each section, from its header line to its
+// closing brace, following the same line rules as ChartStreamParser without
+// tokenizing anything. Parsing each piece with parse_chart gives the same
+// sections as parsing all of data. Any unfinished section at the end is
+// returned as is, so parsing it throws.
+std::vector<std::string_view> split_chart_sections(std::string_view data);
+
+std::optional<std::tuple<SightRead::Difficulty, SightRead::Instrument>>
+diff_inst_from_header(std::string_view header);
 }
 
 #endif
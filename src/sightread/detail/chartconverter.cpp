@@ -1,22 +1,54 @@
 #include <algorithm>
+#include <array>
+#include <charconv>
 #include <climits>
+#include <cstddef>
 #include <map>
+#include <memory_resource>
 #include <optional>
+#include <span>
 #include <tuple>
 #include <utility>
 
 #include "sightread/detail/chartconverter.hpp"
+#include "sightread/detail/parallel.hpp"
 #include "sightread/detail/parserutil.hpp"
+#include "sightread/detail/phasetimer.hpp"
+#include "sightread/detail/synchronisedresource.hpp"
 
 namespace {
-std::string get_with_default(const std::map<std::string, std::string>& map,
-                             const std::string& key, std::string default_value)
+// Reads the Resolution key of a Song section, or 192 if there is none. As with
+// std::stoi, leading whitespace and a sign are allowed and anything after the
+// number is ignored. Returns std::nullopt if there is no number or it is out
+// of range, which CH just ignores.
+std::optional<int>
+resolution_from_section(const SightRead::Detail::ChartSection& section)
 {
-    const auto iter = map.find(key);
-    if (iter == map.end()) {
-        return default_value;
+    constexpr int DEFAULT_RESOLUTION = 192;
+
+    const auto iter = section.key_value_pairs.find("Resolution");
+    if (iter == section.key_value_pairs.end()) {
+        return DEFAULT_RESOLUTION;
+    }
+    std::string_view value {iter->second};
+    while (!value.empty()
+           && (value.front() == ' '
+               || (value.front() >= '\t' && value.front() <= '\r'))) {
+        value.remove_prefix(1);
+    }
+    if (value.starts_with('+')) {
+        value.remove_prefix(1);
+        if (value.starts_with('-')) {
+            return std::nullopt;
+        }
+    }
+    int resolution = 0;
+    if (std::from_chars(value.data(), value.data() + value.size(), resolution)
+            .ec
+        != std::errc()) {
+        return std::nullopt;
     }
-    return iter->second;
+    return resolution;
 }
 
 SightRead::TempoMap
@@ -67,126 +99,119 @@ practice_sections_from_section(const SightRead::Detail::ChartSection& section)
     return practice_sections;
 }
 
-std::optional<std::tuple<SightRead::Difficulty, SightRead::Instrument>>
-diff_inst_from_header(const std::string& header)
+// What an N event's fret number means on a track: the lane it is a note on and
+// the note's flags, or a colour of -1 if it is not a note.
+struct FretDecoding {
+    int colour {-1};
+    SightRead::NoteFlags flags {SightRead::FLAGS_NONE};
+};
+
+constexpr std::size_t FRET_TABLE_SIZE = 128;
+
+using FretTable = std::array<FretDecoding, FRET_TABLE_SIZE>;
+
+template <SightRead::TrackType TrackType> constexpr FretTable make_fret_table()
 {
-    using namespace std::literals;
-
-    constexpr std::array<std::tuple<std::string_view, SightRead::Difficulty>, 4>
-        DIFFICULTIES {std::tuple {"Easy"sv, SightRead::Difficulty::Easy},
-                      {"Medium"sv, SightRead::Difficulty::Medium},
-                      {"Hard"sv, SightRead::Difficulty::Hard},
-                      {"Expert"sv, SightRead::Difficulty::Expert}};
-    constexpr std::array<std::tuple<std::string_view, SightRead::Instrument>,
-                         10>
-        INSTRUMENTS {std::tuple {"Single"sv, SightRead::Instrument::Guitar},
-                     {"DoubleGuitar"sv, SightRead::Instrument::GuitarCoop},
-                     {"DoubleBass"sv, SightRead::Instrument::Bass},
-                     {"DoubleRhythm"sv, SightRead::Instrument::Rhythm},
-                     {"Keyboard"sv, SightRead::Instrument::Keys},
-                     {"GHLGuitar"sv, SightRead::Instrument::GHLGuitar},
-                     {"GHLBass"sv, SightRead::Instrument::GHLBass},
-                     {"GHLRhythm"sv, SightRead::Instrument::GHLRhythm},
-                     {"GHLCoop"sv, SightRead::Instrument::GHLGuitarCoop},
-                     {"Drums"sv, SightRead::Instrument::Drums}};
-    // NOLINT is required because following clang-tidy here causes the
-    // VS2017 compile to fail.
-    auto diff_iter = std::find_if( // NOLINT
-        DIFFICULTIES.cbegin(), DIFFICULTIES.cend(), [&](const auto& pair) {
-            return header.starts_with(std::get<0>(pair));
-        });
-    if (diff_iter == DIFFICULTIES.cend()) {
-        return std::nullopt;
-    }
-    auto inst_iter = std::find_if( // NOLINT
-        INSTRUMENTS.cbegin(), INSTRUMENTS.cend(),
-        [&](const auto& pair) { return header.ends_with(std::get<0>(pair)); });
-    if (inst_iter == INSTRUMENTS.cend()) {
-        return std::nullopt;
-    }
-    return std::tuple {std::get<1>(*diff_iter), std::get<1>(*inst_iter)};
+    constexpr int CYMBAL_THRESHOLD = 64;
+
+    FretTable table {};
+    const auto add_fret = [&](int fret, int colour) {
+        auto flags = SightRead::FLAGS_DRUMS;
+        if constexpr (TrackType == SightRead::TrackType::FiveFret) {
+            flags = SightRead::FLAGS_FIVE_FRET_GUITAR;
+        } else if constexpr (TrackType == SightRead::TrackType::SixFret) {
+            flags = SightRead::FLAGS_SIX_FRET_GUITAR;
+        } else if (fret >= CYMBAL_THRESHOLD) {
+            flags = static_cast<SightRead::NoteFlags>(
+                flags | SightRead::FLAGS_CYMBAL);
+        }
+        table.at(static_cast<std::size_t>(fret)) = {colour, flags};
+    };
+    if constexpr (TrackType == SightRead::TrackType::FiveFret) {
+        add_fret(0, SightRead::FIVE_FRET_GREEN);
+        add_fret(1, SightRead::FIVE_FRET_RED);
+        add_fret(2, SightRead::FIVE_FRET_YELLOW);
+        add_fret(3, SightRead::FIVE_FRET_BLUE);
+        add_fret(4, SightRead::FIVE_FRET_ORANGE);
+        add_fret(7, SightRead::FIVE_FRET_OPEN); // NOLINT
+    } else if constexpr (TrackType == SightRead::TrackType::SixFret) {
+        add_fret(0, SightRead::SIX_FRET_WHITE_LOW);
+        add_fret(1, SightRead::SIX_FRET_WHITE_MID);
+        add_fret(2, SightRead::SIX_FRET_WHITE_HIGH);
+        add_fret(3, SightRead::SIX_FRET_BLACK_LOW);
+        add_fret(4, SightRead::SIX_FRET_BLACK_MID);
+        add_fret(7, SightRead::SIX_FRET_OPEN); // NOLINT
+        add_fret(8, SightRead::SIX_FRET_BLACK_HIGH); // NOLINT
+    } else if constexpr (TrackType == SightRead::TrackType::Drums) {
+        add_fret(0, SightRead::DRUM_KICK);
+        add_fret(1, SightRead::DRUM_RED);
+        add_fret(2, SightRead::DRUM_YELLOW);
+        add_fret(3, SightRead::DRUM_BLUE);
+        add_fret(4, SightRead::DRUM_GREEN);
+        add_fret(32, SightRead::DRUM_DOUBLE_KICK); // NOLINT
+        add_fret(66, SightRead::DRUM_YELLOW); // NOLINT
+        add_fret(67, SightRead::DRUM_BLUE); // NOLINT
+        add_fret(68, SightRead::DRUM_GREEN); // NOLINT
+    }
+    return table;
 }
 
-std::optional<SightRead::Note>
-note_from_colour_key_map(const std::map<int, int>& colour_map, int position,
-                         int length, int fret_type, SightRead::NoteFlags flags)
+template <SightRead::TrackType TrackType>
+constexpr FretTable FRET_TABLE = make_fret_table<TrackType>();
+
+const FretTable& fret_table(SightRead::TrackType track_type)
 {
-    const auto colour_iter = colour_map.find(fret_type);
-    if (colour_iter == colour_map.end()) {
-        return std::nullopt;
+    using SightRead::TrackType;
+
+    switch (track_type) {
+    case TrackType::FiveFret:
+        return FRET_TABLE<TrackType::FiveFret>;
+    case TrackType::SixFret:
+        return FRET_TABLE<TrackType::SixFret>;
+    case TrackType::Drums:
+        return FRET_TABLE<TrackType::Drums>;
+    case TrackType::FortniteFestival:
+        throw std::invalid_argument(
+            ".chart files not supported with Fortnite Festival");
     }
-    SightRead::Note note;
-    note.position = SightRead::Tick {position};
-    note.lengths.at(static_cast<unsigned int>(colour_iter->second))
-        = SightRead::Tick {length};
-    note.flags = flags;
-    return note;
+
+    throw std::invalid_argument("Invalid track type");
 }
 
 std::optional<SightRead::Note>
 note_from_note_colour(int position, int length, int fret_type,
                       SightRead::TrackType track_type)
 {
-    std::map<int, int> colours;
-    switch (track_type) {
-    case SightRead::TrackType::FiveFret:
-        colours = {{0, SightRead::FIVE_FRET_GREEN},
-                   {1, SightRead::FIVE_FRET_RED},
-                   {2, SightRead::FIVE_FRET_YELLOW},
-                   {3, SightRead::FIVE_FRET_BLUE},
-                   {4, SightRead::FIVE_FRET_ORANGE},
-                   {7, SightRead::FIVE_FRET_OPEN}}; // NOLINT
-        return note_from_colour_key_map(colours, position, length, fret_type,
-                                        SightRead::FLAGS_FIVE_FRET_GUITAR);
-    case SightRead::TrackType::SixFret:
-        colours = {{0, SightRead::SIX_FRET_WHITE_LOW},
-                   {1, SightRead::SIX_FRET_WHITE_MID},
-                   {2, SightRead::SIX_FRET_WHITE_HIGH},
-                   {3, SightRead::SIX_FRET_BLACK_LOW},
-                   {4, SightRead::SIX_FRET_BLACK_MID},
-                   {7, SightRead::SIX_FRET_OPEN}, // NOLINT
-                   {8, SightRead::SIX_FRET_BLACK_HIGH}}; // NOLINT
-        return note_from_colour_key_map(colours, position, length, fret_type,
-                                        SightRead::FLAGS_SIX_FRET_GUITAR);
-    case SightRead::TrackType::Drums: {
-        constexpr int CYMBAL_THRESHOLD = 64;
-        colours = {{0, SightRead::DRUM_KICK},
-                   {1, SightRead::DRUM_RED},
-                   {2, SightRead::DRUM_YELLOW},
-                   {3, SightRead::DRUM_BLUE},
-                   {4, SightRead::DRUM_GREEN},
-                   {32, SightRead::DRUM_DOUBLE_KICK}, // NOLINT
-                   {66, SightRead::DRUM_YELLOW}, // NOLINT
-                   {67, SightRead::DRUM_BLUE}, // NOLINT
-                   {68, SightRead::DRUM_GREEN}}; // NOLINT
-        auto note = note_from_colour_key_map(colours, position, length,
-                                             fret_type, SightRead::FLAGS_DRUMS);
-        if (note.has_value() && fret_type >= CYMBAL_THRESHOLD) {
-            note->flags = static_cast<SightRead::NoteFlags>(
-                note->flags | SightRead::FLAGS_CYMBAL);
-        }
-        return note;
+    const auto& table = fret_table(track_type);
+    if (fret_type < 0 || fret_type >= static_cast<int>(FRET_TABLE_SIZE)) {
+        return std::nullopt;
     }
-    case SightRead::TrackType::FortniteFestival:
-        throw std::invalid_argument(
-            ".chart files not supported with Fortnite Festival");
+    const auto& decoding = table[static_cast<std::size_t>(fret_type)];
+    if (decoding.colour == -1) {
+        return std::nullopt;
     }
-
-    throw std::invalid_argument("Invalid track type");
+    SightRead::Note note;
+    note.position = SightRead::Tick {position};
+    note.lengths.at(static_cast<unsigned int>(decoding.colour))
+        = SightRead::Tick {length};
+    note.flags = decoding.flags;
+    return note;
 }
 
 std::vector<SightRead::Note> add_fifth_lane_greens(
     std::vector<SightRead::Note> notes,
-    const std::vector<SightRead::Detail::NoteEvent>& note_events)
+    std::span<const SightRead::Detail::NoteEvent> note_events,
+    std::pmr::memory_resource* resource)
 {
     constexpr int FIVE_LANE_GREEN = 5;
 
-    std::set<SightRead::Tick> green_positions;
+    std::pmr::vector<SightRead::Tick> green_positions {resource};
     for (const auto& note : notes) {
         if (note.lengths[3] != SightRead::Tick {-1}) {
-            green_positions.insert(note.position);
+            green_positions.push_back(note.position);
         }
     }
+    std::sort(green_positions.begin(), green_positions.end());
     for (const auto& note_event : note_events) {
         if (note_event.fret != FIVE_LANE_GREEN) {
             continue;
@@ -194,7 +219,8 @@ std::vector<SightRead::Note> add_fifth_lane_greens(
         SightRead::Note note;
         note.position = SightRead::Tick {note_event.position};
         note.flags = SightRead::FLAGS_DRUMS;
-        if (green_positions.contains(SightRead::Tick {note_event.position})) {
+        if (std::binary_search(green_positions.cbegin(), green_positions.cend(),
+                               note.position)) {
             note.lengths[SightRead::DRUM_BLUE] = SightRead::Tick {0};
         } else {
             note.lengths[SightRead::DRUM_GREEN] = SightRead::Tick {0};
@@ -204,42 +230,59 @@ std::vector<SightRead::Note> add_fifth_lane_greens(
     return notes;
 }
 
+// A cymbal note replaces the other notes of the same colours at its position,
+// and is dropped itself if there are none. The notes are grouped by position
+// and colours with a sort of their indices, so each group is a run. In a group
+// with one cymbal only the cymbal is kept, unless it is alone; with two or
+// more cymbals each one replaces the others, so nothing is kept.
 std::vector<SightRead::Note>
-apply_cymbal_events(const std::vector<SightRead::Note>& notes)
+apply_cymbal_events(std::vector<SightRead::Note> notes,
+                    std::pmr::memory_resource* resource)
 {
-    std::set<unsigned int> deletion_spots;
+    const auto is_cymbal = [&](std::size_t i) {
+        return (notes[i].flags & SightRead::FLAGS_CYMBAL) != 0U;
+    };
+
+    std::pmr::vector<std::tuple<SightRead::Tick, int, std::size_t>> keys {
+        resource};
+    keys.reserve(notes.size());
     for (auto i = 0U; i < notes.size(); ++i) {
-        const auto& cymbal_note = notes[i];
-        if ((cymbal_note.flags & SightRead::FLAGS_CYMBAL) == 0U) {
-            continue;
+        keys.emplace_back(notes[i].position, notes[i].colours(), i);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    std::pmr::vector<bool> is_deleted(notes.size(), false, resource);
+    for (auto group_start = 0U; group_start < keys.size();) {
+        auto group_end = group_start + 1;
+        while (group_end < keys.size()
+               && std::get<0>(keys[group_end]) == std::get<0>(keys[group_start])
+               && std::get<1>(keys[group_end])
+                   == std::get<1>(keys[group_start])) {
+            ++group_end;
         }
-        bool delete_cymbal = true;
-        for (auto j = 0U; j < notes.size(); ++j) {
-            if (i == j) {
-                continue;
-            }
-            const auto& non_cymbal_note = notes[j];
-            if (non_cymbal_note.position != cymbal_note.position) {
-                continue;
-            }
-            if (cymbal_note.colours() != non_cymbal_note.colours()) {
-                continue;
-            }
-            delete_cymbal = false;
-            deletion_spots.insert(j);
+        auto cymbal_count = 0;
+        for (auto i = group_start; i < group_end; ++i) {
+            cymbal_count += static_cast<int>(is_cymbal(std::get<2>(keys[i])));
         }
-        if (delete_cymbal) {
-            deletion_spots.insert(i);
+        const auto group_size = group_end - group_start;
+        for (auto i = group_start; i < group_end && cymbal_count > 0; ++i) {
+            const auto index = std::get<2>(keys[i]);
+            is_deleted[index] = is_cymbal(index)
+                ? (group_size == 1 || cymbal_count > 1)
+                : true;
         }
+        group_start = group_end;
     }
 
-    std::vector<SightRead::Note> new_notes;
+    std::size_t kept_count = 0;
     for (auto i = 0U; i < notes.size(); ++i) {
-        if (!deletion_spots.contains(i)) {
-            new_notes.push_back(notes[i]);
+        if (!is_deleted[i]) {
+            notes[kept_count] = notes[i];
+            ++kept_count;
         }
     }
-    return new_notes;
+    notes.resize(kept_count);
+    return notes;
 }
 
 int no_dynamics_lane_colour(const SightRead::Note& note)
@@ -261,37 +304,48 @@ int no_dynamics_lane_colour(const SightRead::Note& note)
 
 std::vector<SightRead::Note> apply_dynamics_events(
     std::vector<SightRead::Note> notes,
-    const std::vector<SightRead::Detail::NoteEvent>& note_events)
+    std::span<const SightRead::Detail::NoteEvent> note_events,
+    std::pmr::memory_resource* resource)
 {
     constexpr int GHOST_BASE = 34;
     constexpr int ACCENT_BASE = 40;
     constexpr int LANE_COUNT = 4;
 
-    std::set<std::tuple<SightRead::Tick, int>> accent_events;
-    std::set<std::tuple<SightRead::Tick, int>> ghost_events;
+    std::pmr::vector<std::tuple<SightRead::Tick, int>> accent_events {
+        resource};
+    std::pmr::vector<std::tuple<SightRead::Tick, int>> ghost_events {
+        resource};
 
     for (const auto& event : note_events) {
         if (event.fret > ACCENT_BASE + LANE_COUNT || event.fret < GHOST_BASE) {
             continue;
         }
         if (event.fret < GHOST_BASE + LANE_COUNT) {
-            accent_events.emplace(SightRead::Tick {event.position},
-                                  event.fret - GHOST_BASE);
+            accent_events.emplace_back(SightRead::Tick {event.position},
+                                       event.fret - GHOST_BASE);
         }
         if (event.fret >= ACCENT_BASE) {
-            ghost_events.emplace(SightRead::Tick {event.position},
-                                 event.fret - ACCENT_BASE);
+            ghost_events.emplace_back(SightRead::Tick {event.position},
+                                      event.fret - ACCENT_BASE);
         }
     }
+    if (accent_events.empty() && ghost_events.empty()) {
+        return notes;
+    }
+    std::sort(accent_events.begin(), accent_events.end());
+    std::sort(ghost_events.begin(), ghost_events.end());
     for (auto& note : notes) {
         if (note.is_kick_note()) {
             continue;
         }
-        const auto lane = no_dynamics_lane_colour(note);
-        if (accent_events.contains({note.position, lane})) {
+        const std::tuple<SightRead::Tick, int> key {
+            note.position, no_dynamics_lane_colour(note)};
+        if (std::binary_search(accent_events.cbegin(), accent_events.cend(),
+                               key)) {
             note.flags = static_cast<SightRead::NoteFlags>(
                 note.flags | SightRead::FLAGS_ACCENT);
-        } else if (ghost_events.contains({note.position, lane})) {
+        } else if (std::binary_search(ghost_events.cbegin(),
+                                      ghost_events.cend(), key)) {
             note.flags = static_cast<SightRead::NoteFlags>(
                 note.flags | SightRead::FLAGS_GHOST);
         }
@@ -299,10 +353,12 @@ std::vector<SightRead::Note> apply_dynamics_events(
     return notes;
 }
 
+// The positions are gathered as they come and only sorted once, when they are
+// applied.
 class ForcingEvents {
 private:
-    std::set<int> m_forcing_positions;
-    std::set<int> m_tap_positions;
+    std::pmr::vector<int> m_forcing_positions;
+    std::pmr::vector<int> m_tap_positions;
 
     static bool is_forcing_key(int fret_type, SightRead::TrackType track_type)
     {
@@ -341,13 +397,28 @@ private:
     }
 
 public:
-    void apply_forcing(std::vector<SightRead::Note>& notes) const
+    explicit ForcingEvents(std::pmr::memory_resource* resource)
+        : m_forcing_positions {resource}
+        , m_tap_positions {resource}
+    {
+    }
+
+    void apply_forcing(std::vector<SightRead::Note>& notes)
     {
+        if (m_forcing_positions.empty() && m_tap_positions.empty()) {
+            return;
+        }
+        std::sort(m_forcing_positions.begin(), m_forcing_positions.end());
+        std::sort(m_tap_positions.begin(), m_tap_positions.end());
         for (auto& note : notes) {
-            if (m_tap_positions.contains(note.position.value())) {
+            const auto position = note.position.value();
+            if (std::binary_search(m_tap_positions.cbegin(),
+                                   m_tap_positions.cend(), position)) {
                 note.flags = static_cast<SightRead::NoteFlags>(
                     note.flags | SightRead::FLAGS_TAP);
-            } else if (m_forcing_positions.contains(note.position.value())) {
+            } else if (std::binary_search(m_forcing_positions.cbegin(),
+                                          m_forcing_positions.cend(),
+                                          position)) {
                 note.flags = static_cast<SightRead::NoteFlags>(
                     note.flags | SightRead::FLAGS_FORCE_FLIP);
             }
@@ -358,31 +429,36 @@ public:
                          SightRead::TrackType track_type)
     {
         if (is_forcing_key(event.fret, track_type)) {
-            m_forcing_positions.insert(event.position);
+            m_forcing_positions.push_back(event.position);
         } else if (is_tap_key(event.fret, track_type)) {
-            m_tap_positions.insert(event.position);
+            m_tap_positions.push_back(event.position);
         }
     }
 };
 
 std::vector<SightRead::Note>
 apply_drum_events(std::vector<SightRead::Note> notes,
-                  const std::vector<SightRead::Detail::NoteEvent>& note_events,
-                  SightRead::TrackType track_type)
+                  std::span<const SightRead::Detail::NoteEvent> note_events,
+                  SightRead::TrackType track_type,
+                  std::pmr::memory_resource* resource)
 {
     if (track_type != SightRead::TrackType::Drums) {
         return notes;
     }
-    notes = add_fifth_lane_greens(std::move(notes), note_events);
-    notes = apply_cymbal_events(notes);
-    return apply_dynamics_events(notes, note_events);
+    notes = add_fifth_lane_greens(std::move(notes), note_events, resource);
+    notes = apply_cymbal_events(std::move(notes), resource);
+    return apply_dynamics_events(std::move(notes), note_events, resource);
 }
 
+// Scratch is allocated from resource. What ends up in the NoteTrack uses the
+// global heap, as the Song can outlive resource.
 SightRead::NoteTrack
 note_track_from_section(const SightRead::Detail::ChartSection& section,
                         std::shared_ptr<SightRead::SongGlobalData> global_data,
                         SightRead::TrackType track_type, bool permit_solos,
-                        SightRead::Tick max_hopo_gap)
+                        SightRead::Tick max_hopo_gap,
+                        SightRead::Detail::PhaseSink note_track_sink,
+                        std::pmr::memory_resource* resource)
 {
     constexpr int DISCO_FLIP_START_SIZE = 13;
     constexpr int DISCO_FLIP_END_SIZE = 12;
@@ -391,7 +467,7 @@ note_track_from_section(const SightRead::Detail::ChartSection& section,
     constexpr std::array<std::uint8_t, 6> DRUMS {
         {'_', 'd', 'r', 'u', 'm', 's'}};
 
-    ForcingEvents forcing_events;
+    ForcingEvents forcing_events {resource};
     std::vector<SightRead::Note> notes;
     for (const auto& note_event : section.note_events) {
         const auto note
@@ -404,7 +480,8 @@ note_track_from_section(const SightRead::Detail::ChartSection& section,
         }
     }
     forcing_events.apply_forcing(notes);
-    notes = apply_drum_events(notes, section.note_events, track_type);
+    notes = apply_drum_events(std::move(notes), section.note_events,
+                              track_type, resource);
 
     std::vector<SightRead::DrumFill> fills;
     std::vector<SightRead::StarPower> sp;
@@ -424,10 +501,10 @@ note_track_from_section(const SightRead::Detail::ChartSection& section,
         fills.shrink_to_fit();
     }
 
-    std::vector<int> solo_on_events;
-    std::vector<int> solo_off_events;
-    std::vector<int> disco_flip_on_events;
-    std::vector<int> disco_flip_off_events;
+    std::pmr::vector<int> solo_on_events {resource};
+    std::pmr::vector<int> solo_off_events {resource};
+    std::pmr::vector<int> disco_flip_on_events {resource};
+    std::pmr::vector<int> disco_flip_off_events {resource};
     for (const auto& event : section.events) {
         if (event.data == "solo") {
             solo_on_events.push_back(event.position);
@@ -462,6 +539,7 @@ note_track_from_section(const SightRead::Detail::ChartSection& section,
         disco_flips.push_back({start, end - start});
     }
 
+    const SightRead::Detail::PhaseTimer timer {note_track_sink};
     SightRead::NoteTrack note_track {std::move(notes), sp, track_type,
                                      std::move(global_data), max_hopo_gap};
     note_track.solos(std::move(solos));
@@ -497,6 +575,13 @@ track_type_from_instrument(SightRead::Instrument instrument)
 
     throw std::invalid_argument("Invalid instrument");
 }
+
+std::size_t event_count(const SightRead::Detail::ChartSection& section)
+{
+    return section.key_value_pairs.size() + section.bpm_events.size()
+        + section.events.size() + section.note_events.size()
+        + section.special_events.size() + section.ts_events.size();
+}
 }
 
 SightRead::Detail::ChartConverter::ChartConverter(SightRead::Metadata metadata)
@@ -507,6 +592,7 @@ SightRead::Detail::ChartConverter::ChartConverter(SightRead::Metadata metadata)
                         SightRead::Tick {0}}
     , m_permitted_instruments {SightRead::all_instruments()}
     , m_permit_solos {true}
+    , m_thread_count {1}
 {
 }
 
@@ -533,9 +619,123 @@ SightRead::Detail::ChartConverter::parse_solos(bool permit_solos)
     return *this;
 }
 
+SightRead::Detail::ChartConverter&
+SightRead::Detail::ChartConverter::threads(unsigned int thread_count)
+{
+    m_thread_count = thread_count;
+    return *this;
+}
+
+void SightRead::Detail::ChartConverter::add_note_tracks(
+    std::pmr::vector<PendingTrack>& pending_tracks, SightRead::Song& song,
+    SightRead::ParseStats* stats, SightRead::Detail::ChartTrackCache* cache,
+    std::pmr::memory_resource* resource) const
+{
+    const auto global_data = song.global_data_ptr();
+    const auto resolution = global_data->resolution();
+    const auto max_hopo_gap = m_hopo_threshold.chart_max_hopo_gap(resolution);
+
+    std::pmr::vector<std::shared_ptr<const SightRead::NoteTrack>> note_tracks(
+        pending_tracks.size(), resource);
+    std::pmr::vector<std::size_t> tracks_to_convert {resource};
+    for (auto i = 0U; i < pending_tracks.size(); ++i) {
+        if (cache != nullptr) {
+            const auto entry = cache->m_entries.find(pending_tracks[i].section);
+            if (entry != cache->m_entries.cend()
+                && entry->second.resolution == resolution) {
+                note_tracks[i] = entry->second.track;
+                continue;
+            }
+        }
+        tracks_to_convert.push_back(i);
+    }
+
+    // Each task only touches its own element, so the vector is sized before
+    // any are started.
+    std::size_t first_stats = 0;
+    if (stats != nullptr) {
+        first_stats = stats->tracks.size();
+        for (const auto i : tracks_to_convert) {
+            const auto& track = pending_tracks[i];
+            stats->tracks.push_back({track.instrument,
+                                     track.difficulty,
+                                     event_count(*track.section),
+                                     {},
+                                     {}});
+        }
+    }
+    auto converted_tracks = parallel_map(
+        tracks_to_convert.size(), m_thread_count, [&](std::size_t i) {
+            const auto& track = pending_tracks[tracks_to_convert[i]];
+            SightRead::Detail::PhaseSink conversion_sink;
+            SightRead::Detail::PhaseSink note_track_sink;
+            if (stats != nullptr) {
+                auto& track_stats = stats->tracks[first_stats + i];
+                conversion_sink
+                    = {&track_stats.conversion, stats->allocation_counter};
+                note_track_sink
+                    = {&track_stats.note_track, stats->allocation_counter};
+            }
+            const SightRead::Detail::PhaseTimer timer {conversion_sink};
+            return note_track_from_section(
+                *track.section, global_data,
+                track_type_from_instrument(track.instrument), m_permit_solos,
+                max_hopo_gap, note_track_sink, resource);
+        });
+    for (auto i = 0U; i < converted_tracks.size(); ++i) {
+        note_tracks[tracks_to_convert[i]]
+            = std::make_shared<const SightRead::NoteTrack>(
+                std::move(converted_tracks[i]));
+    }
+
+    for (auto i = 0U; i < note_tracks.size(); ++i) {
+        const auto& track = pending_tracks[i];
+        if (cache != nullptr) {
+            cache->m_next_entries[track.section] = {resolution, note_tracks[i]};
+        }
+        song.add_note_track(track.instrument, track.difficulty,
+                            std::move(note_tracks[i]));
+    }
+    pending_tracks.clear();
+}
+
 SightRead::Song SightRead::Detail::ChartConverter::convert(
-    const SightRead::Detail::Chart& chart) const
+    const SightRead::Detail::Chart& chart, SightRead::ParseStats* stats) const
+{
+    auto* resource = chart.sections.get_allocator().resource();
+    std::pmr::vector<const SightRead::Detail::ChartSection*> sections {
+        resource};
+    sections.reserve(chart.sections.size());
+    for (const auto& section : chart.sections) {
+        sections.push_back(&section);
+    }
+    return convert_sections(sections, stats, nullptr, resource);
+}
+
+SightRead::Song SightRead::Detail::ChartConverter::convert(
+    std::span<const SightRead::Detail::ChartSection* const> sections,
+    SightRead::Detail::ChartTrackCache& cache) const
 {
+    cache.m_next_entries.clear();
+    auto song = convert_sections(sections, nullptr, &cache,
+                                 std::pmr::get_default_resource());
+    std::swap(cache.m_entries, cache.m_next_entries);
+    cache.m_next_entries.clear();
+    return song;
+}
+
+SightRead::Song SightRead::Detail::ChartConverter::convert_sections(
+    std::span<const SightRead::Detail::ChartSection* const> sections,
+    SightRead::ParseStats* stats, SightRead::Detail::ChartTrackCache* cache,
+    std::pmr::memory_resource* resource) const
+{
+    // Conversion workers share the resource, so it is only used through a
+    // lock when there are several.
+    SightRead::Detail::SynchronisedResource synchronised_resource {resource};
+    if (m_thread_count > 1) {
+        resource = &synchronised_resource;
+    }
+
     SightRead::Song song;
 
     song.global_data().is_from_midi(false);
@@ -543,25 +743,32 @@ SightRead::Song SightRead::Detail::ChartConverter::convert(
     song.global_data().artist(m_artist);
     song.global_data().charter(m_charter);
 
-    for (const auto& section : chart.sections) {
+    // Note tracks depend on the resolution in effect when their section is
+    // reached, so pending tracks are converted before any change to it.
+    std::pmr::vector<PendingTrack> pending_tracks {resource};
+    for (const auto* section_ptr : sections) {
+        const auto& section = *section_ptr;
+        if (stats != nullptr) {
+            stats->event_count += event_count(section);
+        }
         if (section.name == "Song") {
-            try {
-                const auto resolution = std::stoi(get_with_default(
-                    section.key_value_pairs, "Resolution", "192"));
-                song.global_data().resolution(resolution);
-            } catch (const std::invalid_argument&) {
-                // CH just ignores this kind of parsing mistake.
-                // TODO: Use from_chars instead to avoid having to use
-                // exceptions as control flow.
+            const auto resolution = resolution_from_section(section);
+            if (resolution.has_value()) {
+                add_note_tracks(pending_tracks, song, stats, cache, resource);
+                song.global_data().resolution(*resolution);
             }
         } else if (section.name == "SyncTrack") {
+            const SightRead::Detail::PhaseTimer timer {
+                SightRead::Detail::phase_sink(
+                    stats, &SightRead::ParseStats::tempo_map)};
             song.global_data().tempo_map(tempo_map_from_section(
                 section, song.global_data().resolution()));
         } else if (section.name == "Events") {
             song.global_data().practice_sections(
                 practice_sections_from_section(section));
         } else {
-            auto pair = diff_inst_from_header(section.name);
+            auto pair
+                = SightRead::Detail::diff_inst_from_header(section.name);
             if (!pair.has_value()) {
                 continue;
             }
@@ -569,18 +776,92 @@ SightRead::Song SightRead::Detail::ChartConverter::convert(
             if (!m_permitted_instruments.contains(inst)) {
                 continue;
             }
-            const auto resolution = song.global_data().resolution();
-            auto note_track = note_track_from_section(
-                section, song.global_data_ptr(),
-                track_type_from_instrument(inst), m_permit_solos,
-                m_hopo_threshold.chart_max_hopo_gap(resolution));
-            song.add_note_track(inst, diff, std::move(note_track));
+            pending_tracks.push_back({inst, diff, &section});
+            if (m_thread_count <= 1) {
+                add_note_tracks(pending_tracks, song, stats, cache, resource);
+            }
         }
     }
+    add_note_tracks(pending_tracks, song, stats, cache, resource);
 
     if (song.instruments().empty()) {
-        throw SightRead::ParseError("Chart has no notes");
+        throw SightRead::ParseError("Chart has no notes",
+                                    SightRead::ParseErrorCode::NoNotes);
     }
 
     return song;
 }
+
+SightRead::SongSummary SightRead::Detail::ChartConverter::summarise(
+    const SightRead::Detail::Chart& chart) const
+{
+    SightRead::SongGlobalData global_data;
+    SightRead::SongSummary summary {global_data.resolution(),
+                                    {},
+                                    SightRead::Tick {0},
+                                    SightRead::Second {0.0}};
+    for (const auto& section : chart.sections) {
+        if (section.name == "Song") {
+            const auto resolution = resolution_from_section(section);
+            if (resolution.has_value()) {
+                global_data.resolution(*resolution);
+            }
+        } else if (section.name == "SyncTrack") {
+            global_data.tempo_map(
+                tempo_map_from_section(section, global_data.resolution()));
+        } else {
+            const auto pair
+                = SightRead::Detail::diff_inst_from_header(section.name);
+            if (!pair.has_value()) {
+                continue;
+            }
+            const auto [diff, inst] = *pair;
+            if (!m_permitted_instruments.contains(inst)) {
+                continue;
+            }
+            // Only the first section with notes for a track is used.
+            if (std::any_of(summary.tracks.cbegin(), summary.tracks.cend(),
+                            [&](const auto& track) {
+                                return track.instrument == inst
+                                    && track.difficulty == diff;
+                            })) {
+                continue;
+            }
+            const auto track_type = track_type_from_instrument(inst);
+            auto note_count = 0;
+            for (const auto& note_event : section.note_events) {
+                const auto note
+                    = note_from_note_colour(note_event.position,
+                                            note_event.length,
+                                            note_event.fret, track_type);
+                // Cymbal markers only modify other notes.
+                if (!note.has_value()
+                    || (note->flags & SightRead::FLAGS_CYMBAL) != 0U) {
+                    continue;
+                }
+                ++note_count;
+                summary.length = std::max(
+                    summary.length,
+                    SightRead::Tick {note_event.position
+                                     + std::max(note_event.length, 0)});
+            }
+            if (note_count > 0) {
+                summary.tracks.push_back({inst, diff, note_count});
+            }
+        }
+    }
+
+    if (summary.tracks.empty()) {
+        throw SightRead::ParseError("Chart has no notes",
+                                    SightRead::ParseErrorCode::NoNotes);
+    }
+
+    std::sort(summary.tracks.begin(), summary.tracks.end(),
+              [](const auto& lhs, const auto& rhs) {
+                  return std::tie(lhs.instrument, lhs.difficulty)
+                      < std::tie(rhs.instrument, rhs.difficulty);
+              });
+    summary.resolution = global_data.resolution();
+    summary.length_seconds = global_data.tempo_map().to_seconds(summary.length);
+    return summary;
+}
@@ -1,16 +1,43 @@
 #ifndef SIGHTREAD_DETAIL_CHARTCONVERTER_HPP
 #define SIGHTREAD_DETAIL_CHARTCONVERTER_HPP
 
+#include <map>
+#include <memory>
+#include <memory_resource>
 #include <set>
+#include <span>
 #include <string>
+#include <vector>
 
 #include "sightread/detail/chart.hpp"
 #include "sightread/hopothreshold.hpp"
 #include "sightread/metadata.hpp"
+#include "sightread/parsestats.hpp"
 #include "sightread/song.hpp"
 #include "sightread/songparts.hpp"
+#include "sightread/songsummary.hpp"
 
 namespace SightRead::Detail {
+// The NoteTracks a ChartConverter made for each note section, so a later
+// conversion can reuse them for sections that are the same objects. A track is
+// only reused if the resolution in effect for its section is also the same,
+// as that is all of the Song's SongGlobalData a track depends on.
+// Only the sections of the latest conversion are kept, and they must outlive
+// the next conversion using the cache, as a new section at the address of a
+// destroyed one would be taken for it.
+class ChartTrackCache {
+private:
+    friend class ChartConverter;
+
+    struct Entry {
+        int resolution;
+        std::shared_ptr<const SightRead::NoteTrack> track;
+    };
+
+    std::map<const ChartSection*, Entry> m_entries;
+    std::map<const ChartSection*, Entry> m_next_entries;
+};
+
 class ChartConverter {
 private:
     std::string m_song_name;
@@ -19,6 +46,27 @@ private:
     SightRead::HopoThreshold m_hopo_threshold;
     std::set<SightRead::Instrument> m_permitted_instruments;
     bool m_permit_solos;
+    unsigned int m_thread_count;
+
+    struct PendingTrack {
+        SightRead::Instrument instrument;
+        SightRead::Difficulty difficulty;
+        const SightRead::Detail::ChartSection* section;
+    };
+
+    // Converts the pending tracks and adds them to song in order, leaving
+    // pending_tracks empty. Their stats are appended to stats if it is not
+    // null. Tracks in cache are reused, and all the tracks are recorded in it.
+    // Scratch is allocated from resource, which must be safe to use from
+    // every conversion thread.
+    void add_note_tracks(std::pmr::vector<PendingTrack>& pending_tracks,
+                         SightRead::Song& song, SightRead::ParseStats* stats,
+                         SightRead::Detail::ChartTrackCache* cache,
+                         std::pmr::memory_resource* resource) const;
+    SightRead::Song convert_sections(
+        std::span<const SightRead::Detail::ChartSection* const> sections,
+        SightRead::ParseStats* stats, SightRead::Detail::ChartTrackCache* cache,
+        std::pmr::memory_resource* resource) const;
 
 public:
     explicit ChartConverter(SightRead::Metadata metadata);
@@ -26,7 +74,23 @@ public:
     ChartConverter&
     permit_instruments(std::set<SightRead::Instrument> permitted_instruments);
     ChartConverter& parse_solos(bool permit_solos);
-    SightRead::Song convert(const SightRead::Detail::Chart& chart) const;
+    // Sets how many threads note sections are converted with. The default is
+    // 1, i.e., conversion happens entirely on the calling thread.
+    ChartConverter& threads(unsigned int thread_count);
+    // If stats is not null, the tempo map, per-track and event count stats
+    // are added to it.
+    SightRead::Song convert(const SightRead::Detail::Chart& chart,
+                            SightRead::ParseStats* stats = nullptr) const;
+    // Converts the sections as convert would a Chart holding them, reusing
+    // the tracks in cache where possible and then leaving the tracks of
+    // these sections in it.
+    SightRead::Song
+    convert(std::span<const SightRead::Detail::ChartSection* const> sections,
+            SightRead::Detail::ChartTrackCache& cache) const;
+    // Reads the resolution, tempos and note events of chart without building
+    // any note tracks.
+    SightRead::SongSummary
+    summarise(const SightRead::Detail::Chart& chart) const;
 };
 }
 
@@ -0,0 +1,112 @@
+#include <system_error>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "sightread/detail/mappedfile.hpp"
+
+#ifdef _WIN32
+namespace {
+[[noreturn]] void throw_windows_error(DWORD error, const char* what)
+{
+    throw std::system_error(static_cast<int>(error), std::system_category(),
+                            what);
+}
+}
+
+SightRead::Detail::MappedFile::MappedFile(const std::filesystem::path& path)
+{
+    m_file_handle
+        = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_file_handle == INVALID_HANDLE_VALUE) {
+        throw_windows_error(GetLastError(), "Could not open file");
+    }
+    LARGE_INTEGER file_size;
+    if (GetFileSizeEx(m_file_handle, &file_size) == 0) {
+        const auto error = GetLastError();
+        CloseHandle(m_file_handle);
+        throw_windows_error(error, "Could not read file size");
+    }
+    m_size = static_cast<std::size_t>(file_size.QuadPart);
+    // Empty files cannot be mapped, but there is also nothing to map.
+    if (m_size == 0) {
+        return;
+    }
+    m_mapping_handle = CreateFileMappingW(m_file_handle, nullptr, PAGE_READONLY,
+                                          0, 0, nullptr);
+    if (m_mapping_handle == nullptr) {
+        const auto error = GetLastError();
+        CloseHandle(m_file_handle);
+        throw_windows_error(error, "Could not map file");
+    }
+    m_data = static_cast<const std::uint8_t*>(
+        MapViewOfFile(m_mapping_handle, FILE_MAP_READ, 0, 0, 0));
+    if (m_data == nullptr) {
+        const auto error = GetLastError();
+        CloseHandle(m_mapping_handle);
+        CloseHandle(m_file_handle);
+        throw_windows_error(error, "Could not map file");
+    }
+}
+
+SightRead::Detail::MappedFile::~MappedFile()
+{
+    if (m_data != nullptr) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping_handle != nullptr) {
+        CloseHandle(m_mapping_handle);
+    }
+    CloseHandle(m_file_handle);
+}
+#else
+SightRead::Detail::MappedFile::MappedFile(const std::filesystem::path& path)
+{
+    const auto fd = open(path.c_str(), O_RDONLY); // NOLINT
+    if (fd == -1) {
+        throw std::system_error(errno, std::generic_category(),
+                                "Could not open file");
+    }
+    struct stat file_info {};
+    if (fstat(fd, &file_info) == -1) {
+        const auto error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(),
+                                "Could not read file size");
+    }
+    m_size = static_cast<std::size_t>(file_info.st_size);
+    // Empty files cannot be mapped, but there is also nothing to map.
+    if (m_size == 0) {
+        close(fd);
+        return;
+    }
+    auto* mapping = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file, so the descriptor is
+    // not needed past this point.
+    const auto error = errno;
+    close(fd);
+    if (mapping == MAP_FAILED) { // NOLINT
+        throw std::system_error(error, std::generic_category(),
+                                "Could not map file");
+    }
+    m_data = static_cast<const std::uint8_t*>(mapping);
+}
+
+SightRead::Detail::MappedFile::~MappedFile()
+{
+    if (m_data != nullptr) {
+        munmap(const_cast<std::uint8_t*>(m_data), m_size); // NOLINT
+    }
+}
+#endif
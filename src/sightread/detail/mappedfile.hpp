@@ -0,0 +1,36 @@
+#ifndef SIGHTREAD_DETAIL_MAPPEDFILE_HPP
+#define SIGHTREAD_DETAIL_MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+namespace SightRead::Detail {
+// A read-only memory mapping of a whole file, unmapped on destruction. Throws
+// std::system_error if the file cannot be opened or mapped.
+class MappedFile {
+private:
+    const std::uint8_t* m_data {nullptr};
+    std::size_t m_size {0};
+#ifdef _WIN32
+    void* m_file_handle {nullptr};
+    void* m_mapping_handle {nullptr};
+#endif
+
+public:
+    explicit MappedFile(const std::filesystem::path& path);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+    ~MappedFile();
+
+    [[nodiscard]] std::span<const std::uint8_t> data() const
+    {
+        return {m_data, m_size};
+    }
+};
+}
+
+#endif
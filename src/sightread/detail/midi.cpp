@@ -1,5 +1,9 @@
+#include <algorithm>
 #include <climits>
 #include <cstddef>
+#include <memory_resource>
+#include <optional>
+#include <string>
 #include <utility>
 
 #include "sightread/songparts.hpp"
@@ -7,15 +11,29 @@
 #include "midi.hpp"
 
 namespace {
-[[noreturn]] void throw_on_insufficient_bytes()
+// The offset in the file of the chunk being read, which errors are thrown
+// with so that no caller needs to catch and rethrow them to add it. Tracks
+// decoded from a MidiTrackIndex have no known offset.
+using ChunkStart = std::optional<std::size_t>;
+
+[[noreturn]] void
+throw_chunk_error(const char* what, ChunkStart chunk_start,
+                  SightRead::ParseErrorCode code
+                  = SightRead::ParseErrorCode::MalformedData)
+{
+    throw SightRead::ParseError(what, code, chunk_start);
+}
+
+[[noreturn]] void throw_on_insufficient_bytes(ChunkStart chunk_start)
 {
-    throw SightRead::ParseError("insufficient bytes");
+    throw_chunk_error("insufficient bytes", chunk_start);
 }
 
-std::uint8_t pop_front(std::span<const std::uint8_t>& data)
+std::uint8_t pop_front(std::span<const std::uint8_t>& data,
+                       ChunkStart chunk_start)
 {
     if (data.empty()) {
-        throw_on_insufficient_bytes();
+        throw_on_insufficient_bytes(chunk_start);
     }
     const auto value = data.front();
     data = data.subspan(1);
@@ -23,19 +41,21 @@ std::uint8_t pop_front(std::span<const std::uint8_t>& data)
 }
 
 // Read a two byte big endian number from the specified offset.
-int read_two_byte_be(std::span<const std::uint8_t> span, std::size_t offset)
+int read_two_byte_be(std::span<const std::uint8_t> span, std::size_t offset,
+                     ChunkStart chunk_start)
 {
     if (span.size() < offset + 2) {
-        throw_on_insufficient_bytes();
+        throw_on_insufficient_bytes(chunk_start);
     }
     return span[offset] << CHAR_BIT | span[offset + 1];
 }
 
 // Read a four byte big endian number from the specified offset.
-int read_four_byte_be(std::span<const std::uint8_t> span, std::size_t offset)
+int read_four_byte_be(std::span<const std::uint8_t> span, std::size_t offset,
+                      ChunkStart chunk_start)
 {
     if (span.size() < offset + 4) {
-        throw_on_insufficient_bytes();
+        throw_on_insufficient_bytes(chunk_start);
     }
     return span[offset] << (3 * CHAR_BIT) | span[offset + 1] << (2 * CHAR_BIT)
         | span[offset + 2] << CHAR_BIT | span[offset + 3];
@@ -46,34 +66,39 @@ struct MidiHeader {
     int num_of_tracks;
 };
 
-MidiHeader read_midi_header(std::span<const std::uint8_t>& data)
+constexpr std::size_t MIDI_HEADER_SIZE = 14;
+constexpr std::size_t TRACK_HEADER_SIZE = 8;
+
+MidiHeader read_midi_header(std::span<const std::uint8_t> data,
+                            ChunkStart chunk_start)
 {
     constexpr std::array<std::uint8_t, 10> MAGIC_NUMBER {
         0x4D, 0x54, 0x68, 0x64, 0, 0, 0, 6, 0, 1};
     constexpr int DIVISION_NEGATIVE_SMPTE_MASK = 0x8000;
-    constexpr int FIRST_TRACK_OFFSET = 14;
     constexpr int TICKS_OFFSET = 12;
     constexpr int TRACK_COUNT_OFFSET = 10;
 
-    if (data.size() < FIRST_TRACK_OFFSET) {
-        throw_on_insufficient_bytes();
+    if (data.size() < MIDI_HEADER_SIZE) {
+        throw_on_insufficient_bytes(chunk_start);
     }
 
     const auto first_ten_bytes = data.subspan(0, MAGIC_NUMBER.size());
     if (!std::equal(first_ten_bytes.begin(), first_ten_bytes.end(),
                     MAGIC_NUMBER.cbegin())) {
-        throw SightRead::ParseError("Invalid MIDI file");
+        throw_chunk_error("Invalid MIDI file", chunk_start);
     }
-    const auto num_of_tracks = read_two_byte_be(data, TRACK_COUNT_OFFSET);
-    const auto division = read_two_byte_be(data, TICKS_OFFSET);
+    const auto num_of_tracks
+        = read_two_byte_be(data, TRACK_COUNT_OFFSET, chunk_start);
+    const auto division = read_two_byte_be(data, TICKS_OFFSET, chunk_start);
     if ((division & DIVISION_NEGATIVE_SMPTE_MASK) != 0) {
-        throw SightRead::ParseError("Only ticks per quarter-note is supported");
+        throw_chunk_error("Only ticks per quarter-note is supported",
+                          chunk_start, SightRead::ParseErrorCode::Unsupported);
     }
-    data = data.subspan(FIRST_TRACK_OFFSET);
     return {division, num_of_tracks};
 }
 
-int read_variable_length_num(std::span<const std::uint8_t>& data)
+int read_variable_length_num(std::span<const std::uint8_t>& data,
+                             ChunkStart chunk_start)
 {
     constexpr int VARIABLE_LENGTH_DATA_MASK = 0x7F;
     constexpr int VARIABLE_LENGTH_DATA_SIZE = 7;
@@ -84,36 +109,36 @@ int read_variable_length_num(std::span<const std::uint8_t>& data)
     while (!data.empty() && ((data.front() & VARIABLE_LENGTH_HIGH_MASK) != 0)) {
         ++bytes_read;
         if (bytes_read >= 4) {
-            throw SightRead::ParseError("Too long variable length number");
+            throw_chunk_error("Too long variable length number", chunk_start);
         }
         number <<= VARIABLE_LENGTH_DATA_SIZE;
-        number |= pop_front(data) & VARIABLE_LENGTH_DATA_MASK;
+        number |= pop_front(data, chunk_start) & VARIABLE_LENGTH_DATA_MASK;
     }
     number <<= VARIABLE_LENGTH_DATA_SIZE;
-    number |= pop_front(data) & VARIABLE_LENGTH_DATA_MASK;
+    number |= pop_front(data, chunk_start) & VARIABLE_LENGTH_DATA_MASK;
     return number;
 }
 
-SightRead::Detail::MetaEvent
-read_meta_event(std::span<const std::uint8_t>& data)
+SightRead::Detail::MetaEventView
+read_meta_event(std::span<const std::uint8_t>& data, ChunkStart chunk_start)
 {
     if (data.empty()) {
-        throw_on_insufficient_bytes();
+        throw_on_insufficient_bytes(chunk_start);
     }
-    SightRead::Detail::MetaEvent event;
-    event.type = pop_front(data);
-    const auto data_length = read_variable_length_num(data);
+    SightRead::Detail::MetaEventView event {};
+    event.type = pop_front(data, chunk_start);
+    const auto data_length = read_variable_length_num(data, chunk_start);
     if (static_cast<std::size_t>(data_length) > data.size()) {
-        throw SightRead::ParseError("Meta Event too long");
+        throw_chunk_error("Meta Event too long", chunk_start);
     }
-    event.data
-        = std::vector<std::uint8_t> {data.begin(), data.begin() + data_length};
+    event.data = data.first(static_cast<std::size_t>(data_length));
     data = data.subspan(static_cast<std::size_t>(data_length));
     return event;
 }
 
 SightRead::Detail::MidiEvent
-read_midi_event(std::span<const std::uint8_t>& data, int prev_status_byte)
+read_midi_event(std::span<const std::uint8_t>& data, int prev_status_byte,
+                ChunkStart chunk_start)
 {
     constexpr int CHANNEL_PRESSURE_ID = 0xD0;
     constexpr int IS_STATUS_BYTE_MASK = 0x80;
@@ -122,7 +147,7 @@ read_midi_event(std::span<const std::uint8_t>& data, int prev_status_byte)
     constexpr int UPPER_NIBBLE_MASK = 0xF0;
 
     if (data.empty()) {
-        throw_on_insufficient_bytes();
+        throw_on_insufficient_bytes(chunk_start);
     }
     auto event_type = data.front();
     if ((event_type & IS_STATUS_BYTE_MASK) != 0) {
@@ -130,88 +155,441 @@ read_midi_event(std::span<const std::uint8_t>& data, int prev_status_byte)
     } else if (prev_status_byte != -1) {
         event_type = static_cast<std::uint8_t>(prev_status_byte);
     } else {
-        throw SightRead::ParseError(
-            "MIDI Event has no status byte and there is no running status");
+        throw_chunk_error(
+            "MIDI Event has no status byte and there is no running status",
+            chunk_start);
     }
 
     if ((event_type & UPPER_NIBBLE_MASK) == SYSTEM_COMMON_MSG_ID) {
-        throw SightRead::ParseError(
-            "MIDI Events with high nibble 0xF are not supported");
+        throw_chunk_error("MIDI Events with high nibble 0xF are not supported",
+                          chunk_start);
     }
-    std::array<std::uint8_t, 2> event_data {pop_front(data), 0};
+    std::array<std::uint8_t, 2> event_data {pop_front(data, chunk_start), 0};
     if ((event_type & UPPER_NIBBLE_MASK) != PROGRAM_CHANGE_ID
         && (event_type & UPPER_NIBBLE_MASK) != CHANNEL_PRESSURE_ID) {
-        event_data[1] = pop_front(data);
+        event_data[1] = pop_front(data, chunk_start);
     }
 
     return {event_type, event_data};
 }
 
-SightRead::Detail::SysexEvent
-read_sysex_event(std::span<const std::uint8_t>& data)
+SightRead::Detail::SysexEventView
+read_sysex_event(std::span<const std::uint8_t>& data, ChunkStart chunk_start)
 {
-    const auto data_length = read_variable_length_num(data);
+    const auto data_length = read_variable_length_num(data, chunk_start);
     if (static_cast<std::size_t>(data_length) > data.size()) {
-        throw SightRead::ParseError("Sysex Event too long");
+        throw_chunk_error("Sysex Event too long", chunk_start);
     }
-    SightRead::Detail::SysexEvent event;
-    event.data
-        = std::vector<std::uint8_t> {data.begin(), data.begin() + data_length};
+    SightRead::Detail::SysexEventView event {
+        data.first(static_cast<std::size_t>(data_length))};
     data = data.subspan(static_cast<std::size_t>(data_length));
     return event;
 }
 
-SightRead::Detail::MidiTrack
-read_midi_track(std::span<const std::uint8_t>& data)
+// Reads an MTrk chunk header, returning the size of the chunk's event bytes.
+std::size_t read_track_chunk_size(std::span<const std::uint8_t> header,
+                                  ChunkStart chunk_start)
 {
-    constexpr int META_EVENT_ID = 0xFF;
-    constexpr int SYSEX_EVENT_ID = 0xF0;
     constexpr int TRACK_HEADER_MAGIC_NUMBER = 0x4D54726B;
-    constexpr int TRACK_HEADER_SIZE = 8;
-
-    if (read_four_byte_be(data, 0) != TRACK_HEADER_MAGIC_NUMBER) {
-        throw SightRead::ParseError("Invalid MIDI file");
-    }
-    const auto track_size = read_four_byte_be(data, 4);
-    data = data.subspan(TRACK_HEADER_SIZE);
-    auto absolute_time = 0;
-    const auto final_span_size
-        = data.size() - static_cast<std::size_t>(track_size);
-    auto prev_status_byte = -1;
-    SightRead::Detail::MidiTrack track;
-    while (data.size() != final_span_size) {
-        const auto delta_time = read_variable_length_num(data);
-        absolute_time += delta_time;
-        SightRead::Detail::TimedEvent event {absolute_time, {}};
-        if (data.empty()) {
-            throw_on_insufficient_bytes();
+
+    if (read_four_byte_be(header, 0, chunk_start)
+        != TRACK_HEADER_MAGIC_NUMBER) {
+        throw_chunk_error("Invalid MIDI file", chunk_start);
+    }
+    return static_cast<std::size_t>(
+        static_cast<std::uint32_t>(read_four_byte_be(header, 4, chunk_start)));
+}
+
+// Decodes the events of a single track one at a time, keeping track of the
+// absolute time and running status.
+class TrackEventReader {
+private:
+    std::span<const std::uint8_t> m_data;
+    ChunkStart m_chunk_start;
+    int m_absolute_time {0};
+    int m_prev_status_byte {-1};
+
+public:
+    TrackEventReader(std::span<const std::uint8_t> data,
+                     ChunkStart chunk_start)
+        : m_data {data}
+        , m_chunk_start {chunk_start}
+    {
+    }
+
+    [[nodiscard]] bool empty() const { return m_data.empty(); }
+
+    SightRead::Detail::TimedEventView next()
+    {
+        constexpr int META_EVENT_ID = 0xFF;
+        constexpr int SYSEX_EVENT_ID = 0xF0;
+
+        const auto delta_time = read_variable_length_num(m_data, m_chunk_start);
+        m_absolute_time += delta_time;
+        SightRead::Detail::TimedEventView event {m_absolute_time, {}};
+        if (m_data.empty()) {
+            throw_on_insufficient_bytes(m_chunk_start);
         }
-        const auto event_type = data.front();
+        const auto event_type = m_data.front();
         if (event_type == META_EVENT_ID) {
-            data = data.subspan(1);
-            event.event = read_meta_event(data);
+            m_data = m_data.subspan(1);
+            event.event = read_meta_event(m_data, m_chunk_start);
         } else if (event_type == SYSEX_EVENT_ID) {
-            data = data.subspan(1);
-            event.event = read_sysex_event(data);
+            m_data = m_data.subspan(1);
+            event.event = read_sysex_event(m_data, m_chunk_start);
         } else {
-            const auto midi_event = read_midi_event(data, prev_status_byte);
-            prev_status_byte = midi_event.status;
+            const auto midi_event
+                = read_midi_event(m_data, m_prev_status_byte, m_chunk_start);
+            m_prev_status_byte = midi_event.status;
             event.event = midi_event;
         }
-        track.events.push_back(std::move(event));
+        return event;
+    }
+};
+
+SightRead::Detail::MidiTrackView
+read_midi_track_events(std::span<const std::uint8_t> track_data,
+                       ChunkStart chunk_start,
+                       std::pmr::memory_resource* resource)
+{
+    constexpr int MIN_BYTES_PER_EVENT = 3;
+
+    SightRead::Detail::MidiTrackView track {
+        std::pmr::vector<SightRead::Detail::TimedEventView> {resource}};
+    // Almost all events are at least three bytes long, so this is nearly
+    // always the only allocation needed for the track.
+    track.events.reserve(track_data.size() / MIN_BYTES_PER_EVENT);
+    TrackEventReader reader {track_data, chunk_start};
+    while (!reader.empty()) {
+        track.events.push_back(reader.next());
     }
     return track;
 }
+
+// Finds the track's name, the data of its first text meta event of type 3,
+// decoding only the events up to that point.
+std::optional<std::pmr::string>
+read_track_name(std::span<const std::uint8_t> track_data,
+                ChunkStart chunk_start, std::pmr::memory_resource* resource)
+{
+    constexpr int TRACK_NAME_META_EVENT_TYPE = 3;
+
+    TrackEventReader reader {track_data, chunk_start};
+    while (!reader.empty()) {
+        const auto event = reader.next();
+        const auto* meta_event
+            = std::get_if<SightRead::Detail::MetaEventView>(&event.event);
+        if (meta_event != nullptr
+            && meta_event->type == TRACK_NAME_META_EVENT_TYPE) {
+            return std::pmr::string {meta_event->data.begin(),
+                                     meta_event->data.end(), resource};
+        }
+    }
+    return std::nullopt;
+}
+
+class MidiViewBuilder : public SightRead::MidiVisitor {
+private:
+    static constexpr int MIN_BYTES_PER_EVENT = 3;
+
+    SightRead::Detail::MidiView m_midi;
+
+public:
+    explicit MidiViewBuilder(std::pmr::memory_resource* resource)
+        : m_midi {0, std::pmr::vector<SightRead::Detail::MidiTrackView> {
+                         resource}}
+    {
+    }
+
+    void header(int ticks_per_quarter_note, int /*track_count*/) override
+    {
+        m_midi.ticks_per_quarter_note = ticks_per_quarter_note;
+    }
+
+    bool track_start(const SightRead::Detail::MidiTrackIndex& track) override
+    {
+        // Almost all events are at least three bytes long, so this is nearly
+        // always the only allocation needed for the track.
+        m_midi.tracks.push_back(
+            {std::pmr::vector<SightRead::Detail::TimedEventView> {
+                m_midi.tracks.get_allocator().resource()}});
+        m_midi.tracks.back().events.reserve(track.data.size()
+                                            / MIN_BYTES_PER_EVENT);
+        return true;
+    }
+
+    void meta_event(int time,
+                    const SightRead::Detail::MetaEventView& event) override
+    {
+        m_midi.tracks.back().events.push_back({time, event});
+    }
+
+    void midi_event(int time,
+                    const SightRead::Detail::MidiEvent& event) override
+    {
+        m_midi.tracks.back().events.push_back({time, event});
+    }
+
+    void sysex_event(int time,
+                     const SightRead::Detail::SysexEventView& event) override
+    {
+        m_midi.tracks.back().events.push_back({time, event});
+    }
+
+    SightRead::Detail::MidiView take() && { return std::move(m_midi); }
+};
+
+class MidiIndexBuilder : public SightRead::MidiVisitor {
+private:
+    SightRead::Detail::MidiIndex m_index;
+
+public:
+    explicit MidiIndexBuilder(std::pmr::memory_resource* resource)
+        : m_index {0, std::pmr::vector<SightRead::Detail::MidiTrackIndex> {
+                          resource}}
+    {
+    }
+
+    void header(int ticks_per_quarter_note, int /*track_count*/) override
+    {
+        m_index.ticks_per_quarter_note = ticks_per_quarter_note;
+    }
+
+    bool track_start(const SightRead::Detail::MidiTrackIndex& track) override
+    {
+        // MidiTrackIndex is not allocator-aware, so the name is copied into
+        // the index's resource by hand.
+        auto& track_index = m_index.tracks.emplace_back();
+        track_index.data = track.data;
+        if (track.name.has_value()) {
+            track_index.name.emplace(*track.name,
+                                     m_index.tracks.get_allocator().resource());
+        }
+        return false;
+    }
+
+    SightRead::Detail::MidiIndex take() && { return std::move(m_index); }
+};
+
+std::variant<SightRead::Detail::MetaEvent, SightRead::Detail::MidiEvent,
+             SightRead::Detail::SysexEvent>
+owned_event(const std::variant<SightRead::Detail::MetaEventView,
+                               SightRead::Detail::MidiEvent,
+                               SightRead::Detail::SysexEventView>& event)
+{
+    if (const auto* meta_event
+        = std::get_if<SightRead::Detail::MetaEventView>(&event)) {
+        return SightRead::Detail::MetaEvent {
+            meta_event->type,
+            {meta_event->data.begin(), meta_event->data.end()}};
+    }
+    if (const auto* sysex_event
+        = std::get_if<SightRead::Detail::SysexEventView>(&event)) {
+        return SightRead::Detail::SysexEvent {
+            {sysex_event->data.begin(), sysex_event->data.end()}};
+    }
+    return std::get<SightRead::Detail::MidiEvent>(event);
+}
+
+std::variant<SightRead::Detail::MetaEventView, SightRead::Detail::MidiEvent,
+             SightRead::Detail::SysexEventView>
+viewed_event(const std::variant<SightRead::Detail::MetaEvent,
+                                SightRead::Detail::MidiEvent,
+                                SightRead::Detail::SysexEvent>& event)
+{
+    if (const auto* meta_event
+        = std::get_if<SightRead::Detail::MetaEvent>(&event)) {
+        return SightRead::Detail::MetaEventView {meta_event->type,
+                                                 meta_event->data};
+    }
+    if (const auto* sysex_event
+        = std::get_if<SightRead::Detail::SysexEvent>(&event)) {
+        return SightRead::Detail::SysexEventView {sysex_event->data};
+    }
+    return std::get<SightRead::Detail::MidiEvent>(event);
+}
+}
+
+SightRead::MidiStreamParser::MidiStreamParser(
+    SightRead::MidiVisitor& visitor,
+    std::pmr::memory_resource* resource)
+    : m_visitor {&visitor}
+    , m_buffer {resource}
+    , m_bytes_needed {MIDI_HEADER_SIZE}
+{
+}
+
+void SightRead::MidiStreamParser::feed(std::span<const std::uint8_t> chunk)
+{
+    while (!chunk.empty() && m_state != State::Done) {
+        const auto part = take_bytes(chunk);
+        if (part.empty()) {
+            return;
+        }
+        if (m_state != State::TrackData) {
+            m_chunk_start = m_position - part.size();
+        }
+        read_part(part);
+        m_buffer.clear();
+    }
+}
+
+void SightRead::MidiStreamParser::finish()
+{
+    // As with a contiguous file, the file may stop short of the number of
+    // tracks in the header, but only between tracks.
+    if (m_state == State::Header || m_state == State::TrackData
+        || !m_buffer.empty()) {
+        const auto offset = m_state == State::TrackData
+            ? m_chunk_start
+            : m_position - m_buffer.size();
+        throw_on_insufficient_bytes(offset);
+    }
+}
+
+// Returns the next m_bytes_needed bytes, straight from chunk if it has them
+// all and nothing is buffered. Otherwise the bytes are buffered, and an empty
+// span is returned until they have all arrived.
+std::span<const std::uint8_t> SightRead::MidiStreamParser::take_bytes(
+    std::span<const std::uint8_t>& chunk)
+{
+    if (m_buffer.empty() && chunk.size() >= m_bytes_needed) {
+        const auto part = chunk.first(m_bytes_needed);
+        chunk = chunk.subspan(m_bytes_needed);
+        m_position += m_bytes_needed;
+        return part;
+    }
+    const auto byte_count
+        = std::min(m_bytes_needed - m_buffer.size(), chunk.size());
+    m_buffer.insert(m_buffer.end(), chunk.begin(),
+                    chunk.begin() + static_cast<std::ptrdiff_t>(byte_count));
+    chunk = chunk.subspan(byte_count);
+    m_position += byte_count;
+    if (m_buffer.size() < m_bytes_needed) {
+        return {};
+    }
+    return m_buffer;
+}
+
+void SightRead::MidiStreamParser::read_part(std::span<const std::uint8_t> part)
+{
+    switch (m_state) {
+    case State::Header: {
+        const auto header = read_midi_header(part, m_chunk_start);
+        m_visitor->header(header.ticks_per_quarter_note, header.num_of_tracks);
+        m_tracks_left = header.num_of_tracks;
+        break;
+    }
+    case State::TrackHeader: {
+        const auto track_size = read_track_chunk_size(part, m_chunk_start);
+        if (track_size > 0) {
+            m_state = State::TrackData;
+            m_bytes_needed = track_size;
+            return;
+        }
+        read_track({});
+        --m_tracks_left;
+        break;
+    }
+    case State::TrackData:
+        read_track(part);
+        --m_tracks_left;
+        break;
+    case State::Done:
+        return;
+    }
+    m_state = m_tracks_left > 0 ? State::TrackHeader : State::Done;
+    m_bytes_needed = TRACK_HEADER_SIZE;
+}
+
+void SightRead::MidiStreamParser::read_track(
+    std::span<const std::uint8_t> track_data)
+{
+    auto name = read_track_name(track_data, m_chunk_start,
+                                m_buffer.get_allocator().resource());
+    if (!m_visitor->track_start({track_data, std::move(name)})) {
+        return;
+    }
+    TrackEventReader reader {track_data, m_chunk_start};
+    while (!reader.empty()) {
+        const auto event = reader.next();
+        if (const auto* meta_event
+            = std::get_if<SightRead::Detail::MetaEventView>(&event.event)) {
+            m_visitor->meta_event(event.time, *meta_event);
+        } else if (const auto* midi_event
+                   = std::get_if<SightRead::Detail::MidiEvent>(&event.event)) {
+            m_visitor->midi_event(event.time, *midi_event);
+        } else {
+            m_visitor->sysex_event(
+                event.time,
+                std::get<SightRead::Detail::SysexEventView>(event.event));
+        }
+    }
+    m_visitor->track_end();
+}
+
+// Giving all the data as one chunk means the views borrow from data itself.
+SightRead::Detail::MidiView
+SightRead::Detail::parse_midi_view(std::span<const std::uint8_t> data,
+                                   std::pmr::memory_resource* resource)
+{
+    MidiViewBuilder builder {resource};
+    SightRead::MidiStreamParser parser {builder, resource};
+    parser.feed(data);
+    parser.finish();
+    return std::move(builder).take();
+}
+
+SightRead::Detail::MidiIndex
+SightRead::Detail::index_midi(std::span<const std::uint8_t> data,
+                              std::pmr::memory_resource* resource)
+{
+    MidiIndexBuilder builder {resource};
+    SightRead::MidiStreamParser parser {builder, resource};
+    parser.feed(data);
+    parser.finish();
+    return std::move(builder).take();
+}
+
+SightRead::Detail::MidiTrackView SightRead::Detail::decode_midi_track(
+    const SightRead::Detail::MidiTrackIndex& track,
+    std::pmr::memory_resource* resource)
+{
+    return read_midi_track_events(track.data, std::nullopt, resource);
 }
 
 SightRead::Detail::Midi
 SightRead::Detail::parse_midi(std::span<const std::uint8_t> data)
 {
-    const auto header = read_midi_header(data);
+    const auto view = parse_midi_view(data);
     std::vector<SightRead::Detail::MidiTrack> tracks;
-    for (auto i = 0; i < header.num_of_tracks && !data.empty(); ++i) {
-        tracks.push_back(read_midi_track(data));
+    tracks.reserve(view.tracks.size());
+    for (const auto& track_view : view.tracks) {
+        SightRead::Detail::MidiTrack track;
+        track.events.reserve(track_view.events.size());
+        for (const auto& event : track_view.events) {
+            track.events.push_back({event.time, owned_event(event.event)});
+        }
+        tracks.push_back(std::move(track));
     }
-    return SightRead::Detail::Midi {header.ticks_per_quarter_note,
+    return SightRead::Detail::Midi {view.ticks_per_quarter_note,
                                     std::move(tracks)};
 }
+
+SightRead::Detail::MidiView
+SightRead::Detail::make_midi_view(const SightRead::Detail::Midi& midi)
+{
+    std::pmr::vector<SightRead::Detail::MidiTrackView> tracks;
+    tracks.reserve(midi.tracks.size());
+    for (const auto& track : midi.tracks) {
+        SightRead::Detail::MidiTrackView track_view;
+        track_view.events.reserve(track.events.size());
+        for (const auto& event : track.events) {
+            track_view.events.push_back(
+                {event.time, viewed_event(event.event)});
+        }
+        tracks.push_back(std::move(track_view));
+    }
+    return SightRead::Detail::MidiView {midi.ticks_per_quarter_note,
+                                        std::move(tracks)};
+}
@@ -1,22 +1,26 @@
 #ifndef SIGHTREAD_DETAIL_MIDI_HPP
 #define SIGHTREAD_DETAIL_MIDI_HPP
 
-#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <memory_resource>
 #include <span>
 #include <variant>
 #include <vector>
 
+#include "sightread/midistreamparser.hpp"
+
 namespace SightRead::Detail {
 struct MetaEvent {
     int type;
     std::vector<std::uint8_t> data;
 };
 
-struct MidiEvent {
-    int status;
-    std::array<std::uint8_t, 2> data;
-};
+// The event types the MidiStreamParser passes on are public.
+using SightRead::MetaEventView;
+using SightRead::MidiEvent;
+using SightRead::MidiTrackIndex;
+using SightRead::SysexEventView;
 
 struct SysexEvent {
     std::vector<std::uint8_t> data;
@@ -36,7 +40,47 @@ struct Midi {
     std::vector<MidiTrack> tracks;
 };
 
+// Borrowed counterparts of the above types. The data spans point into the
+// buffer the view was made from, which must outlive the view. The vectors are
+// allocated from the memory resource given to the function making the view.
+struct TimedEventView {
+    int time {0};
+    std::variant<MetaEventView, MidiEvent, SysexEventView> event;
+};
+
+struct MidiTrackView {
+    std::pmr::vector<TimedEventView> events;
+};
+
+struct MidiView {
+    int ticks_per_quarter_note;
+    std::pmr::vector<MidiTrackView> tracks;
+};
+
+struct MidiIndex {
+    int ticks_per_quarter_note;
+    std::pmr::vector<MidiTrackIndex> tracks;
+};
+
 Midi parse_midi(std::span<const std::uint8_t> data);
+
+// Like parse_midi, but the meta and sysex event data borrows from data instead
+// of being copied, so only one allocation per track is made.
+MidiView parse_midi_view(
+    std::span<const std::uint8_t> data,
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+MidiView make_midi_view(const Midi& midi);
+
+// Reads only the track chunk headers and each track's name. The index borrows
+// from data, and the tracks can later be decoded with decode_midi_track.
+MidiIndex index_midi(
+    std::span<const std::uint8_t> data,
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+MidiTrackView decode_midi_track(
+    const MidiTrackIndex& track,
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 }
 
 #endif
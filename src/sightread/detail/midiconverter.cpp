@@ -1,16 +1,25 @@
 #include <algorithm>
+#include <array>
 #include <climits>
+#include <cstddef>
 #include <limits>
+#include <memory_resource>
+#include <span>
 #include <string_view>
+#include <tuple>
 #include <utility>
 #include <vector>
 
 #include "sightread/detail/midiconverter.hpp"
+#include "sightread/detail/parallel.hpp"
 #include "sightread/detail/parserutil.hpp"
+#include "sightread/detail/phasetimer.hpp"
+#include "sightread/detail/synchronisedresource.hpp"
 
 namespace {
 SightRead::TempoMap
-read_first_midi_track(const SightRead::Detail::MidiTrack& track, int resolution)
+read_first_midi_track(const SightRead::Detail::MidiTrackView& track,
+                      int resolution)
 {
     constexpr int SET_TEMPO_ID = 0x51;
     constexpr int TIME_SIG_ID = 0x58;
@@ -19,7 +28,7 @@ read_first_midi_track(const SightRead::Detail::MidiTrack& track, int resolution)
     std::vector<SightRead::TimeSignature> time_sigs;
     for (const auto& event : track.events) {
         const auto* meta_event
-            = std::get_if<SightRead::Detail::MetaEvent>(&event.event);
+            = std::get_if<SightRead::Detail::MetaEventView>(&event.event);
         if (meta_event == nullptr) {
             continue;
         }
@@ -53,27 +62,27 @@ read_first_midi_track(const SightRead::Detail::MidiTrack& track, int resolution)
 }
 
 std::optional<std::string>
-midi_track_name(const SightRead::Detail::MidiTrack& track)
+midi_track_name(const SightRead::Detail::MidiTrackView& track)
 {
     if (track.events.empty()) {
         return std::nullopt;
     }
     for (const auto& event : track.events) {
         const auto* meta_event
-            = std::get_if<SightRead::Detail::MetaEvent>(&event.event);
+            = std::get_if<SightRead::Detail::MetaEventView>(&event.event);
         if (meta_event == nullptr) {
             continue;
         }
         if (meta_event->type != 3) {
             continue;
         }
-        return std::string {meta_event->data.cbegin(), meta_event->data.cend()};
+        return std::string {meta_event->data.begin(), meta_event->data.end()};
     }
     return std::nullopt;
 }
 
 std::vector<SightRead::Tick>
-od_beats_from_track(const SightRead::Detail::MidiTrack& track)
+od_beats_from_track(const SightRead::Detail::MidiTrackView& track)
 {
     constexpr int NOTE_ON_ID = 0x90;
     constexpr int UPPER_NIBBLE_MASK = 0xF0;
@@ -104,7 +113,7 @@ od_beats_from_track(const SightRead::Detail::MidiTrack& track)
 }
 
 std::vector<SightRead::PracticeSection>
-practice_sections_from_track(const SightRead::Detail::MidiTrack& track)
+practice_sections_from_track(const SightRead::Detail::MidiTrackView& track)
 {
     using namespace std::string_view_literals;
 
@@ -114,12 +123,11 @@ practice_sections_from_track(const SightRead::Detail::MidiTrack& track)
     std::vector<SightRead::PracticeSection> practice_sections;
     for (const auto& event : track.events) {
         const auto* meta_event
-            = std::get_if<SightRead::Detail::MetaEvent>(&event.event);
+            = std::get_if<SightRead::Detail::MetaEventView>(&event.event);
         if (meta_event == nullptr || meta_event->type != 1) {
             continue;
         }
-        std::span<const std::uint8_t> section_name {meta_event->data.data(),
-                                                    meta_event->data.size()};
+        auto section_name = meta_event->data;
         if (section_name.empty() || section_name.back() != ']') {
             continue;
         }
@@ -140,7 +148,7 @@ practice_sections_from_track(const SightRead::Detail::MidiTrack& track)
     return practice_sections;
 }
 
-bool is_five_lane_green_note(const SightRead::Detail::TimedEvent& event)
+bool is_five_lane_green_note(const SightRead::Detail::TimedEventView& event)
 {
     constexpr std::array<std::uint8_t, 4> GREEN_LANE_KEYS {65, 77, 89, 101};
     constexpr int NOTE_OFF_ID = 0x80;
@@ -161,38 +169,40 @@ bool is_five_lane_green_note(const SightRead::Detail::TimedEvent& event)
         != GREEN_LANE_KEYS.cend();
 }
 
-bool has_five_lane_green_notes(const SightRead::Detail::MidiTrack& midi_track)
+bool has_five_lane_green_notes(
+    const SightRead::Detail::MidiTrackView& midi_track)
 {
     return std::find_if(midi_track.events.cbegin(), midi_track.events.cend(),
                         is_five_lane_green_note)
         != midi_track.events.cend();
 }
 
-bool is_enable_chart_dynamics(const SightRead::Detail::TimedEvent& event)
+bool is_enable_chart_dynamics(const SightRead::Detail::TimedEventView& event)
 {
     using namespace std::literals;
     constexpr auto ENABLE_DYNAMICS = "[ENABLE_CHART_DYNAMICS]"sv;
 
     const auto* meta_event
-        = std::get_if<SightRead::Detail::MetaEvent>(&event.event);
+        = std::get_if<SightRead::Detail::MetaEventView>(&event.event);
     if (meta_event == nullptr) {
         return false;
     }
     if (meta_event->type != 1) {
         return false;
     }
-    return std::equal(meta_event->data.cbegin(), meta_event->data.cend(),
+    return std::equal(meta_event->data.begin(), meta_event->data.end(),
                       ENABLE_DYNAMICS.cbegin(), ENABLE_DYNAMICS.cend());
 }
 
-bool has_enable_chart_dynamics(const SightRead::Detail::MidiTrack& midi_track)
+bool has_enable_chart_dynamics(
+    const SightRead::Detail::MidiTrackView& midi_track)
 {
     return std::find_if(midi_track.events.cbegin(), midi_track.events.cend(),
                         is_enable_chart_dynamics)
         != midi_track.events.cend();
 }
 
-bool is_open_event_sysex(const SightRead::Detail::SysexEvent& event)
+bool is_open_event_sysex(const SightRead::Detail::SysexEventView& event)
 {
     constexpr std::array<std::tuple<std::size_t, int>, 6> REQUIRED_BYTES {
         std::tuple {0, 0x50}, {1, 0x53}, {2, 0}, {3, 0}, {5, 1}, {7, 0xF7}};
@@ -216,107 +226,135 @@ bool is_open_event_sysex(const SightRead::Detail::SysexEvent& event)
         });
 }
 
-std::optional<SightRead::Difficulty>
-look_up_difficulty(const std::array<std::tuple<int, int, SightRead::Difficulty>,
-                                    4>& diff_ranges,
-                   std::uint8_t key)
+constexpr bool is_cymbal_key(int key, bool from_five_lane)
 {
-    for (const auto& [min, max, diff] : diff_ranges) {
-        if (key >= min && key <= max) {
-            return {diff};
-        }
+    const auto index = (key + 1) % 12;
+    if (from_five_lane) {
+        return index == 3 || index == 5; // NOLINT
     }
-
-    return std::nullopt;
+    return index == 3 || index == 4 || index == 5; // NOLINT
 }
 
-std::optional<SightRead::Difficulty>
-difficulty_from_key(std::uint8_t key, SightRead::TrackType track_type)
-{
-    std::array<std::tuple<int, int, SightRead::Difficulty>, 4> diff_ranges;
-    switch (track_type) {
-    case SightRead::TrackType::FiveFret:
-    case SightRead::TrackType::FortniteFestival:
-        diff_ranges = {{{96, 102, SightRead::Difficulty::Expert}, // NOLINT
-                        {84, 90, SightRead::Difficulty::Hard}, // NOLINT
-                        {72, 78, SightRead::Difficulty::Medium}, // NOLINT
-                        {60, 66, SightRead::Difficulty::Easy}}}; // NOLINT
-        break;
-    case SightRead::TrackType::SixFret:
-        diff_ranges = {{{94, 102, SightRead::Difficulty::Expert}, // NOLINT
-                        {82, 90, SightRead::Difficulty::Hard}, // NOLINT
-                        {70, 78, SightRead::Difficulty::Medium}, // NOLINT
-                        {58, 66, SightRead::Difficulty::Easy}}}; // NOLINT
-        break;
-    case SightRead::TrackType::Drums:
-        diff_ranges = {{{95, 101, SightRead::Difficulty::Expert}, // NOLINT
-                        {83, 89, SightRead::Difficulty::Hard}, // NOLINT
-                        {71, 77, SightRead::Difficulty::Medium}, // NOLINT
-                        {59, 65, SightRead::Difficulty::Easy}}}; // NOLINT
-        break;
-    }
-    return look_up_difficulty(diff_ranges, key);
-}
+// What a note key means on an instrument track. Keys outside every
+// difficulty's range have no difficulty, and keys within a range that are not
+// notes have a colour of -1.
+struct MidiKeyDecoding {
+    std::optional<SightRead::Difficulty> difficulty;
+    int colour {-1};
+    bool is_force_hopo {false};
+    bool is_force_strum {false};
+    bool is_cymbal {false};
+};
+
+using MidiKeyTable = std::array<MidiKeyDecoding, UCHAR_MAX + 1>;
 
-template <typename T, std::size_t N>
-T colour_from_key_and_bounds(std::uint8_t key,
-                             const std::array<unsigned int, 4>& diff_ranges,
-                             const std::array<T, N>& colours)
+constexpr MidiKeyTable
+build_midi_key_table(const std::array<int, 4>& lowest_keys, int range_size,
+                     std::span<const int> colours, bool is_drums,
+                     bool from_five_lane)
 {
-    for (auto min : diff_ranges) {
-        if (key >= min && (key - min) < colours.size()) {
-            return colours.at(key - min);
+    constexpr std::array DIFFICULTIES {
+        SightRead::Difficulty::Expert, SightRead::Difficulty::Hard,
+        SightRead::Difficulty::Medium, SightRead::Difficulty::Easy};
+    constexpr std::array FORCE_HOPO_KEYS {65, 77, 89, 101};
+    constexpr std::array FORCE_STRUM_KEYS {66, 78, 90, 102};
+
+    MidiKeyTable table {};
+    for (auto i = 0U; i < lowest_keys.size(); ++i) {
+        for (auto offset = 0; offset < range_size; ++offset) {
+            const auto key = lowest_keys.at(i) + offset;
+            auto& decoding = table.at(static_cast<std::size_t>(key));
+            decoding.difficulty = DIFFICULTIES.at(i);
+            if (offset < static_cast<int>(colours.size())) {
+                decoding.colour = colours[static_cast<std::size_t>(offset)];
+            }
+            decoding.is_cymbal
+                = is_drums && is_cymbal_key(key, from_five_lane);
         }
     }
-
-    throw SightRead::ParseError("Invalid key for note");
+    if (!is_drums) {
+        for (auto key : FORCE_HOPO_KEYS) {
+            table.at(static_cast<std::size_t>(key)).is_force_hopo = true;
+        }
+        for (auto key : FORCE_STRUM_KEYS) {
+            table.at(static_cast<std::size_t>(key)).is_force_strum = true;
+        }
+    }
+    return table;
 }
 
-int colour_from_key(std::uint8_t key, SightRead::TrackType track_type,
-                    bool from_five_lane)
+template <SightRead::TrackType TrackType, bool FromFiveLane = false>
+constexpr MidiKeyTable make_midi_key_table()
 {
-    std::array<unsigned int, 4> diff_ranges {};
-    switch (track_type) {
-    case SightRead::TrackType::FiveFret:
-    case SightRead::TrackType::FortniteFestival: {
-        diff_ranges = {96, 84, 72, 60}; // NOLINT
-        constexpr std::array NOTE_COLOURS {
-            SightRead::FIVE_FRET_GREEN, SightRead::FIVE_FRET_RED,
-            SightRead::FIVE_FRET_YELLOW, SightRead::FIVE_FRET_BLUE,
-            SightRead::FIVE_FRET_ORANGE};
-        return colour_from_key_and_bounds(key, diff_ranges, NOTE_COLOURS);
-    }
-    case SightRead::TrackType::SixFret: {
-        diff_ranges = {94, 82, 70, 58}; // NOLINT
-        constexpr std::array GHL_NOTE_COLOURS {
+    if constexpr (TrackType == SightRead::TrackType::SixFret) {
+        constexpr std::array<int, 7> GHL_NOTE_COLOURS {
             SightRead::SIX_FRET_OPEN,      SightRead::SIX_FRET_WHITE_LOW,
             SightRead::SIX_FRET_WHITE_MID, SightRead::SIX_FRET_WHITE_HIGH,
             SightRead::SIX_FRET_BLACK_LOW, SightRead::SIX_FRET_BLACK_MID,
             SightRead::SIX_FRET_BLACK_HIGH};
-        return colour_from_key_and_bounds(key, diff_ranges, GHL_NOTE_COLOURS);
-    }
-    case SightRead::TrackType::Drums: {
-        diff_ranges = {95, 83, 71, 59}; // NOLINT
-        constexpr std::array DRUM_NOTE_COLOURS {
+        return build_midi_key_table({94, 82, 70, 58}, 9, // NOLINT
+                                    GHL_NOTE_COLOURS, false, false);
+    } else if constexpr (TrackType == SightRead::TrackType::Drums) {
+        constexpr std::array<int, 6> DRUM_NOTE_COLOURS {
             SightRead::DRUM_DOUBLE_KICK, SightRead::DRUM_KICK,
             SightRead::DRUM_RED,         SightRead::DRUM_YELLOW,
             SightRead::DRUM_BLUE,        SightRead::DRUM_GREEN};
-        constexpr std::array FIVE_LANE_COLOURS {
+        constexpr std::array<int, 7> FIVE_LANE_COLOURS {
             SightRead::DRUM_DOUBLE_KICK, SightRead::DRUM_KICK,
             SightRead::DRUM_RED,         SightRead::DRUM_YELLOW,
             SightRead::DRUM_BLUE,        SightRead::DRUM_GREEN,
             SightRead::DRUM_GREEN};
-        if (from_five_lane) {
-            return colour_from_key_and_bounds(key, diff_ranges,
-                                              FIVE_LANE_COLOURS);
+        if constexpr (FromFiveLane) {
+            return build_midi_key_table({95, 83, 71, 59}, 7, // NOLINT
+                                        FIVE_LANE_COLOURS, true, true);
+        } else {
+            return build_midi_key_table({95, 83, 71, 59}, 7, // NOLINT
+                                        DRUM_NOTE_COLOURS, true, false);
         }
-        return colour_from_key_and_bounds(key, diff_ranges, DRUM_NOTE_COLOURS);
+    } else {
+        constexpr std::array<int, 5> NOTE_COLOURS {
+            SightRead::FIVE_FRET_GREEN, SightRead::FIVE_FRET_RED,
+            SightRead::FIVE_FRET_YELLOW, SightRead::FIVE_FRET_BLUE,
+            SightRead::FIVE_FRET_ORANGE};
+        return build_midi_key_table({96, 84, 72, 60}, 7, // NOLINT
+                                    NOTE_COLOURS, false, false);
     }
+}
+
+template <SightRead::TrackType TrackType, bool FromFiveLane = false>
+constexpr MidiKeyTable MIDI_KEY_TABLE
+    = make_midi_key_table<TrackType, FromFiveLane>();
+
+const MidiKeyDecoding& decode_midi_key(std::uint8_t key,
+                                       SightRead::TrackType track_type,
+                                       bool from_five_lane)
+{
+    using SightRead::TrackType;
+
+    switch (track_type) {
+    case TrackType::FiveFret:
+    case TrackType::FortniteFestival:
+        return MIDI_KEY_TABLE<TrackType::FiveFret>[key];
+    case TrackType::SixFret:
+        return MIDI_KEY_TABLE<TrackType::SixFret>[key];
+    case TrackType::Drums:
+        if (from_five_lane) {
+            return MIDI_KEY_TABLE<TrackType::Drums, true>[key];
+        }
+        return MIDI_KEY_TABLE<TrackType::Drums>[key];
     }
 
     throw std::invalid_argument("Invalid track type");
 }
 
+int note_colour(const MidiKeyDecoding& decoding)
+{
+    if (decoding.colour == -1) {
+        throw SightRead::ParseError("Invalid key for note");
+    }
+    return decoding.colour;
+}
+
 SightRead::NoteFlags flags_from_track_type(SightRead::TrackType track_type)
 {
     switch (track_type) {
@@ -332,15 +370,6 @@ SightRead::NoteFlags flags_from_track_type(SightRead::TrackType track_type)
     throw std::invalid_argument("Invalid track type");
 }
 
-bool is_cymbal_key(std::uint8_t key, bool from_five_lane)
-{
-    const auto index = (key + 1) % 12;
-    if (from_five_lane) {
-        return index == 3 || index == 5; // NOLINT
-    }
-    return index == 3 || index == 4 || index == 5; // NOLINT
-}
-
 SightRead::NoteFlags dynamics_flags_from_velocity(std::uint8_t velocity)
 {
     constexpr std::uint8_t MIN_ACCENT_VELOCITY = 127;
@@ -360,15 +389,15 @@ SightRead::NoteFlags dynamics_flags_from_velocity(std::uint8_t velocity)
 // file have a higher rank. This is in case of the Note Off event being right
 // after the corresponding Note On event in the file, but at the same tick.
 std::vector<std::tuple<int, int>>
-combine_note_on_off_events(const std::vector<std::tuple<int, int>>& on_events,
-                           const std::vector<std::tuple<int, int>>& off_events)
+combine_note_on_off_events(std::span<const std::tuple<int, int>> on_events,
+                           std::span<const std::tuple<int, int>> off_events)
 {
     std::vector<std::tuple<int, int>> ranges;
 
-    auto on_iter = on_events.cbegin();
-    auto off_iter = off_events.cbegin();
+    auto on_iter = on_events.begin();
+    auto off_iter = off_events.begin();
 
-    while (on_iter < on_events.cend() && off_iter < off_events.cend()) {
+    while (on_iter < on_events.end() && off_iter < off_events.end()) {
         if (*on_iter >= *off_iter) {
             ++off_iter;
             continue;
@@ -378,57 +407,200 @@ combine_note_on_off_events(const std::vector<std::tuple<int, int>>& on_events,
         ++off_iter;
     }
 
-    if (on_iter != on_events.cend()) {
+    if (on_iter != on_events.end()) {
         throw SightRead::ParseError("on event has no corresponding off event");
     }
 
     return ranges;
 }
 
+// (position, rank) events grouped by a small dense key. Events are appended in
+// file order into a single pre-reserved buffer, then finalise() groups them by
+// key with a stable counting sort, so each key's events stay in file order and
+// sit contiguously.
+template <std::size_t KeyCount> class BucketedEvents {
+private:
+    struct KeyedEvent {
+        std::size_t key;
+        int position;
+        int rank;
+    };
+
+    std::pmr::vector<KeyedEvent> m_pending_events;
+    std::pmr::vector<std::tuple<int, int>> m_events;
+    std::array<std::size_t, KeyCount + 1> m_offsets {};
+
+public:
+    explicit BucketedEvents(std::pmr::memory_resource* resource)
+        : m_pending_events {resource}
+        , m_events {resource}
+    {
+    }
+
+    void reserve(std::size_t size) { m_pending_events.reserve(size); }
+
+    void add(std::size_t key, int position, int rank)
+    {
+        m_pending_events.push_back({key, position, rank});
+    }
+
+    void finalise()
+    {
+        for (const auto& event : m_pending_events) {
+            ++m_offsets.at(event.key + 1);
+        }
+        for (auto i = 1U; i < m_offsets.size(); ++i) {
+            m_offsets[i] += m_offsets[i - 1];
+        }
+        auto next_slots = m_offsets;
+        m_events.resize(m_pending_events.size());
+        for (const auto& event : m_pending_events) {
+            m_events[next_slots[event.key]++] = {event.position, event.rank};
+        }
+        m_pending_events.clear();
+        m_pending_events.shrink_to_fit();
+    }
+
+    [[nodiscard]] std::span<const std::tuple<int, int>>
+    events(std::size_t key) const
+    {
+        return std::span {m_events}.subspan(m_offsets.at(key),
+                                            m_offsets.at(key + 1)
+                                                - m_offsets.at(key));
+    }
+};
+
+constexpr std::size_t DIFFICULTY_COUNT = 4;
+constexpr std::size_t MAX_LANE_COUNT = 7;
+// Notes on the same lane and difficulty are kept apart by their cymbal, ghost
+// and accent flags, the only flags set while reading a track.
+constexpr std::size_t NOTE_FLAG_VARIANT_COUNT = 8;
+constexpr std::uint32_t NOTE_FLAG_VARIANT_MASK = SightRead::FLAGS_CYMBAL
+    | SightRead::FLAGS_GHOST | SightRead::FLAGS_ACCENT;
+
+std::size_t difficulty_index(SightRead::Difficulty diff)
+{
+    return static_cast<std::size_t>(diff);
+}
+
+std::size_t note_off_key(SightRead::Difficulty diff, int colour)
+{
+    return difficulty_index(diff) * MAX_LANE_COUNT
+        + static_cast<std::size_t>(colour);
+}
+
+// Keys are ordered by difficulty, then colour, then flags so iterating over
+// them in order visits notes in the same order as a map keyed on the tuple
+// (difficulty, colour, flags) would.
+std::size_t note_on_key(SightRead::Difficulty diff, int colour,
+                        SightRead::NoteFlags flags)
+{
+    return note_off_key(diff, colour) * NOTE_FLAG_VARIANT_COUNT
+        + (flags & NOTE_FLAG_VARIANT_MASK);
+}
+
 struct InstrumentMidiTrack {
 public:
-    std::map<std::tuple<SightRead::Difficulty, int, SightRead::NoteFlags>,
-             std::vector<std::tuple<int, int>>>
-        note_on_events;
-    std::map<std::tuple<SightRead::Difficulty, int>,
-             std::vector<std::tuple<int, int>>>
-        note_off_events;
-    std::map<SightRead::Difficulty, std::vector<std::tuple<int, int>>>
-        open_on_events;
-    std::map<SightRead::Difficulty, std::vector<std::tuple<int, int>>>
-        open_off_events;
-    std::vector<std::tuple<int, int>> yellow_tom_on_events;
-    std::vector<std::tuple<int, int>> yellow_tom_off_events;
-    std::vector<std::tuple<int, int>> blue_tom_on_events;
-    std::vector<std::tuple<int, int>> blue_tom_off_events;
-    std::vector<std::tuple<int, int>> green_tom_on_events;
-    std::vector<std::tuple<int, int>> green_tom_off_events;
-    std::vector<std::tuple<int, int>> solo_on_events;
-    std::vector<std::tuple<int, int>> solo_off_events;
-    std::vector<std::tuple<int, int>> sp_on_events;
-    std::vector<std::tuple<int, int>> sp_off_events;
-    std::vector<std::tuple<int, int>> tap_on_events;
-    std::vector<std::tuple<int, int>> tap_off_events;
-    std::map<SightRead::Difficulty, std::vector<std::tuple<int, int>>>
-        force_hopo_on_events;
-    std::map<SightRead::Difficulty, std::vector<std::tuple<int, int>>>
-        force_hopo_off_events;
-    std::map<SightRead::Difficulty, std::vector<std::tuple<int, int>>>
-        force_strum_on_events;
-    std::map<SightRead::Difficulty, std::vector<std::tuple<int, int>>>
-        force_strum_off_events;
-    std::vector<std::tuple<int, int>> fill_on_events;
-    std::vector<std::tuple<int, int>> fill_off_events;
-    std::map<SightRead::Difficulty, std::vector<std::tuple<int, int>>>
-        disco_flip_on_events;
-    std::map<SightRead::Difficulty, std::vector<std::tuple<int, int>>>
-        disco_flip_off_events;
+    using EventList = std::pmr::vector<std::tuple<int, int>>;
+    using DifficultyEventLists = std::array<EventList, DIFFICULTY_COUNT>;
+
+    static constexpr std::size_t NOTE_ON_KEY_COUNT
+        = DIFFICULTY_COUNT * MAX_LANE_COUNT * NOTE_FLAG_VARIANT_COUNT;
+    static constexpr std::size_t NOTE_OFF_KEY_COUNT
+        = DIFFICULTY_COUNT * MAX_LANE_COUNT;
+
+    BucketedEvents<NOTE_ON_KEY_COUNT> note_on_events;
+    BucketedEvents<NOTE_OFF_KEY_COUNT> note_off_events;
+    // The track type flag of every note, which the flags in note_on_key are
+    // combined with.
+    SightRead::NoteFlags base_note_flags {SightRead::FLAGS_NONE};
+    DifficultyEventLists open_on_events;
+    DifficultyEventLists open_off_events;
+    EventList yellow_tom_on_events;
+    EventList yellow_tom_off_events;
+    EventList blue_tom_on_events;
+    EventList blue_tom_off_events;
+    EventList green_tom_on_events;
+    EventList green_tom_off_events;
+    EventList solo_on_events;
+    EventList solo_off_events;
+    EventList sp_on_events;
+    EventList sp_off_events;
+    EventList tap_on_events;
+    EventList tap_off_events;
+    DifficultyEventLists force_hopo_on_events;
+    DifficultyEventLists force_hopo_off_events;
+    DifficultyEventLists force_strum_on_events;
+    DifficultyEventLists force_strum_off_events;
+    EventList fill_on_events;
+    EventList fill_off_events;
+    DifficultyEventLists disco_flip_on_events;
+    DifficultyEventLists disco_flip_off_events;
+
+    // Everything is allocated from resource, which is that of the track being
+    // read.
+    explicit InstrumentMidiTrack(std::pmr::memory_resource* resource)
+        : note_on_events {resource}
+        , note_off_events {resource}
+        , open_on_events {event_lists(resource)}
+        , open_off_events {event_lists(resource)}
+        , yellow_tom_on_events {resource}
+        , yellow_tom_off_events {resource}
+        , blue_tom_on_events {resource}
+        , blue_tom_off_events {resource}
+        , green_tom_on_events {resource}
+        , green_tom_off_events {resource}
+        , solo_on_events {resource}
+        , solo_off_events {resource}
+        , sp_on_events {resource}
+        , sp_off_events {resource}
+        , tap_on_events {resource}
+        , tap_off_events {resource}
+        , force_hopo_on_events {event_lists(resource)}
+        , force_hopo_off_events {event_lists(resource)}
+        , force_strum_on_events {event_lists(resource)}
+        , force_strum_off_events {event_lists(resource)}
+        , fill_on_events {resource}
+        , fill_off_events {resource}
+        , disco_flip_on_events {event_lists(resource)}
+        , disco_flip_off_events {event_lists(resource)}
+    {
+    }
+
+    static DifficultyEventLists event_lists(std::pmr::memory_resource* resource)
+    {
+        return {EventList {resource}, EventList {resource},
+                EventList {resource}, EventList {resource}};
+    }
 
-    InstrumentMidiTrack() = default;
+    // Calls func(diff, colour, flags, note_ons) for each (difficulty, colour,
+    // flags) combination with at least one Note On event.
+    template <typename F> void for_each_note_on_group(F func) const
+    {
+        constexpr std::array DIFFICULTIES {
+            SightRead::Difficulty::Easy, SightRead::Difficulty::Medium,
+            SightRead::Difficulty::Hard, SightRead::Difficulty::Expert};
+
+        for (auto diff : DIFFICULTIES) {
+            for (auto colour = 0; colour < static_cast<int>(MAX_LANE_COUNT);
+                 ++colour) {
+                for (auto variant = 0U; variant < NOTE_FLAG_VARIANT_COUNT;
+                     ++variant) {
+                    const auto flags = static_cast<SightRead::NoteFlags>(
+                        base_note_flags | variant);
+                    const auto note_ons = note_on_events.events(
+                        note_on_key(diff, colour, flags));
+                    if (!note_ons.empty()) {
+                        func(diff, colour, flags, note_ons);
+                    }
+                }
+            }
+        }
+    }
 };
 
 void add_sysex_event(InstrumentMidiTrack& track,
-                     const SightRead::Detail::SysexEvent& event, int time,
+                     const SightRead::Detail::SysexEventView& event, int time,
                      int rank)
 {
     constexpr std::array<SightRead::Difficulty, 4> OPEN_EVENT_DIFFS {
@@ -441,15 +613,15 @@ void add_sysex_event(InstrumentMidiTrack& track,
     }
     const auto diff = OPEN_EVENT_DIFFS.at(event.data[4]);
     if (event.data[SYSEX_ON_INDEX] == 0) {
-        track.open_off_events[diff].emplace_back(time, rank);
+        track.open_off_events[difficulty_index(diff)].emplace_back(time, rank);
     } else {
-        track.open_on_events[diff].emplace_back(time, rank);
+        track.open_on_events[difficulty_index(diff)].emplace_back(time, rank);
     }
 }
 
 void append_disco_flip(InstrumentMidiTrack& event_track,
-                       const SightRead::Detail::MetaEvent& meta_event, int time,
-                       int rank)
+                       const SightRead::Detail::MetaEventView& meta_event,
+                       int time, int rank)
 {
     constexpr int FLIP_START_SIZE = 15;
     constexpr int FLIP_END_SIZE = 14;
@@ -465,43 +637,28 @@ void append_disco_flip(InstrumentMidiTrack& event_track,
         && meta_event.data.size() != FLIP_END_SIZE) {
         return;
     }
-    if (!std::equal(MIX.cbegin(), MIX.cend(), meta_event.data.cbegin())) {
+    if (!std::equal(MIX.cbegin(), MIX.cend(), meta_event.data.begin())) {
         return;
     }
     if (!std::equal(DRUMS.cbegin(), DRUMS.cend(),
-                    meta_event.data.cbegin() + MIX.size() + 1)) {
+                    meta_event.data.begin() + MIX.size() + 1)) {
+        return;
+    }
+    const auto diff_digit = meta_event.data[MIX.size()];
+    if (diff_digit < '0' || diff_digit > '3') {
         return;
     }
-    const auto diff
-        = static_cast<SightRead::Difficulty>(meta_event.data[MIX.size()] - '0');
+    const auto diff = static_cast<SightRead::Difficulty>(diff_digit - '0');
     if (meta_event.data.size() == FLIP_END_SIZE
         && meta_event.data[FLIP_END_SIZE - 1] == ']') {
-        event_track.disco_flip_off_events[diff].emplace_back(time, rank);
+        event_track.disco_flip_off_events[difficulty_index(diff)].emplace_back(
+            time, rank);
     } else if (meta_event.data.size() == FLIP_START_SIZE
                && meta_event.data[FLIP_START_SIZE - 2] == 'd'
                && meta_event.data[FLIP_START_SIZE - 1] == ']') {
-        event_track.disco_flip_on_events[diff].emplace_back(time, rank);
-    }
-}
-
-bool force_hopo_key(std::uint8_t key, SightRead::TrackType track_type)
-{
-    constexpr std::array FORCE_HOPO_KEYS {65, 77, 89, 101};
-    if (track_type == SightRead::TrackType::Drums) {
-        return false;
-    }
-    return std::find(FORCE_HOPO_KEYS.cbegin(), FORCE_HOPO_KEYS.cend(), key)
-        != FORCE_HOPO_KEYS.cend();
-}
-
-bool force_strum_key(std::uint8_t key, SightRead::TrackType track_type)
-{
-    constexpr std::array FORCE_STRUM_KEYS {66, 78, 90, 102};
-    if (track_type == SightRead::TrackType::Drums) {
-        return false;
+        event_track.disco_flip_on_events[difficulty_index(diff)].emplace_back(
+            time, rank);
     }
-    return std::find(FORCE_STRUM_KEYS.cbegin(), FORCE_STRUM_KEYS.cend(), key)
-        != FORCE_STRUM_KEYS.cend();
 }
 
 void add_note_off_event(InstrumentMidiTrack& track,
@@ -517,16 +674,18 @@ void add_note_off_event(InstrumentMidiTrack& track,
     constexpr int TAP_NOTE_ID = 104;
     constexpr int DRUM_FILL_ID = 120;
 
-    const auto diff = difficulty_from_key(data[0], track_type);
+    const auto& decoding = decode_midi_key(data[0], track_type, from_five_lane);
+    const auto diff = decoding.difficulty;
     if (diff.has_value()) {
-        if (force_hopo_key(data[0], track_type)) {
-            track.force_hopo_off_events[*diff].emplace_back(time, rank);
-        } else if (force_strum_key(data[0], track_type)) {
-            track.force_strum_off_events[*diff].emplace_back(time, rank);
+        if (decoding.is_force_hopo) {
+            track.force_hopo_off_events[difficulty_index(*diff)].emplace_back(
+                time, rank);
+        } else if (decoding.is_force_strum) {
+            track.force_strum_off_events[difficulty_index(*diff)].emplace_back(
+                time, rank);
         } else {
-            const auto colour
-                = colour_from_key(data[0], track_type, from_five_lane);
-            track.note_off_events[{*diff, colour}].emplace_back(time, rank);
+            track.note_off_events.add(
+                note_off_key(*diff, note_colour(decoding)), time, rank);
         }
     } else if (data[0] == YELLOW_TOM_ID) {
         track.yellow_tom_off_events.emplace_back(time, rank);
@@ -564,17 +723,20 @@ void add_note_on_event(InstrumentMidiTrack& track,
         return;
     }
 
-    const auto diff = difficulty_from_key(data[0], track_type);
+    const auto& decoding = decode_midi_key(data[0], track_type, from_five_lane);
+    const auto diff = decoding.difficulty;
     if (diff.has_value()) {
-        if (force_hopo_key(data[0], track_type)) {
-            track.force_hopo_on_events[*diff].emplace_back(time, rank);
-        } else if (force_strum_key(data[0], track_type)) {
-            track.force_strum_on_events[*diff].emplace_back(time, rank);
+        if (decoding.is_force_hopo) {
+            track.force_hopo_on_events[difficulty_index(*diff)].emplace_back(
+                time, rank);
+        } else if (decoding.is_force_strum) {
+            track.force_strum_on_events[difficulty_index(*diff)].emplace_back(
+                time, rank);
         } else {
-            auto colour = colour_from_key(data[0], track_type, from_five_lane);
+            const auto colour = note_colour(decoding);
             auto flags = flags_from_track_type(track_type);
             if (track_type == SightRead::TrackType::Drums) {
-                if (is_cymbal_key(data[0], from_five_lane)) {
+                if (decoding.is_cymbal) {
                     flags = static_cast<SightRead::NoteFlags>(
                         flags | SightRead::FLAGS_CYMBAL);
                 }
@@ -583,8 +745,8 @@ void add_note_on_event(InstrumentMidiTrack& track,
                         flags | dynamics_flags_from_velocity(data[1]));
                 }
             }
-            track.note_on_events[{*diff, colour, flags}].emplace_back(time,
-                                                                      rank);
+            track.note_on_events.add(note_on_key(*diff, colour, flags), time,
+                                     rank);
         }
     } else if (data[0] == YELLOW_TOM_ID) {
         track.yellow_tom_on_events.emplace_back(time, rank);
@@ -604,7 +766,7 @@ void add_note_on_event(InstrumentMidiTrack& track,
 }
 
 InstrumentMidiTrack
-read_instrument_midi_track(const SightRead::Detail::MidiTrack& midi_track,
+read_instrument_midi_track(const SightRead::Detail::MidiTrackView& midi_track,
                            SightRead::TrackType track_type)
 {
     constexpr int NOTE_OFF_ID = 0x80;
@@ -619,15 +781,11 @@ read_instrument_midi_track(const SightRead::Detail::MidiTrack& midi_track,
     const bool parse_dynamics = track_type == SightRead::TrackType::Drums
         && has_enable_chart_dynamics(midi_track);
 
-    InstrumentMidiTrack event_track;
-    for (auto d : DIFFICULTIES) {
-        event_track.disco_flip_on_events[d] = {};
-        event_track.disco_flip_off_events[d] = {};
-        event_track.force_hopo_on_events[d] = {};
-        event_track.force_hopo_off_events[d] = {};
-        event_track.force_strum_on_events[d] = {};
-        event_track.force_strum_off_events[d] = {};
-    }
+    InstrumentMidiTrack event_track {
+        midi_track.events.get_allocator().resource()};
+    event_track.base_note_flags = flags_from_track_type(track_type);
+    event_track.note_on_events.reserve(midi_track.events.size());
+    event_track.note_off_events.reserve(midi_track.events.size());
 
     int rank = 0;
     for (const auto& event : midi_track.events) {
@@ -636,14 +794,15 @@ read_instrument_midi_track(const SightRead::Detail::MidiTrack& midi_track,
             = std::get_if<SightRead::Detail::MidiEvent>(&event.event);
         if (midi_event == nullptr) {
             const auto* sysex_event
-                = std::get_if<SightRead::Detail::SysexEvent>(&event.event);
+                = std::get_if<SightRead::Detail::SysexEventView>(&event.event);
             if (sysex_event != nullptr) {
                 add_sysex_event(event_track, *sysex_event, event.time, rank);
                 continue;
             }
             if (track_type == SightRead::TrackType::Drums) {
                 const auto* meta_event
-                    = std::get_if<SightRead::Detail::MetaEvent>(&event.event);
+                    = std::get_if<SightRead::Detail::MetaEventView>(
+                        &event.event);
                 if (meta_event != nullptr) {
                     append_disco_flip(event_track, *meta_event, event.time,
                                       rank);
@@ -664,14 +823,12 @@ read_instrument_midi_track(const SightRead::Detail::MidiTrack& midi_track,
         }
     }
 
-    event_track.disco_flip_off_events.at(SightRead::Difficulty::Easy)
-        .emplace_back(std::numeric_limits<int>::max(), ++rank);
-    event_track.disco_flip_off_events.at(SightRead::Difficulty::Medium)
-        .emplace_back(std::numeric_limits<int>::max(), ++rank);
-    event_track.disco_flip_off_events.at(SightRead::Difficulty::Hard)
-        .emplace_back(std::numeric_limits<int>::max(), ++rank);
-    event_track.disco_flip_off_events.at(SightRead::Difficulty::Expert)
-        .emplace_back(std::numeric_limits<int>::max(), ++rank);
+    for (auto d : DIFFICULTIES) {
+        event_track.disco_flip_off_events.at(difficulty_index(d))
+            .emplace_back(std::numeric_limits<int>::max(), ++rank);
+    }
+    event_track.note_on_events.finalise();
+    event_track.note_off_events.finalise();
 
     if (event_track.sp_on_events.empty()
         && event_track.solo_on_events.size() > 1) {
@@ -711,20 +868,21 @@ notes_from_event_track(
         force_strum_events;
     for (auto d : DIFFICULTIES) {
         force_hopo_events[d] = combine_note_on_off_events(
-            event_track.force_hopo_on_events.at(d),
-            event_track.force_hopo_off_events.at(d));
+            event_track.force_hopo_on_events.at(difficulty_index(d)),
+            event_track.force_hopo_off_events.at(difficulty_index(d)));
         force_strum_events[d] = combine_note_on_off_events(
-            event_track.force_strum_on_events.at(d),
-            event_track.force_strum_off_events.at(d));
+            event_track.force_strum_on_events.at(difficulty_index(d)),
+            event_track.force_strum_off_events.at(difficulty_index(d)));
     }
 
     std::map<SightRead::Difficulty, std::vector<SightRead::Note>> notes;
-    for (const auto& [key, note_ons] : event_track.note_on_events) {
-        const auto& [diff, colour, flags] = key;
-        if (!event_track.note_off_events.contains({diff, colour})) {
+    event_track.for_each_note_on_group([&](auto diff, auto colour, auto,
+                                           auto note_ons) {
+        const auto note_offs
+            = event_track.note_off_events.events(note_off_key(diff, colour));
+        if (note_offs.empty()) {
             throw SightRead::ParseError("No corresponding Note Off events");
         }
-        const auto& note_offs = event_track.note_off_events.at({diff, colour});
         for (const auto& [pos, end] :
              combine_note_on_off_events(note_ons, note_offs)) {
             const auto note_length = end - pos;
@@ -756,15 +914,24 @@ notes_from_event_track(
             }
             notes[diff].push_back(note);
         }
-    }
+    });
 
     return notes;
 }
 
+template <typename... Args>
+SightRead::NoteTrack timed_note_track(SightRead::Detail::PhaseSink sink,
+                                      Args&&... args)
+{
+    const SightRead::Detail::PhaseTimer timer {sink};
+    return SightRead::NoteTrack {std::forward<Args>(args)...};
+}
+
 std::map<SightRead::Difficulty, SightRead::NoteTrack> ghl_note_tracks_from_midi(
-    const SightRead::Detail::MidiTrack& midi_track,
+    const SightRead::Detail::MidiTrackView& midi_track,
     const std::shared_ptr<SightRead::SongGlobalData>& global_data,
-    const SightRead::HopoThreshold& hopo_threshold, bool permit_solos)
+    const SightRead::HopoThreshold& hopo_threshold, bool permit_solos,
+    SightRead::Detail::PhaseSink note_track_sink)
 {
     const auto event_track
         = read_instrument_midi_track(midi_track, SightRead::TrackType::SixFret);
@@ -796,9 +963,10 @@ std::map<SightRead::Difficulty, SightRead::NoteTrack> ghl_note_tracks_from_midi(
         if (!permit_solos) {
             solos.clear();
         }
-        SightRead::NoteTrack note_track {
-            note_set, sp_phrases, SightRead::TrackType::SixFret, global_data,
-            hopo_threshold.midi_max_hopo_gap(global_data->resolution())};
+        auto note_track = timed_note_track(
+            note_track_sink, note_set, sp_phrases,
+            SightRead::TrackType::SixFret, global_data,
+            hopo_threshold.midi_max_hopo_gap(global_data->resolution()));
         note_track.solos(std::move(solos));
         note_tracks.emplace(diff, std::move(note_track));
     }
@@ -852,21 +1020,26 @@ public:
 // cymbal + B tom. This combination cannot happen from a four lane chart.
 void fix_double_greens(std::vector<SightRead::Note>& notes)
 {
-    std::set<SightRead::Tick> green_cymbal_positions;
+    std::vector<SightRead::Tick> green_cymbal_positions;
 
     for (const auto& note : notes) {
         if ((note.lengths.at(SightRead::DRUM_GREEN) != SightRead::Tick {-1})
             && ((note.flags & SightRead::FLAGS_CYMBAL) != 0U)) {
-            green_cymbal_positions.insert(note.position);
+            green_cymbal_positions.push_back(note.position);
         }
     }
+    if (green_cymbal_positions.empty()) {
+        return;
+    }
+    std::sort(green_cymbal_positions.begin(), green_cymbal_positions.end());
 
     for (auto& note : notes) {
         if ((note.lengths.at(SightRead::DRUM_GREEN) == SightRead::Tick {-1})
             || ((note.flags & SightRead::FLAGS_CYMBAL) != 0U)) {
             continue;
         }
-        if (green_cymbal_positions.contains(note.position)) {
+        if (std::binary_search(green_cymbal_positions.cbegin(),
+                               green_cymbal_positions.cend(), note.position)) {
             std::swap(note.lengths[SightRead::DRUM_BLUE],
                       note.lengths[SightRead::DRUM_GREEN]);
         }
@@ -875,9 +1048,9 @@ void fix_double_greens(std::vector<SightRead::Note>& notes)
 
 std::map<SightRead::Difficulty, SightRead::NoteTrack>
 drum_note_tracks_from_midi(
-    const SightRead::Detail::MidiTrack& midi_track,
+    const SightRead::Detail::MidiTrackView& midi_track,
     const std::shared_ptr<SightRead::SongGlobalData>& global_data,
-    bool permit_solos)
+    bool permit_solos, SightRead::Detail::PhaseSink note_track_sink)
 {
     const auto event_track
         = read_instrument_midi_track(midi_track, SightRead::TrackType::Drums);
@@ -885,14 +1058,13 @@ drum_note_tracks_from_midi(
     const TomEvents tom_events {event_track};
 
     std::map<SightRead::Difficulty, std::vector<SightRead::Note>> notes;
-    for (const auto& [key, note_ons] : event_track.note_on_events) {
-        const auto& [diff, colour, flags] = key;
-        const std::tuple<SightRead::Difficulty, int> no_flags_key {diff,
-                                                                   colour};
-        if (!event_track.note_off_events.contains(no_flags_key)) {
+    event_track.for_each_note_on_group([&](auto diff, auto colour, auto flags,
+                                           auto note_ons) {
+        const auto note_offs
+            = event_track.note_off_events.events(note_off_key(diff, colour));
+        if (note_offs.empty()) {
             throw SightRead::ParseError("No corresponding Note Off events");
         }
-        const auto& note_offs = event_track.note_off_events.at(no_flags_key);
         for (const auto& [pos, end] :
              combine_note_on_off_events(note_ons, note_offs)) {
             SightRead::Note note;
@@ -907,7 +1079,7 @@ drum_note_tracks_from_midi(
             notes[diff].push_back(note);
         }
         fix_double_greens(notes[diff]);
-    }
+    });
 
     std::vector<SightRead::StarPower> sp_phrases;
     for (const auto& [start, end] : combine_note_on_off_events(
@@ -936,9 +1108,10 @@ drum_note_tracks_from_midi(
             solo_offs.push_back(pos);
         }
         std::vector<SightRead::DiscoFlip> disco_flips;
+        const auto diff_index = difficulty_index(diff);
         for (const auto& [start, end] : combine_note_on_off_events(
-                 event_track.disco_flip_on_events.at(diff),
-                 event_track.disco_flip_off_events.at(diff))) {
+                 event_track.disco_flip_on_events.at(diff_index),
+                 event_track.disco_flip_off_events.at(diff_index))) {
             disco_flips.push_back(
                 {SightRead::Tick {start}, SightRead::Tick {end - start}});
         }
@@ -947,8 +1120,9 @@ drum_note_tracks_from_midi(
         if (!permit_solos) {
             solos.clear();
         }
-        SightRead::NoteTrack note_track {
-            note_set, sp_phrases, SightRead::TrackType::Drums, global_data};
+        auto note_track
+            = timed_note_track(note_track_sink, note_set, sp_phrases,
+                               SightRead::TrackType::Drums, global_data);
         note_track.solos(std::move(solos));
         note_track.drum_fills(drum_fills);
         note_track.disco_flips(std::move(disco_flips));
@@ -959,7 +1133,7 @@ drum_note_tracks_from_midi(
 }
 
 std::optional<SightRead::BigRockEnding>
-read_bre(const SightRead::Detail::MidiTrack& midi_track)
+read_bre(const SightRead::Detail::MidiTrackView& midi_track)
 {
     constexpr int BRE_KEY = 120;
     constexpr int NOTE_OFF_ID = 0x80;
@@ -1001,11 +1175,66 @@ bool is_fortnite_instrument(SightRead::Instrument instrument)
     return fortnite_instruments.contains(instrument);
 }
 
+SightRead::TrackType midi_track_type(SightRead::Instrument instrument)
+{
+    if (is_fortnite_instrument(instrument)) {
+        return SightRead::TrackType::FortniteFestival;
+    }
+    if (SightRead::Detail::is_six_fret_instrument(instrument)) {
+        return SightRead::TrackType::SixFret;
+    }
+    if (instrument == SightRead::Instrument::Drums) {
+        return SightRead::TrackType::Drums;
+    }
+    return SightRead::TrackType::FiveFret;
+}
+
+struct MidiGemCounts {
+    std::array<int, DIFFICULTY_COUNT> note_counts {};
+    int end {0};
+};
+
+MidiGemCounts
+count_midi_gems(const SightRead::Detail::MidiTrackView& midi_track,
+                SightRead::TrackType track_type)
+{
+    constexpr int NOTE_OFF_ID = 0x80;
+    constexpr int NOTE_ON_ID = 0x90;
+    constexpr int UPPER_NIBBLE_MASK = 0xF0;
+
+    const bool from_five_lane = track_type == SightRead::TrackType::Drums
+        && has_five_lane_green_notes(midi_track);
+
+    MidiGemCounts counts;
+    for (const auto& event : midi_track.events) {
+        const auto* midi_event
+            = std::get_if<SightRead::Detail::MidiEvent>(&event.event);
+        if (midi_event == nullptr) {
+            continue;
+        }
+        const auto event_type = midi_event->status & UPPER_NIBBLE_MASK;
+        if (event_type != NOTE_ON_ID && event_type != NOTE_OFF_ID) {
+            continue;
+        }
+        const auto& decoding
+            = decode_midi_key(midi_event->data[0], track_type, from_five_lane);
+        if (!decoding.difficulty.has_value() || decoding.colour == -1
+            || decoding.is_force_hopo || decoding.is_force_strum) {
+            continue;
+        }
+        counts.end = std::max(counts.end, event.time);
+        if (event_type == NOTE_ON_ID && midi_event->data[1] != 0) {
+            ++counts.note_counts.at(difficulty_index(*decoding.difficulty));
+        }
+    }
+    return counts;
+}
+
 std::map<SightRead::Difficulty, SightRead::NoteTrack>
 fortnite_note_tracks_from_midi(
-    const SightRead::Detail::MidiTrack& midi_track,
+    const SightRead::Detail::MidiTrackView& midi_track,
     const std::shared_ptr<SightRead::SongGlobalData>& global_data,
-    bool permit_solos)
+    bool permit_solos, SightRead::Detail::PhaseSink note_track_sink)
 {
     const auto event_track = read_instrument_midi_track(
         midi_track, SightRead::TrackType::FortniteFestival);
@@ -1039,9 +1268,9 @@ fortnite_note_tracks_from_midi(
         if (!permit_solos) {
             solos.clear();
         }
-        SightRead::NoteTrack note_track {note_set, sp_phrases,
-                                         SightRead::TrackType::FortniteFestival,
-                                         global_data};
+        auto note_track = timed_note_track(
+            note_track_sink, note_set, sp_phrases,
+            SightRead::TrackType::FortniteFestival, global_data);
         note_track.solos(std::move(solos));
         note_track.bre(bre);
         note_tracks.emplace(diff, std::move(note_track));
@@ -1051,9 +1280,10 @@ fortnite_note_tracks_from_midi(
 }
 
 std::map<SightRead::Difficulty, SightRead::NoteTrack> note_tracks_from_midi(
-    const SightRead::Detail::MidiTrack& midi_track,
+    const SightRead::Detail::MidiTrackView& midi_track,
     const std::shared_ptr<SightRead::SongGlobalData>& global_data,
-    const SightRead::HopoThreshold& hopo_threshold, bool permit_solos)
+    const SightRead::HopoThreshold& hopo_threshold, bool permit_solos,
+    SightRead::Detail::PhaseSink note_track_sink)
 {
     const auto event_track = read_instrument_midi_track(
         midi_track, SightRead::TrackType::FiveFret);
@@ -1061,12 +1291,17 @@ std::map<SightRead::Difficulty, SightRead::NoteTrack> note_tracks_from_midi(
 
     std::map<SightRead::Difficulty, std::vector<std::tuple<int, int>>>
         open_events;
-    for (const auto& [diff, open_ons] : event_track.open_on_events) {
-        if (!event_track.open_off_events.contains(diff)) {
+    for (auto i = 0U; i < DIFFICULTY_COUNT; ++i) {
+        const auto& open_ons = event_track.open_on_events.at(i);
+        if (open_ons.empty()) {
+            continue;
+        }
+        const auto& open_offs = event_track.open_off_events.at(i);
+        if (open_offs.empty()) {
             throw SightRead::ParseError("No open Note Off events");
         }
-        const auto& open_offs = event_track.open_off_events.at(diff);
-        open_events[diff] = combine_note_on_off_events(open_ons, open_offs);
+        open_events[static_cast<SightRead::Difficulty>(i)]
+            = combine_note_on_off_events(open_ons, open_offs);
     }
 
     const auto notes = notes_from_event_track(event_track, open_events,
@@ -1097,9 +1332,10 @@ std::map<SightRead::Difficulty, SightRead::NoteTrack> note_tracks_from_midi(
         if (!permit_solos) {
             solos.clear();
         }
-        SightRead::NoteTrack note_track {
-            note_set, sp_phrases, SightRead::TrackType::FiveFret, global_data,
-            hopo_threshold.midi_max_hopo_gap(global_data->resolution())};
+        auto note_track = timed_note_track(
+            note_track_sink, note_set, sp_phrases,
+            SightRead::TrackType::FiveFret, global_data,
+            hopo_threshold.midi_max_hopo_gap(global_data->resolution()));
         note_track.solos(std::move(solos));
         note_track.bre(bre);
         note_tracks.emplace(diff, std::move(note_track));
@@ -1117,6 +1353,7 @@ SightRead::Detail::MidiConverter::MidiConverter(SightRead::Metadata metadata)
                         SightRead::Tick {0}}
     , m_permitted_instruments {SightRead::all_instruments()}
     , m_permit_solos {true}
+    , m_thread_count {1}
 {
 }
 
@@ -1143,11 +1380,18 @@ SightRead::Detail::MidiConverter::parse_solos(bool permit_solos)
     return *this;
 }
 
+SightRead::Detail::MidiConverter&
+SightRead::Detail::MidiConverter::threads(unsigned int thread_count)
+{
+    m_thread_count = thread_count;
+    return *this;
+}
+
 std::optional<SightRead::Instrument>
 SightRead::Detail::MidiConverter::midi_section_instrument(
-    const std::string& track_name) const
+    std::string_view track_name) const
 {
-    const std::map<std::string, std::vector<SightRead::Instrument>>
+    const std::map<std::string_view, std::vector<SightRead::Instrument>>
         INSTRUMENTS {
             {"PART GUITAR",
              {SightRead::Instrument::FortniteGuitar,
@@ -1180,57 +1424,86 @@ SightRead::Detail::MidiConverter::midi_section_instrument(
     return std::nullopt;
 }
 
-void SightRead::Detail::MidiConverter::process_instrument_track(
-    const std::string& track_name, const SightRead::Detail::MidiTrack& track,
-    SightRead::Song& song) const
+std::map<SightRead::Difficulty, SightRead::NoteTrack>
+SightRead::Detail::MidiConverter::instrument_note_tracks(
+    SightRead::Instrument inst, const SightRead::Detail::MidiTrackView& track,
+    const std::shared_ptr<SightRead::SongGlobalData>& global_data,
+    SightRead::Detail::PhaseSink note_track_sink) const
 {
-    const auto inst = midi_section_instrument(track_name);
-    if (!inst.has_value()) {
-        return;
+    if (is_fortnite_instrument(inst)) {
+        return fortnite_note_tracks_from_midi(track, global_data,
+                                              m_permit_solos, note_track_sink);
     }
-    if (is_fortnite_instrument(*inst)) {
-        auto tracks = fortnite_note_tracks_from_midi(
-            track, song.global_data_ptr(), m_permit_solos);
-        for (auto& [diff, note_track] : tracks) {
-            song.add_note_track(*inst, diff, std::move(note_track));
-        }
-    } else if (SightRead::Detail::is_six_fret_instrument(*inst)) {
-        auto tracks = ghl_note_tracks_from_midi(
-            track, song.global_data_ptr(), m_hopo_threshold, m_permit_solos);
-        for (auto& [diff, note_track] : tracks) {
-            song.add_note_track(*inst, diff, std::move(note_track));
-        }
-    } else if (*inst == SightRead::Instrument::Drums) {
-        auto tracks = drum_note_tracks_from_midi(track, song.global_data_ptr(),
-                                                 m_permit_solos);
-        for (auto& [diff, note_track] : tracks) {
-            song.add_note_track(SightRead::Instrument::Drums, diff,
-                                std::move(note_track));
-        }
-    } else {
-        auto tracks = note_tracks_from_midi(track, song.global_data_ptr(),
-                                            m_hopo_threshold, m_permit_solos);
-        for (auto& [diff, note_track] : tracks) {
-            song.add_note_track(*inst, diff, std::move(note_track));
-        }
+    if (SightRead::Detail::is_six_fret_instrument(inst)) {
+        return ghl_note_tracks_from_midi(track, global_data, m_hopo_threshold,
+                                         m_permit_solos, note_track_sink);
+    }
+    if (inst == SightRead::Instrument::Drums) {
+        return drum_note_tracks_from_midi(track, global_data, m_permit_solos,
+                                          note_track_sink);
     }
+    return note_tracks_from_midi(track, global_data, m_hopo_threshold,
+                                 m_permit_solos, note_track_sink);
 }
 
 SightRead::Song SightRead::Detail::MidiConverter::convert(
     const SightRead::Detail::Midi& midi) const
 {
-    if (midi.ticks_per_quarter_note == 0) {
+    return convert(SightRead::Detail::make_midi_view(midi));
+}
+
+SightRead::Song SightRead::Detail::MidiConverter::make_empty_song(
+    int ticks_per_quarter_note) const
+{
+    if (ticks_per_quarter_note == 0) {
         throw SightRead::ParseError("Resolution must be > 0");
     }
 
     SightRead::Song song;
 
     song.global_data().is_from_midi(true);
-    song.global_data().resolution(midi.ticks_per_quarter_note);
+    song.global_data().resolution(ticks_per_quarter_note);
     song.global_data().name(m_song_name);
     song.global_data().artist(m_artist);
     song.global_data().charter(m_charter);
 
+    return song;
+}
+
+bool SightRead::Detail::MidiConverter::process_global_track(
+    std::string_view track_name,
+    const SightRead::Detail::MidiTrackView& track, SightRead::Song& song) const
+{
+    if (track_name == "BEAT") {
+        song.global_data().od_beats(od_beats_from_track(track));
+        return true;
+    }
+    if (track_name == "EVENTS") {
+        song.global_data().practice_sections(
+            practice_sections_from_track(track));
+        return true;
+    }
+    return false;
+}
+
+void SightRead::Detail::MidiConverter::apply_od_beats(
+    SightRead::Song& song) const
+{
+    const auto& od_beats = song.global_data().od_beats();
+    if (!od_beats.empty()) {
+        auto old_tempo_map = song.global_data().tempo_map();
+        SightRead::TempoMap new_tempo_map {old_tempo_map.time_sigs(),
+                                           old_tempo_map.bpms(), od_beats,
+                                           song.global_data().resolution()};
+        song.global_data().tempo_map(new_tempo_map);
+    }
+}
+
+SightRead::Song SightRead::Detail::MidiConverter::convert(
+    const SightRead::Detail::MidiView& midi) const
+{
+    auto song = make_empty_song(midi.ticks_per_quarter_note);
+
     if (midi.tracks.empty()) {
         return song;
     }
@@ -1238,29 +1511,214 @@ SightRead::Song SightRead::Detail::MidiConverter::convert(
     song.global_data().tempo_map(
         read_first_midi_track(midi.tracks[0], midi.ticks_per_quarter_note));
 
+    std::vector<std::tuple<SightRead::Instrument,
+                           const SightRead::Detail::MidiTrackView*>>
+        instrument_tracks;
     for (const auto& track : midi.tracks) {
         const auto track_name = midi_track_name(track);
+        if (!track_name.has_value()
+            || process_global_track(*track_name, track, song)) {
+            continue;
+        }
+        const auto inst = midi_section_instrument(*track_name);
+        if (inst.has_value()) {
+            instrument_tracks.emplace_back(*inst, &track);
+        }
+    }
+
+    const auto global_data = song.global_data_ptr();
+    auto note_tracks = parallel_map(
+        instrument_tracks.size(), m_thread_count, [&](std::size_t i) {
+            const auto& [inst, track] = instrument_tracks[i];
+            return instrument_note_tracks(inst, *track, global_data);
+        });
+    for (auto i = 0U; i < note_tracks.size(); ++i) {
+        const auto inst = std::get<0>(instrument_tracks[i]);
+        for (auto& [diff, note_track] : note_tracks[i]) {
+            song.add_note_track(inst, diff, std::move(note_track));
+        }
+    }
+
+    apply_od_beats(song);
+
+    return song;
+}
+
+SightRead::Song SightRead::Detail::MidiConverter::convert(
+    const SightRead::Detail::MidiIndex& midi,
+    SightRead::ParseStats* stats) const
+{
+    auto song = make_empty_song(midi.ticks_per_quarter_note);
+
+    if (midi.tracks.empty()) {
+        return song;
+    }
+
+    // Decoded tracks are transient, so they share the index's resource. The
+    // conversion workers decode and convert tracks with it too, so it is only
+    // used through a lock when there are several.
+    auto* resource = midi.tracks.get_allocator().resource();
+    SightRead::Detail::SynchronisedResource synchronised_resource {resource};
+    if (m_thread_count > 1) {
+        resource = &synchronised_resource;
+    }
+    const auto first_track = [&] {
+        const SightRead::Detail::PhaseTimer timer {
+            SightRead::Detail::phase_sink(stats,
+                                          &SightRead::ParseStats::tempo_map)};
+        auto track = decode_midi_track(midi.tracks[0], resource);
+        song.global_data().tempo_map(
+            read_first_midi_track(track, midi.ticks_per_quarter_note));
+        return track;
+    }();
+    if (stats != nullptr) {
+        stats->event_count += first_track.events.size();
+    }
+
+    std::vector<std::tuple<SightRead::Instrument, std::size_t>>
+        instrument_tracks;
+    for (auto i = 0U; i < midi.tracks.size(); ++i) {
+        const auto& track_name = midi.tracks[i].name;
         if (!track_name.has_value()) {
             continue;
         }
-        if (*track_name == "BEAT") {
-            song.global_data().od_beats(od_beats_from_track(track));
-        } else if (*track_name == "EVENTS") {
-            song.global_data().practice_sections(
-                practice_sections_from_track(track));
-        } else {
-            process_instrument_track(*track_name, track, song);
+        if (*track_name == "BEAT" || *track_name == "EVENTS") {
+            if (i == 0) {
+                process_global_track(*track_name, first_track, song);
+                continue;
+            }
+            const auto track = decode_midi_track(midi.tracks[i], resource);
+            if (stats != nullptr) {
+                stats->event_count += track.events.size();
+            }
+            process_global_track(*track_name, track, song);
+            continue;
+        }
+        const auto inst = midi_section_instrument(*track_name);
+        if (inst.has_value()) {
+            instrument_tracks.emplace_back(*inst, i);
         }
     }
 
-    const auto& od_beats = song.global_data().od_beats();
-    if (!od_beats.empty()) {
-        auto old_tempo_map = song.global_data().tempo_map();
-        SightRead::TempoMap new_tempo_map {old_tempo_map.time_sigs(),
-                                           old_tempo_map.bpms(), od_beats,
-                                           midi.ticks_per_quarter_note};
-        song.global_data().tempo_map(new_tempo_map);
+    // Each task only touches its own element, so the vector is sized before
+    // any are started.
+    std::size_t first_stats = 0;
+    if (stats != nullptr) {
+        first_stats = stats->tracks.size();
+        for (const auto& [inst, track_index] : instrument_tracks) {
+            stats->tracks.push_back({inst, std::nullopt, 0, {}, {}});
+        }
     }
 
+    // Decoding is done inside the workers too, since for the instrument tracks
+    // it is a large share of the work.
+    const auto global_data = song.global_data_ptr();
+    auto note_tracks = parallel_map(
+        instrument_tracks.size(), m_thread_count, [&](std::size_t i) {
+            const auto [inst, track_index] = instrument_tracks[i];
+            SightRead::TrackParseStats* track_stats = nullptr;
+            SightRead::Detail::PhaseSink conversion_sink;
+            SightRead::Detail::PhaseSink note_track_sink;
+            if (stats != nullptr) {
+                track_stats = &stats->tracks[first_stats + i];
+                conversion_sink
+                    = {&track_stats->conversion, stats->allocation_counter};
+                note_track_sink
+                    = {&track_stats->note_track, stats->allocation_counter};
+            }
+            const SightRead::Detail::PhaseTimer timer {conversion_sink};
+            if (track_index == 0) {
+                if (track_stats != nullptr) {
+                    track_stats->event_count = first_track.events.size();
+                }
+                return instrument_note_tracks(inst, first_track, global_data,
+                                              note_track_sink);
+            }
+            const auto track
+                = decode_midi_track(midi.tracks[track_index], resource);
+            if (track_stats != nullptr) {
+                track_stats->event_count = track.events.size();
+            }
+            return instrument_note_tracks(inst, track, global_data,
+                                          note_track_sink);
+        });
+    for (auto i = 0U; i < note_tracks.size(); ++i) {
+        const auto inst = std::get<0>(instrument_tracks[i]);
+        for (auto& [diff, note_track] : note_tracks[i]) {
+            song.add_note_track(inst, diff, std::move(note_track));
+        }
+    }
+    if (stats != nullptr) {
+        for (auto i = 0U; i < instrument_tracks.size(); ++i) {
+            // The first track's events were counted with the tempo map.
+            if (std::get<1>(instrument_tracks[i]) != 0) {
+                stats->event_count
+                    += stats->tracks[first_stats + i].event_count;
+            }
+        }
+    }
+
+    apply_od_beats(song);
+
     return song;
 }
+
+SightRead::SongSummary SightRead::Detail::MidiConverter::summarise(
+    const SightRead::Detail::MidiIndex& midi) const
+{
+    if (midi.ticks_per_quarter_note == 0) {
+        throw SightRead::ParseError("Resolution must be > 0");
+    }
+
+    SightRead::SongSummary summary {midi.ticks_per_quarter_note,
+                                    {},
+                                    SightRead::Tick {0},
+                                    SightRead::Second {0.0}};
+    if (midi.tracks.empty()) {
+        return summary;
+    }
+
+    auto* resource = midi.tracks.get_allocator().resource();
+    const auto first_track = decode_midi_track(midi.tracks[0], resource);
+    const auto tempo_map
+        = read_first_midi_track(first_track, midi.ticks_per_quarter_note);
+
+    for (auto i = 0U; i < midi.tracks.size(); ++i) {
+        const auto& track_name = midi.tracks[i].name;
+        if (!track_name.has_value()) {
+            continue;
+        }
+        const auto inst = midi_section_instrument(*track_name);
+        if (!inst.has_value()) {
+            continue;
+        }
+        const auto counts
+            = count_midi_gems(i == 0 ? first_track
+                                     : decode_midi_track(midi.tracks[i],
+                                                         resource),
+                              midi_track_type(*inst));
+        for (auto j = 0U; j < counts.note_counts.size(); ++j) {
+            const auto diff = static_cast<SightRead::Difficulty>(j);
+            // As with convert, only the first track for a difficulty is used.
+            if (counts.note_counts.at(j) == 0
+                || std::any_of(summary.tracks.cbegin(), summary.tracks.cend(),
+                               [&](const auto& track) {
+                                   return track.instrument == *inst
+                                       && track.difficulty == diff;
+                               })) {
+                continue;
+            }
+            summary.tracks.push_back({*inst, diff, counts.note_counts.at(j)});
+        }
+        summary.length
+            = std::max(summary.length, SightRead::Tick {counts.end});
+    }
+
+    std::sort(summary.tracks.begin(), summary.tracks.end(),
+              [](const auto& lhs, const auto& rhs) {
+                  return std::tie(lhs.instrument, lhs.difficulty)
+                      < std::tie(rhs.instrument, rhs.difficulty);
+              });
+    summary.length_seconds = tempo_map.to_seconds(summary.length);
+    return summary;
+}
@@ -1,15 +1,20 @@
 #ifndef SIGHTREAD_DETAIL_MIDICONVERTER_HPP
 #define SIGHTREAD_DETAIL_MIDICONVERTER_HPP
 
+#include <map>
+#include <memory>
 #include <optional>
 #include <set>
 #include <string>
+#include <string_view>
 
 #include "sightread/detail/midi.hpp"
+#include "sightread/detail/phasetimer.hpp"
 #include "sightread/hopothreshold.hpp"
 #include "sightread/metadata.hpp"
 #include "sightread/song.hpp"
 #include "sightread/songparts.hpp"
+#include "sightread/songsummary.hpp"
 
 namespace SightRead::Detail {
 class MidiConverter {
@@ -20,12 +25,22 @@ private:
     SightRead::HopoThreshold m_hopo_threshold;
     std::set<SightRead::Instrument> m_permitted_instruments;
     bool m_permit_solos;
+    unsigned int m_thread_count;
 
     std::optional<SightRead::Instrument>
-    midi_section_instrument(const std::string& track_name) const;
-    void process_instrument_track(const std::string& track_name,
-                                  const SightRead::Detail::MidiTrack& track,
-                                  SightRead::Song& song) const;
+    midi_section_instrument(std::string_view track_name) const;
+    std::map<SightRead::Difficulty, SightRead::NoteTrack>
+    instrument_note_tracks(
+        SightRead::Instrument inst,
+        const SightRead::Detail::MidiTrackView& track,
+        const std::shared_ptr<SightRead::SongGlobalData>& global_data,
+        SightRead::Detail::PhaseSink note_track_sink = {}) const;
+    SightRead::Song make_empty_song(int ticks_per_quarter_note) const;
+    // Handles the BEAT and EVENTS tracks, returning false for any other track.
+    bool process_global_track(std::string_view track_name,
+                              const SightRead::Detail::MidiTrackView& track,
+                              SightRead::Song& song) const;
+    void apply_od_beats(SightRead::Song& song) const;
 
 public:
     explicit MidiConverter(SightRead::Metadata metadata);
@@ -33,7 +48,20 @@ public:
     MidiConverter&
     permit_instruments(std::set<SightRead::Instrument> permitted_instruments);
     MidiConverter& parse_solos(bool permit_solos);
+    // Sets how many threads instrument tracks are converted with. The default
+    // is 1, i.e., conversion happens entirely on the calling thread.
+    MidiConverter& threads(unsigned int thread_count);
     SightRead::Song convert(const SightRead::Detail::Midi& midi) const;
+    SightRead::Song convert(const SightRead::Detail::MidiView& midi) const;
+    // Only decodes the tempo track and the tracks that contribute to the
+    // resulting Song. If stats is not null, the tempo map, per-track and event
+    // count stats are added to it.
+    SightRead::Song convert(const SightRead::Detail::MidiIndex& midi,
+                            SightRead::ParseStats* stats = nullptr) const;
+    // Reads the tempo track and counts the note events of each instrument
+    // track without building any note tracks.
+    SightRead::SongSummary
+    summarise(const SightRead::Detail::MidiIndex& midi) const;
 };
 }
 
@@ -0,0 +1,80 @@
+#ifndef SIGHTREAD_DETAIL_PARALLEL_HPP
+#define SIGHTREAD_DETAIL_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace SightRead::Detail {
+// Returns {func(0), func(1), ..., func(count - 1)}, with the calls spread over
+// up to thread_count threads (the calling thread being one of them). Workers
+// take the next unclaimed index each time, so uneven calls balance out. If any
+// calls throw, the exception from the lowest index is rethrown once every
+// thread has finished, matching what a serial loop would have thrown first.
+template <typename F>
+std::vector<std::invoke_result_t<F&, std::size_t>>
+parallel_map(std::size_t count, unsigned int thread_count, F func)
+{
+    using Result = std::invoke_result_t<F&, std::size_t>;
+
+    std::vector<std::optional<Result>> results(count);
+    std::vector<std::exception_ptr> exceptions(count);
+    std::atomic<std::size_t> next_index {0};
+
+    const auto work = [&] {
+        while (true) {
+            const auto i = next_index.fetch_add(1);
+            if (i >= count) {
+                return;
+            }
+            try {
+                results[i].emplace(func(i));
+            } catch (...) {
+                exceptions[i] = std::current_exception();
+            }
+        }
+    };
+
+    const auto worker_count
+        = std::min<std::size_t>(std::max(thread_count, 1U), count);
+    std::vector<std::thread> workers;
+    if (worker_count > 1) {
+        workers.reserve(worker_count - 1);
+        for (auto i = 1U; i < worker_count; ++i) {
+            // If no more threads can be made, the existing ones still get
+            // through all the work.
+            try {
+                workers.emplace_back(work);
+            } catch (const std::system_error&) {
+                break;
+            }
+        }
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    for (const auto& exception : exceptions) {
+        if (exception != nullptr) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    std::vector<Result> flattened_results;
+    flattened_results.reserve(count);
+    for (auto& result : results) {
+        flattened_results.push_back(std::move(*result));
+    }
+    return flattened_results;
+}
+}
+
+#endif
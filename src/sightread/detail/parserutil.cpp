@@ -15,21 +15,21 @@ bool SightRead::Detail::is_six_fret_instrument(SightRead::Instrument instrument)
 }
 
 std::vector<std::tuple<SightRead::Tick, SightRead::Tick>>
-SightRead::Detail::combine_solo_events(const std::vector<int>& on_events,
-                                       const std::vector<int>& off_events)
+SightRead::Detail::combine_solo_events(std::span<const int> on_events,
+                                       std::span<const int> off_events)
 {
     std::vector<std::tuple<SightRead::Tick, SightRead::Tick>> ranges;
 
-    auto on_iter = on_events.cbegin();
-    auto off_iter = off_events.cbegin();
+    auto on_iter = on_events.begin();
+    auto off_iter = off_events.begin();
 
-    while (on_iter < on_events.cend() && off_iter < off_events.cend()) {
+    while (on_iter < on_events.end() && off_iter < off_events.end()) {
         if (*on_iter >= *off_iter) {
             ++off_iter;
             continue;
         }
         ranges.emplace_back(*on_iter, *off_iter);
-        while (on_iter < on_events.cend() && *on_iter < *off_iter) {
+        while (on_iter < on_events.end() && *on_iter < *off_iter) {
             ++on_iter;
         }
     }
@@ -38,8 +38,8 @@ SightRead::Detail::combine_solo_events(const std::vector<int>& on_events,
 }
 
 std::vector<SightRead::Solo>
-SightRead::Detail::form_solo_vector(const std::vector<int>& solo_on_events,
-                                    const std::vector<int>& solo_off_events,
+SightRead::Detail::form_solo_vector(std::span<const int> solo_on_events,
+                                    std::span<const int> solo_off_events,
                                     const std::vector<SightRead::Note>& notes,
                                     SightRead::TrackType track_type,
                                     bool is_midi)
@@ -1,6 +1,7 @@
 #ifndef SIGHTREAD_DETAIL_PARSERUTIL_HPP
 #define SIGHTREAD_DETAIL_PARSERUTIL_HPP
 
+#include <span>
 #include <tuple>
 #include <vector>
 
@@ -14,12 +15,12 @@ bool is_six_fret_instrument(SightRead::Instrument instrument);
 // sequence where said type is turned off, and returns a tuple of intervals
 // where the event is on.
 std::vector<std::tuple<SightRead::Tick, SightRead::Tick>>
-combine_solo_events(const std::vector<int>& on_events,
-                    const std::vector<int>& off_events);
+combine_solo_events(std::span<const int> on_events,
+                    std::span<const int> off_events);
 
 std::vector<SightRead::Solo>
-form_solo_vector(const std::vector<int>& solo_on_events,
-                 const std::vector<int>& solo_off_events,
+form_solo_vector(std::span<const int> solo_on_events,
+                 std::span<const int> solo_off_events,
                  const std::vector<SightRead::Note>& notes,
                  SightRead::TrackType track_type, bool is_midi);
 }
@@ -0,0 +1,66 @@
+#ifndef SIGHTREAD_DETAIL_PHASETIMER_HPP
+#define SIGHTREAD_DETAIL_PHASETIMER_HPP
+
+#include <chrono>
+#include <cstddef>
+
+#include "sightread/parsestats.hpp"
+
+namespace SightRead::Detail {
+// Where a phase's stats are recorded, if anywhere.
+struct PhaseSink {
+    SightRead::PhaseStats* phase {nullptr};
+    std::size_t (*allocation_counter)() {nullptr};
+};
+
+inline PhaseSink phase_sink(SightRead::ParseStats* stats,
+                            SightRead::PhaseStats SightRead::ParseStats::*phase)
+{
+    if (stats == nullptr) {
+        return {};
+    }
+    return {&(stats->*phase), stats->allocation_counter};
+}
+
+// Adds the time and allocations between construction and destruction to the
+// sink's phase. Does nothing, not even reading the clock, if the sink has no
+// phase.
+class PhaseTimer {
+private:
+    PhaseSink m_sink;
+    std::chrono::steady_clock::time_point m_start;
+    std::size_t m_start_allocations {0};
+
+public:
+    explicit PhaseTimer(PhaseSink sink)
+        : m_sink {sink}
+    {
+        if (m_sink.phase == nullptr) {
+            return;
+        }
+        if (m_sink.allocation_counter != nullptr) {
+            m_start_allocations = m_sink.allocation_counter();
+        }
+        m_start = std::chrono::steady_clock::now();
+    }
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+    PhaseTimer(PhaseTimer&&) = delete;
+    PhaseTimer& operator=(PhaseTimer&&) = delete;
+
+    ~PhaseTimer()
+    {
+        if (m_sink.phase == nullptr) {
+            return;
+        }
+        m_sink.phase->time += std::chrono::steady_clock::now() - m_start;
+        if (m_sink.allocation_counter != nullptr) {
+            m_sink.phase->allocations
+                += m_sink.allocation_counter() - m_start_allocations;
+        }
+    }
+};
+}
+
+#endif
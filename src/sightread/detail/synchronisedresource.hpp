@@ -0,0 +1,44 @@
+#ifndef SIGHTREAD_DETAIL_SYNCHRONISEDRESOURCE_HPP
+#define SIGHTREAD_DETAIL_SYNCHRONISEDRESOURCE_HPP
+
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+
+namespace SightRead::Detail {
+// Forwards to another memory resource under a mutex, so that a resource which
+// is not thread-safe, such as std::pmr::monotonic_buffer_resource, can be used
+// by the workers of parallel_map.
+class SynchronisedResource : public std::pmr::memory_resource {
+private:
+    std::pmr::memory_resource* m_upstream;
+    std::mutex m_mutex;
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        const std::lock_guard lock {m_mutex};
+        return m_upstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes,
+                       std::size_t alignment) override
+    {
+        const std::lock_guard lock {m_mutex};
+        m_upstream->deallocate(p, bytes, alignment);
+    }
+
+    [[nodiscard]] bool
+    do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+public:
+    explicit SynchronisedResource(std::pmr::memory_resource* upstream)
+        : m_upstream {upstream}
+    {
+    }
+};
+}
+
+#endif
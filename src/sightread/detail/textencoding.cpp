@@ -0,0 +1,170 @@
+#include <array>
+#include <cstdint>
+
+#include "sightread/detail/textencoding.hpp"
+#include "sightread/tempomap.hpp"
+
+namespace {
+enum class Utf16Order { LittleEndian, BigEndian };
+
+constexpr std::size_t UNIT_SIZE = 2;
+constexpr std::size_t WORD_SIZE = 8;
+
+std::uint16_t read_unit(std::string_view data, std::size_t index,
+                        Utf16Order order)
+{
+    const auto first = static_cast<unsigned char>(data[index]);
+    const auto second = static_cast<unsigned char>(data[index + 1]);
+    if (order == Utf16Order::LittleEndian) {
+        return static_cast<std::uint16_t>(first | (second << 8U)); // NOLINT
+    }
+    return static_cast<std::uint16_t>((first << 8U) | second); // NOLINT
+}
+
+// Assembled byte by byte so the result is the same on any host; compilers
+// turn this into a single load on little-endian ones.
+std::uint64_t read_word(std::string_view data, std::size_t index)
+{
+    std::uint64_t word = 0;
+    for (auto i = 0U; i < WORD_SIZE; ++i) {
+        word |= static_cast<std::uint64_t>(
+                    static_cast<unsigned char>(data[index + i]))
+            << (8U * i); // NOLINT
+    }
+    return word;
+}
+
+// Transcodes four code units at a time while they are all ASCII, which
+// nearly all of a .chart file is. A code unit is ASCII if all of its bits
+// other than the low seven are clear, so the masks select those bits of each
+// unit as they lie in a word read by read_word.
+void append_ascii_run(std::string_view data, std::size_t& index,
+                      Utf16Order order, std::pmr::string& buffer)
+{
+    constexpr std::uint64_t LITTLE_ENDIAN_MASK = 0xFF80FF80FF80FF80ULL;
+    constexpr std::uint64_t BIG_ENDIAN_MASK = 0x80FF80FF80FF80FFULL;
+    constexpr unsigned int UNIT_BITS = 16;
+    constexpr std::uint64_t BYTE_MASK = 0xFF;
+
+    const auto mask = order == Utf16Order::LittleEndian ? LITTLE_ENDIAN_MASK
+                                                        : BIG_ENDIAN_MASK;
+    const auto shift = order == Utf16Order::LittleEndian ? 0U : 8U;
+    while (index + WORD_SIZE <= data.size()) {
+        const auto word = read_word(data, index);
+        if ((word & mask) != 0) {
+            return;
+        }
+        std::array<char, WORD_SIZE / UNIT_SIZE> chars {};
+        for (auto i = 0U; i < chars.size(); ++i) {
+            chars[i] = static_cast<char>(
+                (word >> (i * UNIT_BITS + shift)) & BYTE_MASK);
+        }
+        buffer.append(chars.data(), chars.size());
+        index += WORD_SIZE;
+    }
+}
+
+void append_code_point(std::uint32_t code_point, std::pmr::string& buffer)
+{
+    // NOLINTBEGIN
+    if (code_point < 0x80) {
+        buffer.push_back(static_cast<char>(code_point));
+    } else if (code_point < 0x800) {
+        buffer.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+        buffer.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    } else if (code_point < 0x10000) {
+        buffer.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+        buffer.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        buffer.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    } else {
+        buffer.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+        buffer.push_back(
+            static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+        buffer.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        buffer.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    }
+    // NOLINTEND
+}
+
+void transcode_utf16(std::string_view data, Utf16Order order,
+                     std::pmr::string& buffer)
+{
+    constexpr std::uint16_t HIGH_SURROGATE_START = 0xD800;
+    constexpr std::uint16_t LOW_SURROGATE_START = 0xDC00;
+    constexpr std::uint16_t SURROGATE_END = 0xE000;
+    constexpr std::uint32_t SUPPLEMENTARY_START = 0x10000;
+    constexpr unsigned int SURROGATE_BITS = 10;
+
+    if (data.size() % UNIT_SIZE != 0) {
+        throw SightRead::ParseError("UTF-16 text has an odd length",
+                                    SightRead::ParseErrorCode::InvalidEncoding);
+    }
+    buffer.clear();
+    buffer.reserve(data.size() / UNIT_SIZE);
+    std::size_t index = 0;
+    while (index < data.size()) {
+        append_ascii_run(data, index, order, buffer);
+        if (index == data.size()) {
+            break;
+        }
+        const auto unit = read_unit(data, index, order);
+        index += UNIT_SIZE;
+        if (unit < HIGH_SURROGATE_START || unit >= SURROGATE_END) {
+            append_code_point(unit, buffer);
+            continue;
+        }
+        if (unit >= LOW_SURROGATE_START || index == data.size()) {
+            throw SightRead::ParseError(
+                "Unpaired UTF-16 surrogate",
+                SightRead::ParseErrorCode::InvalidEncoding);
+        }
+        const auto low_unit = read_unit(data, index, order);
+        if (low_unit < LOW_SURROGATE_START || low_unit >= SURROGATE_END) {
+            throw SightRead::ParseError(
+                "Unpaired UTF-16 surrogate",
+                SightRead::ParseErrorCode::InvalidEncoding);
+        }
+        index += UNIT_SIZE;
+        append_code_point(
+            SUPPLEMENTARY_START
+                + ((static_cast<std::uint32_t>(unit - HIGH_SURROGATE_START)
+                    << SURROGATE_BITS)
+                   | static_cast<std::uint32_t>(low_unit
+                                                - LOW_SURROGATE_START)),
+            buffer);
+    }
+}
+}
+
+std::string_view SightRead::Detail::to_utf8(std::string_view data,
+                                            std::pmr::string& buffer)
+{
+    constexpr std::string_view UTF8_BOM {"\xEF\xBB\xBF"};
+    constexpr std::string_view UTF16_LE_BOM {"\xFF\xFE"};
+    constexpr std::string_view UTF16_BE_BOM {"\xFE\xFF"};
+
+    if (data.starts_with(UTF8_BOM)) {
+        return data.substr(UTF8_BOM.size());
+    }
+    if (data.starts_with(UTF16_LE_BOM)) {
+        transcode_utf16(data.substr(UNIT_SIZE), Utf16Order::LittleEndian,
+                        buffer);
+        return buffer;
+    }
+    if (data.starts_with(UTF16_BE_BOM)) {
+        transcode_utf16(data.substr(UNIT_SIZE), Utf16Order::BigEndian,
+                        buffer);
+        return buffer;
+    }
+    if (data.size() >= UNIT_SIZE) {
+        if (data[0] != '\0' && data[1] == '\0') {
+            transcode_utf16(data, Utf16Order::LittleEndian, buffer);
+            return buffer;
+        }
+        if (data[0] == '\0' && data[1] != '\0') {
+            transcode_utf16(data, Utf16Order::BigEndian, buffer);
+            return buffer;
+        }
+    }
+    return data;
+}
@@ -0,0 +1,19 @@
+#ifndef SIGHTREAD_DETAIL_TEXTENCODING_HPP
+#define SIGHTREAD_DETAIL_TEXTENCODING_HPP
+
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+namespace SightRead::Detail {
+// Returns the contents of a .chart file as UTF-8. A UTF-8 byte order mark is
+// skipped, and UTF-16 text is transcoded into buffer, which the result then
+// views. UTF-16 is recognised by its byte order mark, or failing that by the
+// first character being ASCII with a zero byte on one side, as every .chart
+// file starts with "[". Anything else is returned as is. Throws
+// SightRead::ParseError if UTF-16 text has an odd length or an unpaired
+// surrogate.
+std::string_view to_utf8(std::string_view data, std::pmr::string& buffer);
+}
+
+#endif
@@ -0,0 +1,155 @@
+#include <functional>
+#include <memory_resource>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sightread/detail/chart.hpp"
+#include "sightread/detail/chartconverter.hpp"
+#include "sightread/detail/textencoding.hpp"
+#include "sightread/incrementalchartparser.hpp"
+
+struct SightRead::IncrementalChartParser::State {
+    // Each section owns its text, which its tokenized Chart borrows from, and
+    // is kept at a fixed address so the cache can tell it is the same one.
+    struct Section {
+        std::string text;
+        std::size_t hash;
+        SightRead::Detail::Chart chart;
+    };
+
+    std::vector<std::unique_ptr<Section>> sections;
+    SightRead::Detail::ChartTrackCache cache;
+};
+
+SightRead::IncrementalChartParser::IncrementalChartParser(
+    SightRead::Metadata metadata)
+    : m_metadata {std::move(metadata)}
+    , m_hopo_threshold {SightRead::HopoThresholdType::Resolution,
+                        SightRead::Tick {0}}
+    , m_permitted_instruments {SightRead::all_instruments()}
+    , m_permit_solos {true}
+    , m_thread_count {1}
+    , m_state {std::make_unique<State>()}
+{
+}
+
+SightRead::IncrementalChartParser::IncrementalChartParser(
+    SightRead::IncrementalChartParser&& other) noexcept
+    = default;
+
+SightRead::IncrementalChartParser& SightRead::IncrementalChartParser::operator=(
+    SightRead::IncrementalChartParser&& other) noexcept
+    = default;
+
+SightRead::IncrementalChartParser::~IncrementalChartParser() = default;
+
+SightRead::IncrementalChartParser&
+SightRead::IncrementalChartParser::hopo_threshold(
+    SightRead::HopoThreshold hopo_threshold)
+{
+    m_hopo_threshold = hopo_threshold;
+    m_state = std::make_unique<State>();
+    return *this;
+}
+
+SightRead::IncrementalChartParser&
+SightRead::IncrementalChartParser::permit_instruments(
+    std::set<SightRead::Instrument> permitted_instruments)
+{
+    m_permitted_instruments = std::move(permitted_instruments);
+    m_state = std::make_unique<State>();
+    return *this;
+}
+
+SightRead::IncrementalChartParser&
+SightRead::IncrementalChartParser::parse_solos(bool permit_solos)
+{
+    m_permit_solos = permit_solos;
+    m_state = std::make_unique<State>();
+    return *this;
+}
+
+SightRead::IncrementalChartParser&
+SightRead::IncrementalChartParser::threads(unsigned int thread_count)
+{
+    m_thread_count = thread_count;
+    return *this;
+}
+
+SightRead::Song SightRead::IncrementalChartParser::parse(std::string_view data)
+{
+    if (m_state == nullptr) {
+        m_state = std::make_unique<State>();
+    }
+    // Old sections are only moved out of m_state once the parse has
+    // succeeded, so a failed parse leaves it as it was. reused_from holds
+    // the index of the old section each section matched, or -1 if it was
+    // parsed afresh into new_sections.
+    const auto& old_sections = m_state->sections;
+    std::vector<bool> is_reused(old_sections.size(), false);
+    std::vector<int> reused_from;
+    std::vector<std::unique_ptr<State::Section>> new_sections;
+    std::vector<const State::Section*> sections;
+
+    // Sections copy their text, so the transcoded text need only last until
+    // the split is done.
+    std::pmr::string utf8_buffer;
+    const auto utf8_data = SightRead::Detail::to_utf8(data, utf8_buffer);
+    for (const auto text :
+         SightRead::Detail::split_chart_sections(utf8_data)) {
+        const auto hash = std::hash<std::string_view> {}(text);
+        auto match = -1;
+        for (auto i = 0U; i < old_sections.size(); ++i) {
+            if (!is_reused[i] && old_sections[i]->hash == hash
+                && old_sections[i]->text == text) {
+                is_reused[i] = true;
+                match = static_cast<int>(i);
+                break;
+            }
+        }
+        reused_from.push_back(match);
+        if (match != -1) {
+            sections.push_back(
+                old_sections[static_cast<std::size_t>(match)].get());
+            continue;
+        }
+        auto section = std::make_unique<State::Section>();
+        section->text = text;
+        section->hash = hash;
+        section->chart = SightRead::Detail::parse_chart(
+            section->text, m_permitted_instruments);
+        sections.push_back(section.get());
+        new_sections.push_back(std::move(section));
+    }
+
+    std::vector<const SightRead::Detail::ChartSection*> chart_sections;
+    for (const auto& section : sections) {
+        for (const auto& chart_section : section->chart.sections) {
+            chart_sections.push_back(&chart_section);
+        }
+    }
+
+    const auto converter = SightRead::Detail::ChartConverter(m_metadata)
+                               .hopo_threshold(m_hopo_threshold)
+                               .permit_instruments(m_permitted_instruments)
+                               .parse_solos(m_permit_solos)
+                               .threads(m_thread_count);
+    auto song = converter.convert(chart_sections, m_state->cache);
+
+    // The unmatched old sections are only destroyed now, so that no new
+    // section could have been allocated at one of their addresses.
+    std::vector<std::unique_ptr<State::Section>> kept_sections;
+    auto new_section = new_sections.begin();
+    for (const auto match : reused_from) {
+        if (match == -1) {
+            kept_sections.push_back(std::move(*new_section));
+            ++new_section;
+        } else {
+            kept_sections.push_back(std::move(
+                m_state->sections[static_cast<std::size_t>(match)]));
+        }
+    }
+    m_state->sections = std::move(kept_sections);
+    return song;
+}
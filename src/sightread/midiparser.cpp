@@ -1,6 +1,8 @@
 #include <utility>
 
+#include "sightread/detail/mappedfile.hpp"
 #include "sightread/detail/midiconverter.hpp"
+#include "sightread/detail/phasetimer.hpp"
 #include "sightread/midiparser.hpp"
 
 SightRead::MidiParser::MidiParser(SightRead::Metadata metadata)
@@ -9,6 +11,8 @@ SightRead::MidiParser::MidiParser(SightRead::Metadata metadata)
                         SightRead::Tick {0}}
     , m_permitted_instruments {SightRead::all_instruments()}
     , m_permit_solos {true}
+    , m_thread_count {1}
+    , m_resource {std::pmr::get_default_resource()}
 {
 }
 
@@ -32,14 +36,87 @@ SightRead::MidiParser& SightRead::MidiParser::parse_solos(bool permit_solos)
     return *this;
 }
 
+SightRead::MidiParser& SightRead::MidiParser::threads(unsigned int thread_count)
+{
+    m_thread_count = thread_count;
+    return *this;
+}
+
+SightRead::MidiParser&
+SightRead::MidiParser::memory_resource(std::pmr::memory_resource* resource)
+{
+    m_resource = resource;
+    return *this;
+}
+
 SightRead::Song
-SightRead::MidiParser::parse(std::span<const std::uint8_t> data) const
+SightRead::MidiParser::parse_with_stats(std::span<const std::uint8_t> data,
+                                        SightRead::ParseStats* stats) const
 {
-    const auto midi = SightRead::Detail::parse_midi(data);
+    const SightRead::Detail::PhaseTimer timer {
+        SightRead::Detail::phase_sink(stats, &SightRead::ParseStats::total)};
+    if (stats != nullptr) {
+        stats->input_bytes += data.size();
+    }
+
+    const auto midi = [&] {
+        const SightRead::Detail::PhaseTimer tokenize_timer {
+            SightRead::Detail::phase_sink(stats,
+                                          &SightRead::ParseStats::tokenize)};
+        return SightRead::Detail::index_midi(data, m_resource);
+    }();
 
     const auto converter = SightRead::Detail::MidiConverter(m_metadata)
                                .hopo_threshold(m_hopo_threshold)
                                .permit_instruments(m_permitted_instruments)
-                               .parse_solos(m_permit_solos);
-    return converter.convert(midi);
+                               .parse_solos(m_permit_solos)
+                               .threads(m_thread_count);
+    return converter.convert(midi, stats);
+}
+
+SightRead::Song
+SightRead::MidiParser::parse(std::span<const std::uint8_t> data) const
+{
+    return parse_with_stats(data, nullptr);
+}
+
+SightRead::Song
+SightRead::MidiParser::parse(std::span<const std::uint8_t> data,
+                             SightRead::ParseStats& stats) const
+{
+    return parse_with_stats(data, &stats);
+}
+
+SightRead::ParseResult
+SightRead::MidiParser::try_parse(std::span<const std::uint8_t> data) const
+{
+    try {
+        return parse(data);
+    } catch (const SightRead::ParseError& error) {
+        return error;
+    }
+}
+
+SightRead::Song
+SightRead::MidiParser::parse_file(const std::filesystem::path& path) const
+{
+    const SightRead::Detail::MappedFile file {path};
+    return parse(file.data());
+}
+
+SightRead::SongSummary
+SightRead::MidiParser::probe(std::span<const std::uint8_t> data) const
+{
+    const auto midi = SightRead::Detail::index_midi(data, m_resource);
+
+    return SightRead::Detail::MidiConverter(m_metadata)
+        .permit_instruments(m_permitted_instruments)
+        .summarise(midi);
+}
+
+SightRead::SongSummary
+SightRead::MidiParser::probe_file(const std::filesystem::path& path) const
+{
+    const SightRead::Detail::MappedFile file {path};
+    return probe(file.data());
 }
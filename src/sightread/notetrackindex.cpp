@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "sightread/notetrackindex.hpp"
+
+namespace {
+SightRead::Tick phrase_start(const SightRead::StarPower& phrase)
+{
+    return phrase.position;
+}
+
+SightRead::Tick phrase_end(const SightRead::StarPower& phrase)
+{
+    return phrase.position + phrase.length;
+}
+
+SightRead::Tick phrase_start(const SightRead::Solo& solo) { return solo.start; }
+
+SightRead::Tick phrase_end(const SightRead::Solo& solo) { return solo.end; }
+
+SightRead::Tick phrase_start(const SightRead::DrumFill& fill)
+{
+    return fill.position;
+}
+
+SightRead::Tick phrase_end(const SightRead::DrumFill& fill)
+{
+    return fill.position + fill.length;
+}
+
+SightRead::Tick phrase_start(const SightRead::DiscoFlip& flip)
+{
+    return flip.position;
+}
+
+SightRead::Tick phrase_end(const SightRead::DiscoFlip& flip)
+{
+    return flip.position + flip.length;
+}
+
+std::vector<SightRead::Second>
+to_seconds(const std::vector<SightRead::Tick>& ticks,
+           const SightRead::TempoMap& tempo_map)
+{
+    std::vector<SightRead::Second> seconds(ticks.size(),
+                                           SightRead::Second {0.0});
+    tempo_map.to_seconds(ticks, seconds);
+    return seconds;
+}
+}
+
+template <typename Item>
+SightRead::NoteTrackIndex::Phrases<Item>
+SightRead::NoteTrackIndex::index_phrases(std::span<const Item> items,
+                                         const SightRead::TempoMap& tempo_map)
+{
+    Phrases<Item> phrases {items, {}, {}};
+    phrases.ticks.starts.reserve(items.size());
+    phrases.ticks.max_ends.reserve(items.size());
+    for (const auto& item : items) {
+        const auto start = phrase_start(item);
+        if (!phrases.ticks.starts.empty()
+            && start < phrases.ticks.starts.back()) {
+            throw std::invalid_argument("Phrases are not sorted");
+        }
+        auto max_end = phrase_end(item);
+        if (!phrases.ticks.max_ends.empty()) {
+            max_end = std::max(max_end, phrases.ticks.max_ends.back());
+        }
+        phrases.ticks.starts.push_back(start);
+        phrases.ticks.max_ends.push_back(max_end);
+    }
+    // to_seconds is increasing, so the running maximum of the ends in seconds
+    // is the conversion of the running maximum in ticks.
+    phrases.seconds.starts = to_seconds(phrases.ticks.starts, tempo_map);
+    phrases.seconds.max_ends = to_seconds(phrases.ticks.max_ends, tempo_map);
+    return phrases;
+}
+
+template <typename Item, typename Time>
+std::span<const Item> SightRead::NoteTrackIndex::window(
+    const SightRead::NoteTrackIndex::Phrases<Item>& phrases,
+    const SightRead::NoteTrackIndex::Column<Time>& column, Time start, Time end)
+{
+    // The first phrase that can reach start is the first whose running
+    // maximum end does, and the last is the last to start by end.
+    const auto first
+        = std::lower_bound(column.max_ends.cbegin(), column.max_ends.cend(),
+                           start)
+        - column.max_ends.cbegin();
+    const auto last
+        = std::upper_bound(column.starts.cbegin(), column.starts.cend(), end)
+        - column.starts.cbegin();
+    if (last <= first) {
+        return {};
+    }
+    return phrases.items.subspan(static_cast<std::size_t>(first),
+                                 static_cast<std::size_t>(last - first));
+}
+
+SightRead::NoteTrackIndex::NoteTrackIndex(
+    const SightRead::NoteTrack& track, const SightRead::TempoMap& tempo_map,
+    const SightRead::DrumSettings& drum_settings)
+    : m_notes {track.notes()}
+    , m_sp_phrases {index_phrases<SightRead::StarPower>(track.sp_phrases(),
+                                                        tempo_map)}
+    , m_solos {index_phrases<SightRead::Solo>(track.solos(drum_settings),
+                                              tempo_map)}
+    , m_drum_fills {index_phrases<SightRead::DrumFill>(track.drum_fills(),
+                                                       tempo_map)}
+    , m_disco_flips {index_phrases<SightRead::DiscoFlip>(track.disco_flips(),
+                                                         tempo_map)}
+{
+    m_note_ticks.reserve(m_notes.size());
+    for (const auto& note : m_notes) {
+        if (!m_note_ticks.empty() && note.position < m_note_ticks.back()) {
+            throw std::invalid_argument("Notes are not sorted");
+        }
+        m_note_ticks.push_back(note.position);
+    }
+    m_note_seconds = to_seconds(m_note_ticks, tempo_map);
+}
+
+std::span<const SightRead::Note>
+SightRead::NoteTrackIndex::notes(SightRead::Tick start,
+                                 SightRead::Tick end) const
+{
+    const auto first
+        = std::lower_bound(m_note_ticks.cbegin(), m_note_ticks.cend(), start);
+    const auto last = std::upper_bound(first, m_note_ticks.cend(), end);
+    return m_notes.subspan(
+        static_cast<std::size_t>(first - m_note_ticks.cbegin()),
+        static_cast<std::size_t>(last - first));
+}
+
+std::span<const SightRead::Note>
+SightRead::NoteTrackIndex::notes(SightRead::Second start,
+                                 SightRead::Second end) const
+{
+    const auto first = std::lower_bound(m_note_seconds.cbegin(),
+                                        m_note_seconds.cend(), start);
+    const auto last = std::upper_bound(first, m_note_seconds.cend(), end);
+    return m_notes.subspan(
+        static_cast<std::size_t>(first - m_note_seconds.cbegin()),
+        static_cast<std::size_t>(last - first));
+}
+
+std::span<const SightRead::StarPower>
+SightRead::NoteTrackIndex::sp_phrases(SightRead::Tick start,
+                                      SightRead::Tick end) const
+{
+    return window(m_sp_phrases, m_sp_phrases.ticks, start, end);
+}
+
+std::span<const SightRead::StarPower>
+SightRead::NoteTrackIndex::sp_phrases(SightRead::Second start,
+                                      SightRead::Second end) const
+{
+    return window(m_sp_phrases, m_sp_phrases.seconds, start, end);
+}
+
+std::span<const SightRead::Solo>
+SightRead::NoteTrackIndex::solos(SightRead::Tick start,
+                                 SightRead::Tick end) const
+{
+    return window(m_solos, m_solos.ticks, start, end);
+}
+
+std::span<const SightRead::Solo>
+SightRead::NoteTrackIndex::solos(SightRead::Second start,
+                                 SightRead::Second end) const
+{
+    return window(m_solos, m_solos.seconds, start, end);
+}
+
+std::span<const SightRead::DrumFill>
+SightRead::NoteTrackIndex::drum_fills(SightRead::Tick start,
+                                      SightRead::Tick end) const
+{
+    return window(m_drum_fills, m_drum_fills.ticks, start, end);
+}
+
+std::span<const SightRead::DrumFill>
+SightRead::NoteTrackIndex::drum_fills(SightRead::Second start,
+                                      SightRead::Second end) const
+{
+    return window(m_drum_fills, m_drum_fills.seconds, start, end);
+}
+
+std::span<const SightRead::DiscoFlip>
+SightRead::NoteTrackIndex::disco_flips(SightRead::Tick start,
+                                       SightRead::Tick end) const
+{
+    return window(m_disco_flips, m_disco_flips.ticks, start, end);
+}
+
+std::span<const SightRead::DiscoFlip>
+SightRead::NoteTrackIndex::disco_flips(SightRead::Second start,
+                                       SightRead::Second end) const
+{
+    return window(m_disco_flips, m_disco_flips.seconds, start, end);
+}
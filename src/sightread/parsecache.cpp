@@ -0,0 +1,249 @@
+#include <bit>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "sightread/parsecache.hpp"
+
+namespace {
+// A non-cryptographic 128-bit hash, fed eight bytes at a time. Each word is
+// mixed into the low lane, and the high lane mixes in both the word and the
+// updated low lane, so the halves are not independent hashes.
+class Hasher {
+private:
+    static constexpr std::uint64_t PRIME_1 = 0x9E3779B185EBCA87ULL;
+    static constexpr std::uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+    static constexpr std::uint64_t PRIME_3 = 0x165667B19E3779F9ULL;
+
+    std::uint64_t m_low {PRIME_3};
+    std::uint64_t m_high {PRIME_1 ^ PRIME_2};
+    std::uint64_t m_length {0};
+
+    void add_word(std::uint64_t word)
+    {
+        constexpr int LOW_ROTATION = 31;
+        constexpr int HIGH_ROTATION = 27;
+
+        m_low = std::rotl(m_low ^ (word * PRIME_2), LOW_ROTATION) * PRIME_1;
+        m_high = (std::rotl(m_high + word, HIGH_ROTATION) ^ m_low) * PRIME_2
+            + PRIME_3;
+    }
+
+    static std::uint64_t avalanche(std::uint64_t value)
+    {
+        constexpr int FIRST_SHIFT = 33;
+        constexpr int SECOND_SHIFT = 29;
+        constexpr int THIRD_SHIFT = 32;
+
+        value ^= value >> FIRST_SHIFT;
+        value *= PRIME_2;
+        value ^= value >> SECOND_SHIFT;
+        value *= PRIME_3;
+        value ^= value >> THIRD_SHIFT;
+        return value;
+    }
+
+public:
+    // Each call is length-prefixed, so "ab" then "c" differs from "a" then
+    // "bc".
+    void add(const void* data, std::size_t size)
+    {
+        constexpr std::size_t WORD_SIZE = sizeof(std::uint64_t);
+
+        add_word(size);
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        std::size_t i = 0;
+        for (; i + WORD_SIZE <= size; i += WORD_SIZE) {
+            std::uint64_t word = 0;
+            std::memcpy(&word, bytes + i, WORD_SIZE); // NOLINT
+            add_word(word);
+        }
+        if (i < size) {
+            std::uint64_t word = 0;
+            std::memcpy(&word, bytes + i, size - i); // NOLINT
+            add_word(word);
+        }
+        m_length += size;
+    }
+
+    void add(std::string_view data) { add(data.data(), data.size()); }
+
+    void add(std::uint64_t value) { add(&value, sizeof(value)); }
+
+    std::pair<std::uint64_t, std::uint64_t> finish() const
+    {
+        return {avalanche(m_low ^ m_length),
+                avalanche(m_high + m_length * PRIME_1)};
+    }
+};
+
+template <typename T> std::size_t vector_bytes(const std::vector<T>& vector)
+{
+    return vector.size() * sizeof(T);
+}
+
+// The approximate heap size of a Song, from the sizes of its tracks' and
+// global data's vectors. The tempo map's derived lookup tables are about
+// proportional to its BPMs and time signatures, so only those are counted.
+std::size_t estimated_bytes(const SightRead::Song& song)
+{
+    const auto& global_data = song.global_data();
+    const auto& tempo_map = global_data.tempo_map();
+    auto bytes = sizeof(SightRead::Song) + sizeof(SightRead::SongGlobalData)
+        + global_data.name().size() + global_data.artist().size()
+        + global_data.charter().size() + vector_bytes(tempo_map.bpms())
+        + vector_bytes(tempo_map.time_sigs())
+        + vector_bytes(global_data.practice_sections())
+        + vector_bytes(global_data.od_beats());
+    for (const auto instrument : song.instruments()) {
+        for (const auto difficulty : song.difficulties(instrument)) {
+            const auto& track = song.track(instrument, difficulty);
+            bytes += sizeof(SightRead::NoteTrack) + vector_bytes(track.notes())
+                + vector_bytes(track.sp_phrases())
+                + vector_bytes(track.solos(
+                    SightRead::DrumSettings::default_settings()))
+                + vector_bytes(track.drum_fills())
+                + vector_bytes(track.disco_flips());
+        }
+    }
+    return bytes;
+}
+
+enum class KeyFormat : std::uint64_t { Chart, Midi };
+
+void add_settings(Hasher& hasher, KeyFormat format,
+                  const SightRead::Metadata& metadata,
+                  const SightRead::HopoThreshold& hopo_threshold,
+                  const std::set<SightRead::Instrument>& permitted_instruments,
+                  bool permit_solos)
+{
+    hasher.add(static_cast<std::uint64_t>(format));
+    hasher.add(metadata.name);
+    hasher.add(metadata.artist);
+    hasher.add(metadata.charter);
+    hasher.add(static_cast<std::uint64_t>(hopo_threshold.threshold_type));
+    hasher.add(
+        static_cast<std::uint64_t>(hopo_threshold.hopo_frequency.value()));
+    std::uint64_t instrument_mask = 0;
+    for (const auto instrument : permitted_instruments) {
+        instrument_mask |= 1ULL << static_cast<unsigned int>(instrument);
+    }
+    hasher.add(instrument_mask);
+    hasher.add(static_cast<std::uint64_t>(permit_solos));
+}
+}
+
+SightRead::ParseCache::ParseCache(std::size_t memory_budget)
+    : m_memory_budget {memory_budget}
+{
+}
+
+SightRead::ParseCache::Key
+SightRead::ParseCache::chart_key(const SightRead::ChartParser& parser,
+                                 std::string_view data)
+{
+    Hasher hasher;
+    add_settings(hasher, KeyFormat::Chart, parser.m_metadata,
+                 parser.m_hopo_threshold, parser.m_permitted_instruments,
+                 parser.m_permit_solos);
+    hasher.add(data);
+    const auto [low, high] = hasher.finish();
+    return {low, high};
+}
+
+SightRead::ParseCache::Key
+SightRead::ParseCache::midi_key(const SightRead::MidiParser& parser,
+                                std::span<const std::uint8_t> data)
+{
+    Hasher hasher;
+    add_settings(hasher, KeyFormat::Midi, parser.m_metadata,
+                 parser.m_hopo_threshold, parser.m_permitted_instruments,
+                 parser.m_permit_solos);
+    hasher.add(data.data(), data.size());
+    const auto [low, high] = hasher.finish();
+    return {low, high};
+}
+
+std::shared_ptr<const SightRead::Song>
+SightRead::ParseCache::find(const SightRead::ParseCache::Key& key)
+{
+    const std::lock_guard lock {m_mutex};
+    const auto entry = m_index.find(key);
+    if (entry == m_index.end()) {
+        ++m_stats.misses;
+        return nullptr;
+    }
+    ++m_stats.hits;
+    m_entries.splice(m_entries.begin(), m_entries, entry->second);
+    return entry->second->song;
+}
+
+std::shared_ptr<const SightRead::Song>
+SightRead::ParseCache::insert(const SightRead::ParseCache::Key& key,
+                              SightRead::Song song)
+{
+    const auto bytes = estimated_bytes(song);
+    auto shared_song = std::make_shared<const SightRead::Song>(std::move(song));
+
+    const std::lock_guard lock {m_mutex};
+    const auto existing = m_index.find(key);
+    if (existing != m_index.end()) {
+        // Another thread parsed the same file in the meantime.
+        m_entries.splice(m_entries.begin(), m_entries, existing->second);
+        return existing->second->song;
+    }
+    if (bytes > m_memory_budget) {
+        return shared_song;
+    }
+    while (m_stats.bytes + bytes > m_memory_budget) {
+        const auto& oldest = m_entries.back();
+        m_stats.bytes -= oldest.bytes;
+        m_index.erase(oldest.key);
+        m_entries.pop_back();
+        ++m_stats.evictions;
+    }
+    m_entries.push_front({key, shared_song, bytes});
+    m_index.emplace(key, m_entries.begin());
+    m_stats.bytes += bytes;
+    m_stats.entries = m_entries.size();
+    return shared_song;
+}
+
+std::shared_ptr<const SightRead::Song>
+SightRead::ParseCache::parse(const SightRead::ChartParser& parser,
+                             std::string_view data)
+{
+    const auto key = chart_key(parser, data);
+    auto song = find(key);
+    if (song != nullptr) {
+        return song;
+    }
+    return insert(key, parser.parse(data));
+}
+
+std::shared_ptr<const SightRead::Song>
+SightRead::ParseCache::parse(const SightRead::MidiParser& parser,
+                             std::span<const std::uint8_t> data)
+{
+    const auto key = midi_key(parser, data);
+    auto song = find(key);
+    if (song != nullptr) {
+        return song;
+    }
+    return insert(key, parser.parse(data));
+}
+
+SightRead::ParseCacheStats SightRead::ParseCache::stats() const
+{
+    const std::lock_guard lock {m_mutex};
+    return m_stats;
+}
+
+void SightRead::ParseCache::clear()
+{
+    const std::lock_guard lock {m_mutex};
+    m_entries.clear();
+    m_index.clear();
+    m_stats.entries = 0;
+    m_stats.bytes = 0;
+}
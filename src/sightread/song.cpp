@@ -1,7 +1,10 @@
 #include <algorithm>
-#include <set>
+#include <bit>
+#include <memory>
+#include <span>
 #include <stdexcept>
 #include <utility>
+#include <vector>
 
 #include "sightread/detail/parserutil.hpp"
 #include "sightread/song.hpp"
@@ -10,75 +13,84 @@ void SightRead::Song::add_note_track(SightRead::Instrument instrument,
                                      SightRead::Difficulty difficulty,
                                      SightRead::NoteTrack note_track)
 {
-    if (!note_track.notes().empty()) {
-        m_tracks.emplace(std::tuple {instrument, difficulty},
-                         std::move(note_track));
+    if (note_track.notes().empty()) {
+        return;
+    }
+    if (has_track(instrument, difficulty)) {
+        return;
     }
+    add_note_track(
+        instrument, difficulty,
+        std::make_shared<const SightRead::NoteTrack>(std::move(note_track)));
 }
 
-std::vector<SightRead::Instrument> SightRead::Song::instruments() const
+void SightRead::Song::add_note_track(
+    SightRead::Instrument instrument, SightRead::Difficulty difficulty,
+    std::shared_ptr<const SightRead::NoteTrack> note_track)
 {
-    std::set<SightRead::Instrument> instrument_set;
-    for (const auto& [key, val] : m_tracks) {
-        instrument_set.insert(std::get<0>(key));
+    if (note_track->notes().empty()) {
+        return;
     }
-
-    std::vector<SightRead::Instrument> instruments {instrument_set.cbegin(),
-                                                    instrument_set.cend()};
-    std::sort(instruments.begin(), instruments.end());
-    return instruments;
+    if (has_track(instrument, difficulty)) {
+        return;
+    }
+    const auto slot = track_slot(instrument, difficulty);
+    m_track_indices.at(slot) = static_cast<std::int8_t>(m_tracks.size());
+    m_track_mask |= 1ULL << slot;
+    m_tracks.push_back(std::move(note_track));
+    add_unison_phrases(instrument, *m_tracks.back());
 }
 
-std::vector<SightRead::Difficulty>
-SightRead::Song::difficulties(SightRead::Instrument instrument) const
+void SightRead::Song::add_unison_phrases(SightRead::Instrument instrument,
+                                         const SightRead::NoteTrack& note_track)
 {
-    std::vector<SightRead::Difficulty> difficulties;
-    for (const auto& [key, val] : m_tracks) {
-        if (std::get<0>(key) == instrument) {
-            difficulties.push_back(std::get<1>(key));
+    if (SightRead::Detail::is_six_fret_instrument(instrument)) {
+        return;
+    }
+    const auto instrument_bit = 1U << static_cast<unsigned int>(instrument);
+    for (const auto& phrase : note_track.sp_phrases()) {
+        auto& instruments = m_sp_phrase_instruments[phrase.position];
+        const auto old_instruments = instruments;
+        instruments |= instrument_bit;
+        if (std::popcount(old_instruments) == 1
+            && std::popcount(instruments) == 2) {
+            const auto position = std::lower_bound(
+                m_unison_phrase_positions.cbegin(),
+                m_unison_phrase_positions.cend(), phrase.position);
+            m_unison_phrase_positions.insert(position, phrase.position);
         }
     }
-    std::sort(difficulties.begin(), difficulties.end());
-    return difficulties;
+}
+
+bool SightRead::Song::has_instrument(SightRead::Instrument instrument) const
+{
+    return !difficulties(instrument).empty();
+}
+
+SightRead::EnumMaskView<SightRead::Instrument>
+SightRead::Song::instruments() const
+{
+    std::uint32_t mask = 0;
+    for (auto i = 0U; i < INSTRUMENT_COUNT; ++i) {
+        const auto instrument = static_cast<SightRead::Instrument>(i);
+        mask |= has_instrument(instrument) ? 1U << i : 0U;
+    }
+    return EnumMaskView<SightRead::Instrument> {mask};
 }
 
 const SightRead::NoteTrack&
 SightRead::Song::track(SightRead::Instrument instrument,
                        SightRead::Difficulty difficulty) const
 {
-    const auto insts = instruments();
-    if (std::find(insts.cbegin(), insts.cend(), instrument) == insts.cend()) {
+    if (!has_instrument(instrument)) {
         throw std::invalid_argument("Chosen instrument not present in song");
     }
-    const auto diffs = difficulties(instrument);
-    if (std::find(diffs.cbegin(), diffs.cend(), difficulty) == diffs.cend()) {
+    if (!has_track(instrument, difficulty)) {
         throw std::invalid_argument(
             "Difficulty not available for chosen instrument");
     }
-    return m_tracks.at({instrument, difficulty});
-}
-
-std::vector<SightRead::Tick> SightRead::Song::unison_phrase_positions() const
-{
-    std::map<SightRead::Tick, std::set<SightRead::Instrument>>
-        phrase_by_instrument;
-    for (const auto& [key, value] : m_tracks) {
-        const auto instrument = std::get<0>(key);
-        if (SightRead::Detail::is_six_fret_instrument(instrument)) {
-            continue;
-        }
-        for (const auto& phrase : value.sp_phrases()) {
-            phrase_by_instrument[phrase.position].insert(instrument);
-        }
-    }
-
-    std::vector<SightRead::Tick> unison_starts;
-    for (const auto& [key, value] : phrase_by_instrument) {
-        if (value.size() > 1) {
-            unison_starts.push_back(key);
-        }
-    }
-    return unison_starts;
+    const auto index = m_track_indices.at(track_slot(instrument, difficulty));
+    return *m_tracks.at(static_cast<std::size_t>(index));
 }
 
 void SightRead::Song::speedup(int speed)
@@ -92,7 +104,53 @@ void SightRead::Song::speedup(int speed)
         throw std::invalid_argument("Speed must be positive");
     }
 
+    // Copies of the Song keep the old global data. The tracks only depend on
+    // the resolution, so are shared as they are.
+    m_global_data = std::make_shared<SightRead::SongGlobalData>(*m_global_data);
     m_global_data->name(m_global_data->name() + " (" + std::to_string(speed)
                         + "%)");
     m_global_data->tempo_map(m_global_data->tempo_map().speedup(speed));
 }
+
+SightRead::Song SightRead::Song::with_speed(int speed) const
+{
+    auto song = *this;
+    song.speedup(speed);
+    return song;
+}
+
+SightRead::Song SightRead::Song::with_hopo_threshold(
+    const SightRead::HopoThreshold& hopo_threshold) const
+{
+    return std::move(with_hopo_thresholds({&hopo_threshold, 1}).front());
+}
+
+std::vector<SightRead::Song> SightRead::Song::with_hopo_thresholds(
+    std::span<const SightRead::HopoThreshold> hopo_thresholds) const
+{
+    const auto resolution = m_global_data->resolution();
+    std::vector<SightRead::Tick> max_hopo_gaps;
+    max_hopo_gaps.reserve(hopo_thresholds.size());
+    for (const auto& threshold : hopo_thresholds) {
+        max_hopo_gaps.push_back(m_global_data->is_from_midi()
+                                    ? threshold.midi_max_hopo_gap(resolution)
+                                    : threshold.chart_max_hopo_gap(resolution));
+    }
+
+    std::vector<Song> songs(hopo_thresholds.size(), *this);
+    for (auto i = 0U; i < m_tracks.size(); ++i) {
+        // Drum tracks have no HOPOs, and the MIDI parser always gives Fortnite
+        // tracks the default threshold, so neither depends on the setting.
+        const auto track_type = m_tracks[i]->track_type();
+        if (track_type != SightRead::TrackType::FiveFret
+            && track_type != SightRead::TrackType::SixFret) {
+            continue;
+        }
+        auto tracks = m_tracks[i]->with_hopos(max_hopo_gaps);
+        for (auto j = 0U; j < songs.size(); ++j) {
+            songs[j].m_tracks[i] = std::make_shared<const SightRead::NoteTrack>(
+                std::move(tracks[j]));
+        }
+    }
+    return songs;
+}
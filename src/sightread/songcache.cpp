@@ -0,0 +1,355 @@
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "sightread/detail/mappedfile.hpp"
+#include "sightread/songcache.hpp"
+
+namespace {
+constexpr std::array<char, 4> CACHE_MAGIC {'S', 'R', 'S', 'C'};
+constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+constexpr std::size_t ARRAY_ALIGNMENT = 8;
+constexpr std::size_t INSTRUMENT_COUNT
+    = static_cast<std::size_t>(SightRead::Instrument::FortniteVocals) + 1;
+constexpr std::size_t DIFFICULTY_COUNT
+    = static_cast<std::size_t>(SightRead::Difficulty::Expert) + 1;
+constexpr std::size_t TRACK_TYPE_COUNT
+    = static_cast<std::size_t>(SightRead::TrackType::FortniteFestival) + 1;
+
+class CacheWriter {
+private:
+    std::vector<std::uint8_t> m_data;
+
+    void write_bytes(const void* bytes, std::size_t size)
+    {
+        const auto offset = m_data.size();
+        m_data.resize(offset + size);
+        if (size > 0) {
+            std::memcpy(m_data.data() + offset, bytes, size);
+        }
+    }
+
+public:
+    template <typename T> void write(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        write_bytes(&value, sizeof(T));
+    }
+
+    void write_string(const std::string& value)
+    {
+        write(static_cast<std::uint64_t>(value.size()));
+        write_bytes(value.data(), value.size());
+    }
+
+    // Arrays are aligned relative to the start of the snapshot so that a
+    // mapping of it can be read in place.
+    template <typename T> void write_array(const std::vector<T>& values)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        write(static_cast<std::uint64_t>(values.size()));
+        m_data.resize((m_data.size() + ARRAY_ALIGNMENT - 1)
+                      & ~(ARRAY_ALIGNMENT - 1));
+        write_bytes(values.data(), values.size() * sizeof(T));
+    }
+
+    [[nodiscard]] std::vector<std::uint8_t> take() &&
+    {
+        return std::move(m_data);
+    }
+};
+
+class CacheReader {
+private:
+    std::span<const std::uint8_t> m_data;
+    std::size_t m_offset {0};
+
+    void read_bytes(void* bytes, std::size_t size)
+    {
+        if (size > m_data.size() - m_offset) {
+            throw SightRead::ParseError("Song cache is truncated");
+        }
+        if (size > 0) {
+            std::memcpy(bytes, m_data.data() + m_offset, size);
+        }
+        m_offset += size;
+    }
+
+    std::size_t read_count(std::size_t element_size)
+    {
+        const auto count = read<std::uint64_t>();
+        if (count > (m_data.size() - m_offset) / element_size) {
+            throw SightRead::ParseError("Song cache is truncated");
+        }
+        return static_cast<std::size_t>(count);
+    }
+
+public:
+    explicit CacheReader(std::span<const std::uint8_t> data)
+        : m_data {data}
+    {
+    }
+
+    template <typename T> T read()
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        std::array<std::uint8_t, sizeof(T)> bytes {};
+        read_bytes(bytes.data(), sizeof(T));
+        return std::bit_cast<T>(bytes);
+    }
+
+    std::string read_string()
+    {
+        std::string value(read_count(1), '\0');
+        read_bytes(value.data(), value.size());
+        return value;
+    }
+
+    template <typename T> std::vector<T> read_array()
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const auto count = read_count(sizeof(T));
+        const auto aligned_offset
+            = (m_offset + ARRAY_ALIGNMENT - 1) & ~(ARRAY_ALIGNMENT - 1);
+        if (aligned_offset > m_data.size()) {
+            throw SightRead::ParseError("Song cache is truncated");
+        }
+        m_offset = aligned_offset;
+        if (count * sizeof(T) > m_data.size() - m_offset) {
+            throw SightRead::ParseError("Song cache is truncated");
+        }
+        // Not every element type is default constructible, so the elements
+        // are copied out one at a time; this still compiles down to a bulk
+        // copy.
+        std::vector<T> values;
+        values.reserve(count);
+        for (auto i = 0U; i < count; ++i) {
+            std::array<std::uint8_t, sizeof(T)> bytes {};
+            std::memcpy(bytes.data(), m_data.data() + m_offset, sizeof(T));
+            values.push_back(std::bit_cast<T>(bytes));
+            m_offset += sizeof(T);
+        }
+        return values;
+    }
+
+    [[nodiscard]] bool at_end() const { return m_offset == m_data.size(); }
+};
+
+template <typename T> T read_enum(CacheReader& reader, std::size_t count)
+{
+    const auto value = reader.read<std::uint8_t>();
+    if (value >= count) {
+        throw SightRead::ParseError("Song cache has invalid enum value");
+    }
+    return static_cast<T>(value);
+}
+
+// BPM has padding, so is written field by field to keep snapshots of the same
+// song byte-identical.
+void write_bpms(CacheWriter& writer, const std::vector<SightRead::BPM>& bpms)
+{
+    std::vector<SightRead::Tick> positions;
+    std::vector<std::int64_t> values;
+    positions.reserve(bpms.size());
+    values.reserve(bpms.size());
+    for (const auto& bpm : bpms) {
+        positions.push_back(bpm.position);
+        values.push_back(bpm.bpm);
+    }
+    writer.write_array(positions);
+    writer.write_array(values);
+}
+
+std::vector<SightRead::BPM> read_bpms(CacheReader& reader)
+{
+    const auto positions = reader.read_array<SightRead::Tick>();
+    const auto values = reader.read_array<std::int64_t>();
+    if (positions.size() != values.size()) {
+        throw SightRead::ParseError("Song cache has mismatched BPMs");
+    }
+    std::vector<SightRead::BPM> bpms;
+    bpms.reserve(positions.size());
+    for (auto i = 0U; i < positions.size(); ++i) {
+        bpms.push_back({positions[i], values[i]});
+    }
+    return bpms;
+}
+}
+
+std::vector<std::uint8_t>
+SightRead::SongCache::save(const SightRead::Song& song)
+{
+    CacheWriter writer;
+    writer.write(CACHE_MAGIC);
+    writer.write(VERSION);
+    writer.write(BYTE_ORDER_MARK);
+    writer.write(static_cast<std::uint32_t>(sizeof(SightRead::Note)));
+
+    const auto& global_data = song.global_data();
+    writer.write(static_cast<std::uint8_t>(global_data.is_from_midi()));
+    writer.write(global_data.resolution());
+    writer.write_string(global_data.name());
+    writer.write_string(global_data.artist());
+    writer.write_string(global_data.charter());
+    writer.write(
+        static_cast<std::uint64_t>(global_data.practice_sections().size()));
+    for (const auto& section : global_data.practice_sections()) {
+        writer.write_string(section.name);
+        writer.write(section.start);
+    }
+    writer.write_array(global_data.od_beats());
+
+    const auto& tempo_map = global_data.tempo_map();
+    writer.write_array(tempo_map.m_time_sigs);
+    write_bpms(writer, tempo_map.m_bpms);
+    writer.write_array(tempo_map.m_od_beats);
+    writer.write(tempo_map.m_resolution);
+    const auto write_conversion = [&](const auto& conversion) {
+        writer.write_array(conversion.m_xs);
+        writer.write_array(conversion.m_ys);
+        writer.write_array(conversion.m_x_spans);
+        writer.write_array(conversion.m_y_spans);
+        writer.write(conversion.m_lead_rate);
+        writer.write(conversion.m_tail_rate);
+    };
+    write_conversion(tempo_map.m_beats_to_seconds);
+    write_conversion(tempo_map.m_seconds_to_beats);
+    write_conversion(tempo_map.m_measures_to_beats);
+    write_conversion(tempo_map.m_beats_to_measures);
+    write_conversion(tempo_map.m_od_beats_to_beats);
+    write_conversion(tempo_map.m_beats_to_od_beats);
+
+    std::vector<std::pair<SightRead::Instrument, SightRead::Difficulty>> slots;
+    for (const auto instrument : song.instruments()) {
+        for (const auto difficulty : song.difficulties(instrument)) {
+            slots.emplace_back(instrument, difficulty);
+        }
+    }
+    writer.write(static_cast<std::uint64_t>(slots.size()));
+    for (const auto& [instrument, difficulty] : slots) {
+        const auto& track = song.track(instrument, difficulty);
+        writer.write(static_cast<std::uint8_t>(instrument));
+        writer.write(static_cast<std::uint8_t>(difficulty));
+        writer.write(static_cast<std::uint8_t>(track.m_track_type));
+        writer.write_array(track.m_notes);
+        writer.write_array(track.m_sp_phrases);
+        writer.write_array(track.m_solos);
+        writer.write_array(track.m_drum_fills);
+        writer.write_array(track.m_disco_flips);
+        writer.write(static_cast<std::uint8_t>(track.m_bre.has_value()));
+        if (track.m_bre.has_value()) {
+            writer.write(*track.m_bre);
+        }
+        writer.write(track.m_base_score_ticks);
+    }
+
+    return std::move(writer).take();
+}
+
+SightRead::Song
+SightRead::SongCache::load(std::span<const std::uint8_t> data)
+{
+    CacheReader reader {data};
+    if (reader.read<std::array<char, 4>>() != CACHE_MAGIC) {
+        throw SightRead::ParseError("Data is not a song cache");
+    }
+    if (reader.read<std::uint32_t>() != VERSION) {
+        throw SightRead::ParseError("Unsupported song cache version");
+    }
+    if (reader.read<std::uint32_t>() != BYTE_ORDER_MARK
+        || reader.read<std::uint32_t>() != sizeof(SightRead::Note)) {
+        throw SightRead::ParseError("Song cache is from another platform");
+    }
+
+    SightRead::Song song;
+    auto& global_data = song.global_data();
+    global_data.is_from_midi(reader.read<std::uint8_t>() != 0);
+    global_data.resolution(reader.read<int>());
+    global_data.name(reader.read_string());
+    global_data.artist(reader.read_string());
+    global_data.charter(reader.read_string());
+    const auto section_count = reader.read<std::uint64_t>();
+    std::vector<SightRead::PracticeSection> practice_sections;
+    for (auto i = 0U; i < section_count; ++i) {
+        auto name = reader.read_string();
+        practice_sections.push_back(
+            {std::move(name), reader.read<SightRead::Tick>()});
+    }
+    global_data.practice_sections(std::move(practice_sections));
+    global_data.od_beats(reader.read_array<SightRead::Tick>());
+
+    SightRead::TempoMap tempo_map;
+    tempo_map.m_time_sigs = reader.read_array<SightRead::TimeSignature>();
+    tempo_map.m_bpms = read_bpms(reader);
+    tempo_map.m_od_beats = reader.read_array<SightRead::Tick>();
+    tempo_map.m_resolution = reader.read<int>();
+    // Every conversion needs at least one point, with all four arrays the
+    // same size.
+    bool has_valid_conversions = true;
+    const auto read_conversion = [&](auto& conversion) {
+        using Rate = SightRead::TempoMap::PiecewiseLinear::Rate;
+        conversion.m_xs = reader.read_array<double>();
+        conversion.m_ys = reader.read_array<double>();
+        conversion.m_x_spans = reader.read_array<double>();
+        conversion.m_y_spans = reader.read_array<double>();
+        conversion.m_lead_rate = reader.read<Rate>();
+        conversion.m_tail_rate = reader.read<Rate>();
+        const auto size = conversion.m_xs.size();
+        has_valid_conversions = has_valid_conversions && size > 0
+            && conversion.m_ys.size() == size
+            && conversion.m_x_spans.size() == size
+            && conversion.m_y_spans.size() == size;
+    };
+    read_conversion(tempo_map.m_beats_to_seconds);
+    read_conversion(tempo_map.m_seconds_to_beats);
+    read_conversion(tempo_map.m_measures_to_beats);
+    read_conversion(tempo_map.m_beats_to_measures);
+    read_conversion(tempo_map.m_od_beats_to_beats);
+    read_conversion(tempo_map.m_beats_to_od_beats);
+    if (tempo_map.m_time_sigs.empty() || tempo_map.m_bpms.empty()
+        || tempo_map.m_resolution <= 0 || !has_valid_conversions) {
+        throw SightRead::ParseError("Song cache has invalid tempo map");
+    }
+    global_data.tempo_map(std::move(tempo_map));
+
+    const auto track_count = reader.read<std::uint64_t>();
+    for (auto i = 0U; i < track_count; ++i) {
+        const auto instrument
+            = read_enum<SightRead::Instrument>(reader, INSTRUMENT_COUNT);
+        const auto difficulty
+            = read_enum<SightRead::Difficulty>(reader, DIFFICULTY_COUNT);
+        const auto track_type
+            = read_enum<SightRead::TrackType>(reader, TRACK_TYPE_COUNT);
+        SightRead::NoteTrack track {
+            {}, {}, track_type, song.global_data_ptr()};
+        track.m_notes = reader.read_array<SightRead::Note>();
+        track.m_sp_phrases = reader.read_array<SightRead::StarPower>();
+        track.m_solos = reader.read_array<SightRead::Solo>();
+        track.m_drum_fills = reader.read_array<SightRead::DrumFill>();
+        track.m_disco_flips = reader.read_array<SightRead::DiscoFlip>();
+        if (reader.read<std::uint8_t>() != 0) {
+            track.m_bre = reader.read<SightRead::BigRockEnding>();
+        }
+        track.m_base_score_ticks = reader.read<int>();
+        track.compute_lane_counts();
+        track.cache_drum_solos();
+        song.add_note_track(instrument, difficulty, std::move(track));
+    }
+
+    if (!reader.at_end()) {
+        throw SightRead::ParseError("Song cache has trailing data");
+    }
+    return song;
+}
+
+SightRead::Song
+SightRead::SongCache::load_file(const std::filesystem::path& path)
+{
+    const SightRead::Detail::MappedFile file {path};
+    return load(file.data());
+}
@@ -1,38 +1,111 @@
 #include <algorithm>
+#include <bit>
 #include <cstdlib>
+#include <iterator>
+#include <limits>
 #include <stdexcept>
 #include <tuple>
 
 #include "sightread/songparts.hpp"
 
 namespace {
-SightRead::Note
-combined_note(std::vector<SightRead::Note>::const_iterator begin,
-              std::vector<SightRead::Note>::const_iterator end)
-{
-    SightRead::Note note = *begin;
-    ++begin;
-    while (begin < end) {
-        for (auto i = 0U; i < note.lengths.size(); ++i) {
-            const auto new_length = begin->lengths.at(i);
-            if (new_length != SightRead::Tick {-1}) {
-                note.lengths.at(i) = new_length;
-            }
+void merge_note_lengths(SightRead::Note& note, const SightRead::Note& other)
+{
+    for (auto i = 0U; i < note.lengths.size(); ++i) {
+        const auto new_length = other.lengths.at(i);
+        if (new_length != SightRead::Tick {-1}) {
+            note.lengths.at(i) = new_length;
         }
-        ++begin;
     }
-    return note;
 }
 
-bool is_chord(const SightRead::Note& note)
+// Written without branches inside the loop so the compiler can vectorise it.
+int lane_count(const SightRead::Note& note)
 {
     auto count = 0;
     for (auto length : note.lengths) {
-        if (length != SightRead::Tick {-1}) {
-            ++count;
-        }
+        count += static_cast<int>(length != SightRead::Tick {-1});
+    }
+    return count;
+}
+
+bool is_chord(const SightRead::Note& note) { return lane_count(note) >= 2; }
+
+// Whether a note is a HOPO when the gap to the previous note is at most the
+// HOPO threshold, whether it is when the gap is larger, and that gap. Only the
+// comparison of the gap depends on the threshold, so this is worked out once
+// per note however many thresholds are tried.
+struct HopoCandidate {
+    bool within_threshold;
+    bool beyond_threshold;
+    SightRead::Tick gap;
+};
+
+HopoCandidate hopo_candidate(const SightRead::Note& note,
+                             const SightRead::Note* prev_note)
+{
+    if ((note.flags & (SightRead::FLAGS_TAP | SightRead::FLAGS_FORCE_STRUM))
+        != 0U) {
+        return {false, false, SightRead::Tick {0}};
+    }
+    const bool is_forced_hopo
+        = (note.flags & SightRead::FLAGS_FORCE_HOPO) != 0U;
+    const bool is_flipped = (note.flags & SightRead::FLAGS_FORCE_FLIP) != 0U;
+    if (prev_note == nullptr || is_chord(note)
+        || note.colours() == prev_note->colours()) {
+        const bool is_hopo = is_flipped || is_forced_hopo;
+        return {is_hopo, is_hopo, SightRead::Tick {0}};
+    }
+    return {!is_flipped || is_forced_hopo, is_flipped || is_forced_hopo,
+            note.position - prev_note->position};
+}
+
+bool is_hopo(const SightRead::Note& note, const SightRead::Note* prev_note,
+             SightRead::Tick max_hopo_gap)
+{
+    const auto candidate = hopo_candidate(note, prev_note);
+    return candidate.gap <= max_hopo_gap ? candidate.within_threshold
+                                         : candidate.beyond_threshold;
+}
+
+SightRead::NoteFlags with_hopo_flag(SightRead::NoteFlags flags, bool is_hopo)
+{
+    const auto hopo_flag = is_hopo ? SightRead::FLAGS_HOPO : 0U;
+    return static_cast<SightRead::NoteFlags>((flags & ~SightRead::FLAGS_HOPO)
+                                             | hopo_flag);
+}
+
+// A chord whose lanes all have the same length counts that length once,
+// otherwise every lane's length counts.
+SightRead::Tick sustain_ticks(const SightRead::Note& note)
+{
+    auto min_length = std::numeric_limits<int>::max();
+    auto max_length = std::numeric_limits<int>::min();
+    auto length_sum = 0;
+    auto has_lane = false;
+    for (auto length : note.lengths) {
+        const auto value = length.value();
+        const auto is_active = value != -1;
+        min_length = std::min(
+            min_length, is_active ? value : std::numeric_limits<int>::max());
+        max_length = std::max(
+            max_length, is_active ? value : std::numeric_limits<int>::min());
+        length_sum += is_active ? value : 0;
+        has_lane = has_lane || is_active;
+    }
+    if (!has_lane) {
+        return SightRead::Tick {0};
     }
-    return count >= 2;
+    return SightRead::Tick {min_length == max_length ? min_length
+                                                     : length_sum};
+}
+
+int base_score_ticks(SightRead::Tick total_ticks, int resolution)
+{
+    constexpr int BASE_SUSTAIN_DENSITY = 25;
+
+    return (total_ticks.value() * BASE_SUSTAIN_DENSITY + resolution - 1)
+        / resolution;
 }
 }
 
@@ -119,110 +192,191 @@ bool SightRead::Note::is_skipped_kick(
     return !settings.enable_double_kick;
 }
 
-void SightRead::NoteTrack::compute_base_score_ticks()
+SightRead::NoteColumns::NoteColumns(std::span<const Note> notes)
 {
-    constexpr int BASE_SUSTAIN_DENSITY = 25;
-
-    SightRead::Tick total_ticks {0};
-    for (const auto& note : m_notes) {
-        std::vector<SightRead::Tick> constituent_lengths;
+    m_positions.reserve(notes.size());
+    m_colours.reserve(notes.size());
+    m_flags.reserve(notes.size());
+    m_length_offsets.reserve(notes.size() + 1);
+    m_length_offsets.push_back(0);
+    for (const auto& note : notes) {
+        m_positions.push_back(note.position);
+        m_colours.push_back(static_cast<std::uint8_t>(note.colours()));
+        m_flags.push_back(note.flags);
         for (auto length : note.lengths) {
             if (length != SightRead::Tick {-1}) {
-                constituent_lengths.push_back(length);
+                m_lengths.push_back(length);
             }
         }
-        std::sort(constituent_lengths.begin(), constituent_lengths.end());
-        if (constituent_lengths.front() == constituent_lengths.back()) {
-            total_ticks += constituent_lengths.front();
-        } else {
-            for (auto length : constituent_lengths) {
-                total_ticks += length;
+        m_length_offsets.push_back(
+            static_cast<std::uint32_t>(m_lengths.size()));
+    }
+}
+
+std::span<const SightRead::Tick>
+SightRead::NoteColumns::lengths(std::size_t index) const
+{
+    const auto start = m_length_offsets.at(index);
+    const auto end = m_length_offsets.at(index + 1);
+    return std::span {m_lengths}.subspan(start, end - start);
+}
+
+SightRead::Tick SightRead::NoteColumns::length(std::size_t index,
+                                               unsigned int lane) const
+{
+    constexpr auto LANE_COUNT = std::tuple_size_v<decltype(Note::lengths)>;
+
+    if (lane >= LANE_COUNT) {
+        return SightRead::Tick {-1};
+    }
+    const auto colours = m_colours.at(index);
+    const auto lane_bit = 1U << lane;
+    if ((colours & lane_bit) == 0U) {
+        return SightRead::Tick {-1};
+    }
+    const auto lower_lanes = colours & (lane_bit - 1);
+    return m_lengths[m_length_offsets[index]
+                     + static_cast<unsigned int>(std::popcount(lower_lanes))];
+}
+
+SightRead::Note SightRead::NoteColumns::note(std::size_t index) const
+{
+    Note note;
+    note.position = m_positions.at(index);
+    note.flags = m_flags[index];
+    for (auto lane = 0U; lane < note.lengths.size(); ++lane) {
+        note.lengths.at(lane) = length(index, lane);
+    }
+    return note;
+}
+
+void SightRead::NoteTrack::dedupe_and_merge_notes()
+{
+    // Fortnite Festival notes at the same time are separate gems rather than
+    // a chord.
+    const bool merge_notes = m_track_type != TrackType::Drums
+        && m_track_type != TrackType::FortniteFestival;
+
+    // Of consecutive notes with the same position and colours only the last
+    // is kept, then the kept notes at each position are merged into the first
+    // unless merging is off. Notes are only ever written at or before the
+    // note being read, so this is done in place.
+    auto kept_end = m_notes.begin();
+    for (auto p = m_notes.begin(); p < m_notes.end();) {
+        auto group_end = std::next(p);
+        while (group_end < m_notes.end()
+               && group_end->position == p->position) {
+            ++group_end;
+        }
+        bool has_kept_note = false;
+        for (auto q = p; q < group_end; ++q) {
+            const auto next = std::next(q);
+            if (next < group_end && next->colours() == q->colours()) {
+                continue;
+            }
+            if (merge_notes && has_kept_note) {
+                merge_note_lengths(*std::prev(kept_end), *q);
+                continue;
             }
+            if (kept_end != q) {
+                *kept_end = *q;
+            }
+            ++kept_end;
+            has_kept_note = true;
         }
+        p = group_end;
     }
-
-    const auto resolution = m_global_data->resolution();
-    m_base_score_ticks
-        = (total_ticks.value() * BASE_SUSTAIN_DENSITY + resolution - 1)
-        / resolution;
+    m_notes.erase(kept_end, m_notes.end());
 }
 
 void SightRead::NoteTrack::merge_same_time_notes()
 {
-  if (m_track_type == TrackType::Drums) {
+    // Fortnite Festival notes at the same time are separate gems, as the
+    // constructor keeps them.
+    if (m_track_type == TrackType::Drums
+        || m_track_type == TrackType::FortniteFestival) {
         return;
     }
 
-    std::vector<Note> notes;
-    for (auto p = m_notes.cbegin(); p < m_notes.cend();) {
-        auto q = p;
-        while (q < m_notes.cend() && p->position == q->position) {
+    // Each group of notes at the same position is merged into its first note,
+    // which is then moved down to the end of the merged notes so far.
+    auto merged_end = m_notes.begin();
+    for (auto p = m_notes.begin(); p < m_notes.end();) {
+        auto q = std::next(p);
+        while (q < m_notes.end() && p->position == q->position) {
+            merge_note_lengths(*p, *q);
             ++q;
         }
-        notes.push_back(combined_note(p, q));
+        if (merged_end != p) {
+            *merged_end = *p;
+        }
+        ++merged_end;
         p = q;
     }
-    m_notes = std::move(notes);
+    m_notes.erase(merged_end, m_notes.end());
 }
 
-void SightRead::NoteTrack::add_hopos(SightRead::Tick max_hopo_gap)
+void SightRead::NoteTrack::finish_notes(SightRead::Tick max_hopo_gap)
 {
-    if (m_track_type == TrackType::Drums) {
-        return;
-    }
+    const bool add_hopos = m_track_type != TrackType::Drums;
 
+    SightRead::Tick total_ticks {0};
     for (auto i = 0U; i < m_notes.size(); ++i) {
-        if ((m_notes[i].flags & (FLAGS_TAP | FLAGS_FORCE_STRUM)) != 0U) {
-            continue;
-        }
-        bool is_hopo = (m_notes[i].flags & FLAGS_FORCE_FLIP) != 0U;
-        if (i != 0U) {
-            const auto note_gap = m_notes[i].position - m_notes[i - 1].position;
-            if (!is_chord(m_notes[i])
-                && m_notes[i].colours() != m_notes[i - 1].colours()
-                && note_gap <= max_hopo_gap) {
-                is_hopo = !is_hopo;
-            }
-        }
-        if ((m_notes[i].flags & FLAGS_FORCE_HOPO) != 0U) {
-            is_hopo = true;
+        auto& note = m_notes[i];
+        // We handle open note merging after counting sustains because in v23
+        // the removed notes still affect the base score.
+        total_ticks += sustain_ticks(note);
+        note.merge_non_opens_into_open();
+        if (add_hopos
+            && is_hopo(note, i == 0U ? nullptr : &m_notes[i - 1],
+                       max_hopo_gap)) {
+            note.flags = static_cast<NoteFlags>(note.flags | FLAGS_HOPO);
         }
-        if (is_hopo) {
-            m_notes[i].flags
-                = static_cast<NoteFlags>(m_notes[i].flags | FLAGS_HOPO);
+    }
+    m_base_score_ticks
+        = base_score_ticks(total_ticks, m_resolution);
+    compute_lane_counts();
+}
+
+void SightRead::NoteTrack::compute_lane_counts()
+{
+    m_kick_lane_count = 0;
+    m_double_kick_lane_count = 0;
+    m_other_lane_count = 0;
+    for (const auto& note : m_notes) {
+        const auto lanes = lane_count(note);
+        if (!note.is_kick_note()) {
+            m_other_lane_count += lanes;
+        } else if (note.lengths[DRUM_KICK] != SightRead::Tick {-1}) {
+            m_kick_lane_count += lanes;
+        } else {
+            m_double_kick_lane_count += lanes;
         }
     }
 }
 
-SightRead::NoteTrack::NoteTrack(std::vector<Note> notes,
-                                const std::vector<StarPower>& sp_phrases,
-                                TrackType track_type,
-                                std::shared_ptr<SongGlobalData> global_data,
-                                SightRead::Tick max_hopo_gap)
+SightRead::NoteTrack::NoteTrack(
+    std::vector<Note> notes, const std::vector<StarPower>& sp_phrases,
+    TrackType track_type, const std::shared_ptr<SongGlobalData>& global_data,
+    SightRead::Tick max_hopo_gap)
     : m_track_type {track_type}
-    , m_global_data {std::move(global_data)}
+    , m_resolution {0}
     , m_base_score_ticks {0}
 {
-    if (m_global_data == nullptr) {
+    if (global_data == nullptr) {
         throw std::runtime_error("Non-null global data required");
     }
-
-    std::stable_sort(notes.begin(), notes.end(),
-                     [](const auto& lhs, const auto& rhs) {
-                         return lhs.position < rhs.position;
-                     });
-
-    if (!notes.empty()) {
-        auto prev_note = notes.cbegin();
-        for (auto p = notes.cbegin() + 1; p < notes.cend(); ++p) {
-            if (p->position != prev_note->position
-                || p->colours() != prev_note->colours()) {
-                m_notes.push_back(*prev_note);
-            }
-            prev_note = p;
-        }
-        m_notes.push_back(*prev_note);
+    m_resolution = global_data->resolution();
+
+    // Parsers nearly always give notes in order already.
+    const auto position_order = [](const auto& lhs, const auto& rhs) {
+        return lhs.position < rhs.position;
+    };
+    if (!std::is_sorted(notes.cbegin(), notes.cend(), position_order)) {
+        std::stable_sort(notes.begin(), notes.end(), position_order);
     }
+    m_notes = std::move(notes);
+    dedupe_and_merge_notes();
 
     std::vector<SightRead::Tick> sp_starts;
     std::vector<SightRead::Tick> sp_ends;
@@ -234,42 +388,31 @@ SightRead::NoteTrack::NoteTrack(std::vector<Note> notes,
         sp_ends.push_back(phrase.position + phrase.length);
     }
 
-    std::sort(sp_starts.begin(), sp_starts.end());
-    std::sort(sp_ends.begin(), sp_ends.end());
+    if (!std::is_sorted(sp_starts.cbegin(), sp_starts.cend())) {
+        std::sort(sp_starts.begin(), sp_starts.end());
+    }
+    if (!std::is_sorted(sp_ends.cbegin(), sp_ends.cend())) {
+        std::sort(sp_ends.begin(), sp_ends.end());
+    }
 
-    std::vector<StarPower> new_sp_phrases;
-    new_sp_phrases.reserve(sp_phrases.size());
+    m_sp_phrases.reserve(sp_phrases.size());
     for (auto i = 0U; i < sp_phrases.size(); ++i) {
         auto start = sp_starts[i];
         if (i > 0) {
             start = std::max(sp_starts[i], sp_ends[i - 1]);
         }
-        const auto length = sp_ends[i] - start;
-        new_sp_phrases.push_back({start, length});
-    }
-
-    for (const auto& phrase : new_sp_phrases) {
+        const auto end = sp_ends[i];
         const auto first_note = std::lower_bound(
-            m_notes.cbegin(), m_notes.cend(), phrase.position,
+            m_notes.cbegin(), m_notes.cend(), start,
             [](const auto& lhs, const auto& rhs) {
                 return lhs.position < rhs;
             });
-        if ((first_note != m_notes.cend())
-            && (first_note->position < (phrase.position + phrase.length))) {
-            m_sp_phrases.push_back(phrase);
+        if ((first_note != m_notes.cend()) && (first_note->position < end)) {
+            m_sp_phrases.push_back({start, end - start});
         }
     }
 
-    merge_same_time_notes();
-    compute_base_score_ticks();
-
-    // We handle open note merging at the end because in v23 the removed
-    // notes still affect the base score.
-    for (auto& note : m_notes) {
-        note.merge_non_opens_into_open();
-    }
-
-    add_hopos(max_hopo_gap);
+    finish_notes(max_hopo_gap);
 }
 
 void SightRead::NoteTrack::generate_drum_fills(
@@ -283,26 +426,40 @@ void SightRead::NoteTrack::generate_drum_fills(
     }
 
     std::vector<std::tuple<SightRead::Second, SightRead::Tick>> note_times;
+    note_times.reserve(m_notes.size());
+    auto tempo_cursor = tempo_map.cursor();
     for (const auto& n : m_notes) {
-        const auto seconds = tempo_map.to_seconds(n.position);
+        const auto seconds = tempo_cursor.to_seconds(n.position);
         note_times.emplace_back(seconds, n.position);
     }
-    const auto final_note_s = tempo_map.to_seconds(m_notes.back().position);
+    const auto final_note_s = std::get<0>(note_times.back());
     const auto measure_bound = tempo_map.to_measures(final_note_s + FILL_DELAY);
+    // The notes too early to be close to a measure are also too early for all
+    // later measures, so the search for close notes can start from a cursor
+    // that only moves forward. The measures only move forward too, so they are
+    // converted with a Cursor, and the start of a measure is reused as the end
+    // of the one before it.
+    auto first_candidate = note_times.cbegin();
+    auto measure_cursor = tempo_map.cursor();
+    auto prev_m_seconds = measure_cursor.to_seconds(SightRead::Measure {0.0});
     SightRead::Measure m {1.0};
     while (m <= measure_bound) {
-        const auto fill_seconds = tempo_map.to_seconds(m);
-        const auto measure_ticks = tempo_map.to_ticks(tempo_map.to_beats(m));
+        const auto measure_beats = measure_cursor.to_beats(m);
+        const auto fill_seconds = measure_cursor.to_seconds(measure_beats);
+        const auto measure_ticks = tempo_map.to_ticks(measure_beats);
+        while (first_candidate != note_times.cend()
+               && std::get<0>(*first_candidate) - fill_seconds + FILL_DELAY
+                   < SightRead::Second {0}) {
+            ++first_candidate;
+        }
         bool exists_close_note = false;
         SightRead::Tick close_note_position {0};
-        for (const auto& [s, pos] : note_times) {
+        for (auto p = first_candidate; p != note_times.cend(); ++p) {
+            const auto& [s, pos] = *p;
             const auto s_diff = s - fill_seconds;
             if (s_diff > FILL_DELAY) {
                 break;
             }
-            if (s_diff + FILL_DELAY < SightRead::Second {0}) {
-                continue;
-            }
             if (!exists_close_note) {
                 exists_close_note = true;
                 close_note_position = pos;
@@ -313,16 +470,15 @@ void SightRead::NoteTrack::generate_drum_fills(
         }
         if (!exists_close_note) {
             m += SightRead::Measure(1.0);
+            prev_m_seconds = fill_seconds;
             continue;
         }
-        const auto m_seconds = tempo_map.to_seconds(m);
-        const auto prev_m_seconds
-            = tempo_map.to_seconds(m - SightRead::Measure(1.0));
-        const auto mid_m_seconds = (m_seconds + prev_m_seconds) * 0.5;
-        const auto fill_start = tempo_map.to_ticks(mid_m_seconds);
+        const auto mid_m_seconds = (fill_seconds + prev_m_seconds) * 0.5;
+        const auto fill_start = measure_cursor.to_ticks(mid_m_seconds);
         m_drum_fills.push_back(
             DrumFill {fill_start, measure_ticks - fill_start});
         m += FILL_GAP;
+        prev_m_seconds = measure_cursor.to_seconds(m - SightRead::Measure(1.0));
     }
 }
 
@@ -333,14 +489,18 @@ void SightRead::NoteTrack::disable_dynamics()
     }
 }
 
-std::vector<SightRead::Solo>
-SightRead::NoteTrack::solos(const SightRead::DrumSettings& drum_settings) const
+std::size_t SightRead::NoteTrack::drum_solo_index(
+    const SightRead::DrumSettings& drum_settings)
+{
+    return (drum_settings.disable_kick ? 1U : 0U)
+        | (drum_settings.enable_double_kick ? 2U : 0U);
+}
+
+std::vector<SightRead::Solo> SightRead::NoteTrack::compute_drum_solos(
+    const SightRead::DrumSettings& drum_settings) const
 {
     constexpr int SOLO_NOTE_VALUE = 100;
 
-    if (m_track_type != TrackType::Drums) {
-        return m_solos;
-    }
     auto solos = m_solos;
     auto p = m_notes.cbegin();
     auto q = solos.begin();
@@ -362,12 +522,38 @@ SightRead::NoteTrack::solos(const SightRead::DrumSettings& drum_settings) const
     return solos;
 }
 
+void SightRead::NoteTrack::cache_drum_solos()
+{
+    if (m_track_type != TrackType::Drums) {
+        return;
+    }
+    // Only the kick settings affect which notes count towards a solo.
+    for (auto disable_kick : {false, true}) {
+        for (auto enable_double_kick : {false, true}) {
+            const DrumSettings settings {enable_double_kick, disable_kick,
+                                         true, false};
+            m_drum_solos.at(drum_solo_index(settings))
+                = compute_drum_solos(settings);
+        }
+    }
+}
+
+const std::vector<SightRead::Solo>&
+SightRead::NoteTrack::solos(const SightRead::DrumSettings& drum_settings) const
+{
+    if (m_track_type != TrackType::Drums) {
+        return m_solos;
+    }
+    return m_drum_solos.at(drum_solo_index(drum_settings));
+}
+
 void SightRead::NoteTrack::solos(std::vector<Solo> solos)
 {
     std::stable_sort(
         solos.begin(), solos.end(),
         [](const auto& lhs, const auto& rhs) { return lhs.start < rhs.start; });
     m_solos = std::move(solos);
+    cache_drum_solos();
 }
 
 int SightRead::NoteTrack::base_score(
@@ -375,54 +561,142 @@ int SightRead::NoteTrack::base_score(
 {
     constexpr int BASE_NOTE_VALUE = 50;
 
-    auto note_count = 0;
-    for (const auto& note : m_notes) {
-        if (note.is_skipped_kick(drum_settings)) {
-            continue;
-        }
-        for (auto l : note.lengths) {
-            if (l != SightRead::Tick {-1}) {
-                ++note_count;
-            }
-        }
+    auto note_count = m_other_lane_count;
+    if (!drum_settings.disable_kick) {
+        note_count += m_kick_lane_count;
+    }
+    if (drum_settings.enable_double_kick) {
+        note_count += m_double_kick_lane_count;
     }
 
     return BASE_NOTE_VALUE * note_count + m_base_score_ticks;
 }
 
-SightRead::NoteTrack SightRead::NoteTrack::trim_sustains() const
+void SightRead::NoteTrack::recompute_hopos(SightRead::Tick max_hopo_gap)
+{
+    if (m_track_type == TrackType::Drums) {
+        return;
+    }
+    for (auto i = 0U; i < m_notes.size(); ++i) {
+        auto& note = m_notes[i];
+        note.flags = with_hopo_flag(
+            note.flags,
+            is_hopo(note, i == 0U ? nullptr : &m_notes[i - 1], max_hopo_gap));
+    }
+}
+
+void SightRead::NoteTrack::apply_transforms(
+    const NoteTrackTransforms& transforms)
 {
     constexpr int DEFAULT_RESOLUTION = 192;
     constexpr int DEFAULT_SUST_CUTOFF = 64;
 
-    auto trimmed_track = *this;
-    const auto resolution = m_global_data->resolution();
+    const auto resolution = m_resolution;
     const SightRead::Tick sust_cutoff {(DEFAULT_SUST_CUTOFF * resolution)
                                        / DEFAULT_RESOLUTION};
 
-    for (auto& note : trimmed_track.m_notes) {
-        for (auto& length : note.lengths) {
-            if (length != SightRead::Tick {-1} && length <= sust_cutoff) {
-                length = SightRead::Tick {0};
+    SightRead::Tick total_ticks {0};
+    for (auto i = 0U; i < m_notes.size(); ++i) {
+        auto& note = m_notes[i];
+        if (transforms.trim_sustains) {
+            for (auto& length : note.lengths) {
+                if (length != SightRead::Tick {-1} && length <= sust_cutoff) {
+                    length = SightRead::Tick {0};
+                }
             }
+            total_ticks += sustain_ticks(note);
+        }
+        if (transforms.snap_gap.has_value() && i > 0
+            && note.position - m_notes[i - 1].position
+                <= *transforms.snap_gap) {
+            note.position = m_notes[i - 1].position;
+        }
+        if (transforms.disable_dynamics) {
+            note.disable_dynamics();
         }
     }
 
-    trimmed_track.compute_base_score_ticks();
+    if (transforms.trim_sustains) {
+        m_base_score_ticks = base_score_ticks(total_ticks, resolution);
+    }
+    if (transforms.snap_gap.has_value()) {
+        merge_same_time_notes();
+        compute_lane_counts();
+        cache_drum_solos();
+    }
+}
 
-    return trimmed_track;
+SightRead::NoteTrack SightRead::NoteTrack::trim_sustains() const&
+{
+    return NoteTrack {*this}.trim_sustains();
+}
+
+SightRead::NoteTrack SightRead::NoteTrack::trim_sustains() &&
+{
+    NoteTrackTransforms transforms;
+    transforms.trim_sustains = true;
+    apply_transforms(transforms);
+    return std::move(*this);
+}
+
+SightRead::NoteTrack
+SightRead::NoteTrack::snap_chords(SightRead::Tick snap_gap) const&
+{
+    return NoteTrack {*this}.snap_chords(snap_gap);
 }
 
 SightRead::NoteTrack
-SightRead::NoteTrack::snap_chords(SightRead::Tick snap_gap) const
+SightRead::NoteTrack::snap_chords(SightRead::Tick snap_gap) &&
 {
-    auto new_track = *this;
-    auto& new_notes = new_track.m_notes;
-    for (auto i = 1U; i < m_notes.size(); ++i) {
-        if (new_notes[i].position - new_notes[i - 1].position <= snap_gap) {
-            new_notes[i].position = new_notes[i - 1].position;
+    NoteTrackTransforms transforms;
+    transforms.snap_gap = snap_gap;
+    apply_transforms(transforms);
+    return std::move(*this);
+}
+
+SightRead::NoteTrack
+SightRead::NoteTrack::with_hopos(SightRead::Tick max_hopo_gap) const&
+{
+    return NoteTrack {*this}.with_hopos(max_hopo_gap);
+}
+
+SightRead::NoteTrack
+SightRead::NoteTrack::with_hopos(SightRead::Tick max_hopo_gap) &&
+{
+    recompute_hopos(max_hopo_gap);
+    return std::move(*this);
+}
+
+std::vector<SightRead::NoteTrack> SightRead::NoteTrack::with_hopos(
+    std::span<const SightRead::Tick> max_hopo_gaps) const
+{
+    std::vector<NoteTrack> tracks(max_hopo_gaps.size(), *this);
+    if (m_track_type == TrackType::Drums) {
+        return tracks;
+    }
+    for (auto i = 0U; i < m_notes.size(); ++i) {
+        const auto candidate
+            = hopo_candidate(m_notes[i], i == 0U ? nullptr : &m_notes[i - 1]);
+        for (auto j = 0U; j < tracks.size(); ++j) {
+            auto& note = tracks[j].m_notes[i];
+            note.flags = with_hopo_flag(note.flags,
+                                        candidate.gap <= max_hopo_gaps[j]
+                                            ? candidate.within_threshold
+                                            : candidate.beyond_threshold);
         }
     }
-    new_track.merge_same_time_notes();
-    return new_track;
+    return tracks;
+}
+
+SightRead::NoteTrack
+SightRead::NoteTrack::transform(const NoteTrackTransforms& transforms) const&
+{
+    return NoteTrack {*this}.transform(transforms);
+}
+
+SightRead::NoteTrack
+SightRead::NoteTrack::transform(const NoteTrackTransforms& transforms) &&
+{
+    apply_transforms(transforms);
+    return std::move(*this);
 }
@@ -1,7 +1,100 @@
 #include <algorithm>
+#include <cstddef>
+#include <span>
+#include <vector>
 
 #include "sightread/tempomap.hpp"
 
+namespace {
+// Converts x with the piece of table after index, moving index on to that piece
+// first. Used by the Cursor so it only needs to search forwards.
+template <typename Table>
+double advance_and_evaluate(const Table& table, std::size_t& index, double x)
+{
+    index = table.advance_piece_index(index, x);
+    return table.evaluate(index, x);
+}
+
+template <typename T, typename U, typename F>
+void convert_span(std::span<const T> input, std::span<U> output, F convert)
+{
+    if (input.size() != output.size()) {
+        throw std::invalid_argument(
+            "Input and output spans must have the same size");
+    }
+    for (auto i = 0U; i < input.size(); ++i) {
+        output[i] = convert(input[i]);
+    }
+}
+}
+
+SightRead::TempoMap::PiecewiseLinear::PiecewiseLinear(std::vector<double> xs,
+                                                      std::vector<double> ys,
+                                                      Rate lead_rate,
+                                                      Rate tail_rate)
+    : m_xs {std::move(xs)}
+    , m_ys {std::move(ys)}
+    , m_lead_rate {lead_rate}
+    , m_tail_rate {tail_rate}
+{
+    compute_spans();
+}
+
+void SightRead::TempoMap::PiecewiseLinear::compute_spans()
+{
+    m_x_spans.assign(m_xs.size(), 0.0);
+    m_y_spans.assign(m_ys.size(), 0.0);
+    for (auto i = 1U; i < m_xs.size(); ++i) {
+        m_x_spans[i] = m_xs[i] - m_xs[i - 1];
+        m_y_spans[i] = m_ys[i] - m_ys[i - 1];
+    }
+}
+
+std::size_t SightRead::TempoMap::PiecewiseLinear::piece_index(double x) const
+{
+    if (m_xs.size() <= LINEAR_SEARCH_LIMIT) {
+        std::size_t count = 0;
+        for (const auto point : m_xs) {
+            count += point < x ? 1 : 0;
+        }
+        return count;
+    }
+    const auto pos = std::lower_bound(m_xs.cbegin(), m_xs.cend(), x);
+    return static_cast<std::size_t>(pos - m_xs.cbegin());
+}
+
+std::size_t SightRead::TempoMap::PiecewiseLinear::advance_piece_index(
+    std::size_t prev_index, double x) const
+{
+    if (prev_index > 0 && !(m_xs[prev_index - 1] < x)) {
+        return piece_index(x);
+    }
+    auto index = prev_index;
+    while (index < m_xs.size() && m_xs[index] < x) {
+        ++index;
+    }
+    return index;
+}
+
+SightRead::TempoMap::PiecewiseLinear
+SightRead::TempoMap::PiecewiseLinear::inverse() const
+{
+    return {m_ys,
+            m_xs,
+            {m_lead_rate.denominator, m_lead_rate.numerator},
+            {m_tail_rate.denominator, m_tail_rate.numerator}};
+}
+
+void SightRead::TempoMap::PiecewiseLinear::scale_outputs(double scale,
+                                                         Rate tail_rate)
+{
+    for (auto& y : m_ys) {
+        y *= scale;
+    }
+    m_tail_rate = tail_rate;
+    compute_spans();
+}
+
 SightRead::TempoMap::TempoMap(std::vector<SightRead::TimeSignature> time_sigs,
                               std::vector<SightRead::BPM> bpms,
                               std::vector<SightRead::Tick> od_beats,
@@ -50,6 +143,8 @@ SightRead::TempoMap::TempoMap(std::vector<SightRead::TimeSignature> time_sigs,
     }
     m_time_sigs.push_back(prev_ts);
 
+    std::vector<double> bpm_beats;
+    std::vector<double> bpm_times;
     SightRead::Tick last_tick {0};
     auto last_bpm = DEFAULT_BPM;
     auto last_time = 0.0;
@@ -57,14 +152,21 @@ SightRead::TempoMap::TempoMap(std::vector<SightRead::TimeSignature> time_sigs,
     for (const auto& bpm : m_bpms) {
         last_time += to_beats(bpm.position - last_tick).value()
             * (MS_PER_MINUTE / static_cast<double>(last_bpm));
-        const auto beat = to_beats(bpm.position);
-        m_beat_timestamps.push_back({beat, SightRead::Second(last_time)});
+        bpm_beats.push_back(to_beats(bpm.position).value());
+        bpm_times.push_back(last_time);
         last_bpm = bpm.bpm;
         last_tick = bpm.position;
     }
 
-    m_last_bpm = last_bpm;
+    m_beats_to_seconds
+        = {std::move(bpm_beats),
+           std::move(bpm_times),
+           {MS_PER_MINUTE, static_cast<double>(DEFAULT_BPM)},
+           {MS_PER_MINUTE, static_cast<double>(last_bpm)}};
+    m_seconds_to_beats = m_beats_to_seconds.inverse();
 
+    std::vector<double> ts_measures;
+    std::vector<double> ts_beats;
     last_tick = SightRead::Tick {0};
     auto last_beat_rate = DEFAULT_BEAT_RATE;
     auto last_measure = 0.0;
@@ -72,118 +174,75 @@ SightRead::TempoMap::TempoMap(std::vector<SightRead::TimeSignature> time_sigs,
     for (const auto& ts : m_time_sigs) {
         last_measure += to_beats(ts.position - last_tick).value()
             / static_cast<double>(last_beat_rate);
-        const auto beat = to_beats(ts.position);
-        m_measure_timestamps.push_back(
-            {SightRead::Measure(last_measure), beat});
+        ts_measures.push_back(last_measure);
+        ts_beats.push_back(to_beats(ts.position).value());
         last_beat_rate = (ts.numerator * DEFAULT_BEAT_RATE) / ts.denominator;
         last_tick = ts.position;
     }
 
-    m_last_beat_rate = last_beat_rate;
+    m_measures_to_beats = {std::move(ts_measures),
+                           std::move(ts_beats),
+                           {DEFAULT_BEAT_RATE, 1.0},
+                           {last_beat_rate, 1.0}};
+    m_beats_to_measures = m_measures_to_beats.inverse();
 
+    std::vector<double> od_beat_values {0.0};
+    std::vector<double> od_beat_positions {0.0};
     if (!m_od_beats.empty()) {
+        od_beat_values.clear();
+        od_beat_positions.clear();
         for (auto i = 0U; i < m_od_beats.size(); ++i) {
-            const auto beat = to_beats(m_od_beats[i]);
-            m_od_beat_timestamps.push_back(
-                {SightRead::OdBeat(i / DEFAULT_BEAT_RATE), beat});
+            od_beat_values.push_back(i / DEFAULT_BEAT_RATE);
+            od_beat_positions.push_back(to_beats(m_od_beats[i]).value());
         }
-    } else {
-        m_od_beat_timestamps.push_back(
-            {SightRead::OdBeat(0.0), SightRead::Beat(0.0)});
     }
 
-    m_last_od_beat_rate = DEFAULT_BEAT_RATE;
+    m_od_beats_to_beats = {std::move(od_beat_values),
+                           std::move(od_beat_positions),
+                           {DEFAULT_BEAT_RATE, 1.0},
+                           {DEFAULT_BEAT_RATE, 1.0}};
+    m_beats_to_od_beats = m_od_beats_to_beats.inverse();
 }
 
 SightRead::TempoMap SightRead::TempoMap::speedup(int speed) const
 {
     constexpr auto DEFAULT_SPEED = 100;
+    constexpr double MS_PER_MINUTE = 60000.0;
 
-    SightRead::TempoMap speedup {m_time_sigs, m_bpms, m_od_beats, m_resolution};
+    // Only the BPMs and the times in seconds depend on the speed, so the
+    // conversions are rescaled instead of being rebuilt from scratch.
+    auto speedup = *this;
     for (auto& bpm : speedup.m_bpms) {
         bpm.bpm = (bpm.bpm * speed) / DEFAULT_SPEED;
     }
 
-    const auto speed_ratio = static_cast<double>(speed) / DEFAULT_SPEED;
-    for (auto& timestamp : speedup.m_beat_timestamps) {
-        timestamp.time *= speed_ratio;
-    }
-    speedup.m_last_bpm = (speedup.m_last_bpm * speed) / DEFAULT_SPEED;
+    const auto time_scale = static_cast<double>(DEFAULT_SPEED) / speed;
+    speedup.m_beats_to_seconds.scale_outputs(
+        time_scale,
+        {MS_PER_MINUTE, static_cast<double>(speedup.m_bpms.back().bpm)});
+    speedup.m_seconds_to_beats = speedup.m_beats_to_seconds.inverse();
 
     return speedup;
 }
 
 SightRead::Beat SightRead::TempoMap::to_beats(SightRead::Measure measures) const
 {
-    const auto pos = std::lower_bound(
-        m_measure_timestamps.cbegin(), m_measure_timestamps.cend(), measures,
-        [](const auto& x, const auto& y) { return x.measure < y; });
-    if (pos == m_measure_timestamps.cend()) {
-        const auto& back = m_measure_timestamps.back();
-        return back.beat + (measures - back.measure).to_beat(m_last_beat_rate);
-    }
-    if (pos == m_measure_timestamps.cbegin()) {
-        return pos->beat - (pos->measure - measures).to_beat(DEFAULT_BEAT_RATE);
-    }
-    const auto prev = pos - 1;
-    return prev->beat
-        + (pos->beat - prev->beat)
-        * ((measures - prev->measure) / (pos->measure - prev->measure));
+    return SightRead::Beat {m_measures_to_beats(measures.value())};
 }
 
 SightRead::Beat SightRead::TempoMap::to_beats(SightRead::OdBeat od_beats) const
 {
-    const auto pos = std::lower_bound(
-        m_od_beat_timestamps.cbegin(), m_od_beat_timestamps.cend(), od_beats,
-        [](const auto& x, const auto& y) { return x.od_beat < y; });
-    if (pos == m_od_beat_timestamps.cend()) {
-        const auto& back = m_od_beat_timestamps.back();
-        return back.beat
-            + (od_beats - back.od_beat).to_beat(m_last_od_beat_rate);
-    }
-    if (pos == m_od_beat_timestamps.cbegin()) {
-        return pos->beat - (pos->od_beat - od_beats).to_beat(DEFAULT_BEAT_RATE);
-    }
-    const auto prev = pos - 1;
-    return prev->beat
-        + (pos->beat - prev->beat)
-        * ((od_beats - prev->od_beat) / (pos->od_beat - prev->od_beat));
+    return SightRead::Beat {m_od_beats_to_beats(od_beats.value())};
 }
 
 SightRead::Beat SightRead::TempoMap::to_beats(SightRead::Second seconds) const
 {
-    const auto pos = std::lower_bound(
-        m_beat_timestamps.cbegin(), m_beat_timestamps.cend(), seconds,
-        [](const auto& x, const auto& y) { return x.time < y; });
-    if (pos == m_beat_timestamps.cend()) {
-        const auto& back = m_beat_timestamps.back();
-        return back.beat + (seconds - back.time).to_beat(m_last_bpm);
-    }
-    if (pos == m_beat_timestamps.cbegin()) {
-        return pos->beat - (pos->time - seconds).to_beat(DEFAULT_BPM);
-    }
-    const auto prev = pos - 1;
-    return prev->beat
-        + (pos->beat - prev->beat)
-        * ((seconds - prev->time) / (pos->time - prev->time));
+    return SightRead::Beat {m_seconds_to_beats(seconds.value())};
 }
 
 SightRead::Measure SightRead::TempoMap::to_measures(SightRead::Beat beats) const
 {
-    const auto pos = std::lower_bound(
-        m_measure_timestamps.cbegin(), m_measure_timestamps.cend(), beats,
-        [](const auto& x, const auto& y) { return x.beat < y; });
-    if (pos == m_measure_timestamps.cend()) {
-        const auto& back = m_measure_timestamps.back();
-        return back.measure + (beats - back.beat).to_measure(m_last_beat_rate);
-    }
-    if (pos == m_measure_timestamps.cbegin()) {
-        return pos->measure - (pos->beat - beats).to_measure(DEFAULT_BEAT_RATE);
-    }
-    const auto prev = pos - 1;
-    return prev->measure
-        + (pos->measure - prev->measure)
-        * ((beats - prev->beat) / (pos->beat - prev->beat));
+    return SightRead::Measure {m_beats_to_measures(beats.value())};
 }
 
 SightRead::Measure
@@ -194,42 +253,12 @@ SightRead::TempoMap::to_measures(SightRead::Second seconds) const
 
 SightRead::OdBeat SightRead::TempoMap::to_od_beats(SightRead::Beat beats) const
 {
-    const auto pos = std::lower_bound(
-        m_od_beat_timestamps.cbegin(), m_od_beat_timestamps.cend(), beats,
-        [](const auto& x, const auto& y) { return x.beat < y; });
-    if (pos == m_od_beat_timestamps.cend()) {
-        const auto& back = m_od_beat_timestamps.back();
-        return back.od_beat
-            + SightRead::OdBeat(
-                   (beats - back.beat).to_measure(m_last_od_beat_rate).value());
-    }
-    if (pos == m_od_beat_timestamps.cbegin()) {
-        return pos->od_beat
-            - SightRead::OdBeat(
-                   (pos->beat - beats).to_measure(DEFAULT_BEAT_RATE).value());
-    }
-    const auto prev = pos - 1;
-    return prev->od_beat
-        + (pos->od_beat - prev->od_beat)
-        * ((beats - prev->beat) / (pos->beat - prev->beat));
+    return SightRead::OdBeat {m_beats_to_od_beats(beats.value())};
 }
 
 SightRead::Second SightRead::TempoMap::to_seconds(SightRead::Beat beats) const
 {
-    const auto pos = std::lower_bound(
-        m_beat_timestamps.cbegin(), m_beat_timestamps.cend(), beats,
-        [](const auto& x, const auto& y) { return x.beat < y; });
-    if (pos == m_beat_timestamps.cend()) {
-        const auto& back = m_beat_timestamps.back();
-        return back.time + (beats - back.beat).to_second(m_last_bpm);
-    }
-    if (pos == m_beat_timestamps.cbegin()) {
-        return pos->time - (pos->beat - beats).to_second(DEFAULT_BPM);
-    }
-    const auto prev = pos - 1;
-    return prev->time
-        + (pos->time - prev->time)
-        * ((beats - prev->beat) / (pos->beat - prev->beat));
+    return SightRead::Second {m_beats_to_seconds(beats.value())};
 }
 
 SightRead::Second
@@ -247,3 +276,93 @@ SightRead::Tick SightRead::TempoMap::to_ticks(SightRead::Second seconds) const
 {
     return to_ticks(to_beats(seconds));
 }
+
+SightRead::Beat
+SightRead::TempoMap::Cursor::to_beats(SightRead::Measure measures)
+{
+    return SightRead::Beat {advance_and_evaluate(
+        m_tempo_map->m_measures_to_beats, m_beat_index, measures.value())};
+}
+
+SightRead::Beat SightRead::TempoMap::Cursor::to_beats(SightRead::Second seconds)
+{
+    return SightRead::Beat {advance_and_evaluate(
+        m_tempo_map->m_seconds_to_beats, m_time_index, seconds.value())};
+}
+
+SightRead::Measure
+SightRead::TempoMap::Cursor::to_measures(SightRead::Beat beats)
+{
+    return SightRead::Measure {advance_and_evaluate(
+        m_tempo_map->m_beats_to_measures, m_measure_index, beats.value())};
+}
+
+SightRead::OdBeat
+SightRead::TempoMap::Cursor::to_od_beats(SightRead::Beat beats)
+{
+    return SightRead::OdBeat {advance_and_evaluate(
+        m_tempo_map->m_beats_to_od_beats, m_od_beat_index, beats.value())};
+}
+
+SightRead::Second SightRead::TempoMap::Cursor::to_seconds(SightRead::Beat beats)
+{
+    return SightRead::Second {advance_and_evaluate(
+        m_tempo_map->m_beats_to_seconds, m_seconds_index, beats.value())};
+}
+
+SightRead::Second
+SightRead::TempoMap::Cursor::to_seconds(SightRead::Measure measures)
+{
+    return to_seconds(to_beats(measures));
+}
+
+SightRead::Second SightRead::TempoMap::Cursor::to_seconds(SightRead::Tick ticks)
+{
+    return to_seconds(m_tempo_map->to_beats(ticks));
+}
+
+SightRead::Tick SightRead::TempoMap::Cursor::to_ticks(SightRead::Second seconds)
+{
+    return m_tempo_map->to_ticks(to_beats(seconds));
+}
+
+void SightRead::TempoMap::to_beats(std::span<const SightRead::Second> input,
+                                   std::span<SightRead::Beat> output) const
+{
+    auto tempo_cursor = cursor();
+    convert_span(input, output,
+                 [&](auto seconds) { return tempo_cursor.to_beats(seconds); });
+}
+
+void SightRead::TempoMap::to_measures(
+    std::span<const SightRead::Beat> input,
+    std::span<SightRead::Measure> output) const
+{
+    auto tempo_cursor = cursor();
+    convert_span(input, output,
+                 [&](auto beats) { return tempo_cursor.to_measures(beats); });
+}
+
+void SightRead::TempoMap::to_od_beats(std::span<const SightRead::Beat> input,
+                                      std::span<SightRead::OdBeat> output) const
+{
+    auto tempo_cursor = cursor();
+    convert_span(input, output,
+                 [&](auto beats) { return tempo_cursor.to_od_beats(beats); });
+}
+
+void SightRead::TempoMap::to_seconds(std::span<const SightRead::Beat> input,
+                                     std::span<SightRead::Second> output) const
+{
+    auto tempo_cursor = cursor();
+    convert_span(input, output,
+                 [&](auto beats) { return tempo_cursor.to_seconds(beats); });
+}
+
+void SightRead::TempoMap::to_seconds(std::span<const SightRead::Tick> input,
+                                     std::span<SightRead::Second> output) const
+{
+    auto tempo_cursor = cursor();
+    convert_span(input, output,
+                 [&](auto ticks) { return tempo_cursor.to_seconds(ticks); });
+}
@@ -0,0 +1,92 @@
+#include <cstdint>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "sightread/batchparser.hpp"
+#include "sightread/chartparser.hpp"
+#include "testhelpers.hpp"
+
+namespace {
+std::span<const std::uint8_t> as_bytes(std::string_view text)
+{
+    return {reinterpret_cast<const std::uint8_t*>(text.data()), // NOLINT
+            text.size()};
+}
+}
+
+BOOST_AUTO_TEST_CASE(batch_results_are_in_job_order)
+{
+    const std::string_view first_chart = "[ExpertSingle]\n{\n768 = N 0 0\n}";
+    const std::string_view second_chart
+        = "[ExpertSingle]\n{\n768 = N 0 0\n864 = N 1 0\n}";
+    const std::vector<SightRead::ParseJob> jobs {
+        {as_bytes(first_chart), SightRead::FileFormat::Chart, {}},
+        {as_bytes(second_chart), SightRead::FileFormat::Chart, {}}};
+
+    const auto results = SightRead::BatchParser().threads(2).parse(jobs);
+
+    BOOST_REQUIRE_EQUAL(results.size(), 2);
+    const auto& first_song = std::get<SightRead::Song>(results[0]);
+    const auto& second_song = std::get<SightRead::Song>(results[1]);
+    BOOST_CHECK_EQUAL(first_song
+                          .track(SightRead::Instrument::Guitar,
+                                 SightRead::Difficulty::Expert)
+                          .notes()
+                          .size(),
+                      1);
+    BOOST_CHECK_EQUAL(second_song
+                          .track(SightRead::Instrument::Guitar,
+                                 SightRead::Difficulty::Expert)
+                          .notes()
+                          .size(),
+                      2);
+}
+
+BOOST_AUTO_TEST_CASE(batch_results_match_single_file_parsing)
+{
+    const std::string_view chart = "[ExpertSingle]\n{\n768 = N 0 0\n"
+                                   "800 = N 1 0\n}";
+    const SightRead::HopoThreshold threshold {
+        SightRead::HopoThresholdType::HopoFrequency, SightRead::Tick {10}};
+    const std::vector<SightRead::ParseJob> jobs {
+        {as_bytes(chart), SightRead::FileFormat::Chart, {"Name", "", ""},
+         threshold}};
+
+    const auto results = SightRead::BatchParser().parse(jobs);
+    const auto expected_song = SightRead::ChartParser({"Name", "", ""})
+                                   .hopo_threshold(threshold)
+                                   .parse(chart);
+
+    const auto& song = std::get<SightRead::Song>(results.at(0));
+    const auto& notes
+        = song.track(SightRead::Instrument::Guitar,
+                     SightRead::Difficulty::Expert)
+              .notes();
+    const auto& expected_notes
+        = expected_song
+              .track(SightRead::Instrument::Guitar,
+                     SightRead::Difficulty::Expert)
+              .notes();
+    BOOST_CHECK_EQUAL(song.global_data().name(), "Name");
+    BOOST_CHECK_EQUAL_COLLECTIONS(notes.cbegin(), notes.cend(),
+                                  expected_notes.cbegin(),
+                                  expected_notes.cend());
+}
+
+BOOST_AUTO_TEST_CASE(parse_errors_are_returned_per_job)
+{
+    const std::string_view good_chart = "[ExpertSingle]\n{\n768 = N 0 0\n}";
+    const std::vector<std::uint8_t> bad_midi {0x4D, 0x54, 0x68, 0x64};
+    const std::vector<SightRead::ParseJob> jobs {
+        {bad_midi, SightRead::FileFormat::Midi, {}},
+        {as_bytes(good_chart), SightRead::FileFormat::Chart, {}}};
+
+    const auto results = SightRead::BatchParser().threads(2).parse(jobs);
+
+    BOOST_REQUIRE_EQUAL(results.size(), 2);
+    BOOST_TEST(std::holds_alternative<SightRead::ParseError>(results[0]));
+    BOOST_TEST(std::holds_alternative<SightRead::Song>(results[1]));
+}
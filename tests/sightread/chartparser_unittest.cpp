@@ -1,7 +1,13 @@
+#include <cstddef>
+#include <memory_resource>
+#include <tuple>
+#include <variant>
+
 #include <boost/test/unit_test.hpp>
 
 #include "sightread/chartparser.hpp"
 #include "sightread/detail/chart.hpp"
+#include "sightread/detail/chartconverter.hpp"
 #include "testhelpers.hpp"
 
 namespace {
@@ -137,6 +143,25 @@ BOOST_AUTO_TEST_CASE(bad_values_are_ignored)
     BOOST_CHECK_EQUAL(resolution, 192);
 }
 
+BOOST_AUTO_TEST_CASE(values_are_read_as_by_stoi)
+{
+    const auto guitar_track = section_string("ExpertSingle", {{768, 0, 0}});
+
+    for (const auto& [value, expected] :
+         std::vector<std::tuple<std::string, int>> {{" +480", 480},
+                                                    {"480ticks", 480},
+                                                    {"+-480", 192},
+                                                    {"99999999999", 192}}) {
+        const auto chart_file
+            = header_string({{"Resolution", value}}) + '\n' + guitar_track;
+
+        const auto global_data
+            = SightRead::ChartParser({}).parse(chart_file).global_data();
+
+        BOOST_CHECK_EQUAL(global_data.resolution(), expected);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE(practice_mode_sections_are_read)
@@ -292,7 +317,7 @@ BOOST_AUTO_TEST_CASE(easy_note_track_read_correctly)
     const auto& track = song.track(SightRead::Instrument::Guitar,
                                    SightRead::Difficulty::Easy);
 
-    BOOST_CHECK_EQUAL(track.global_data().resolution(), 192);
+    BOOST_CHECK_EQUAL(track.resolution(), 192);
     BOOST_CHECK_EQUAL_COLLECTIONS(track.notes().cbegin(), track.notes().cend(),
                                   notes.cbegin(), notes.cend());
     BOOST_CHECK_EQUAL_COLLECTIONS(track.sp_phrases().cbegin(),
@@ -316,6 +341,22 @@ BOOST_AUTO_TEST_CASE(invalid_note_values_are_ignored)
                                   notes.cbegin(), notes.cend());
 }
 
+BOOST_AUTO_TEST_CASE(out_of_range_note_values_are_ignored)
+{
+    const auto chart_file = section_string(
+        "ExpertSingle", {{768, 0, 0}, {768, 1000, 0}, {768, -1, 0}});
+    std::vector<SightRead::Note> notes {
+        make_note(768, 0, SightRead::FIVE_FRET_GREEN)};
+
+    const auto song = SightRead::ChartParser({}).parse(chart_file);
+    const auto& parsed_notes = song.track(SightRead::Instrument::Guitar,
+                                          SightRead::Difficulty::Expert)
+                                   .notes();
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(parsed_notes.cbegin(), parsed_notes.cend(),
+                                  notes.cbegin(), notes.cend());
+}
+
 BOOST_AUTO_TEST_CASE(non_sp_phrase_special_events_are_ignored)
 {
     const auto chart_file
@@ -658,6 +699,28 @@ BOOST_AUTO_TEST_CASE(drum_notes_are_read_correctly_from_chart)
                                   notes.cbegin(), notes.cend());
 }
 
+BOOST_AUTO_TEST_CASE(cymbal_markers_out_of_order_are_matched_to_their_notes)
+{
+    const auto chart_file = section_string("ExpertDrums",
+                                           {{384, 66, 0},
+                                            {192, 2, 0},
+                                            {192, 3, 0},
+                                            {384, 2, 0},
+                                            {192, 67, 0},
+                                            {576, 68, 0}});
+    std::vector<SightRead::Note> notes {
+        make_drum_note(192, SightRead::DRUM_YELLOW),
+        make_drum_note(192, SightRead::DRUM_BLUE, SightRead::FLAGS_CYMBAL),
+        make_drum_note(384, SightRead::DRUM_YELLOW, SightRead::FLAGS_CYMBAL)};
+
+    const auto song = SightRead::ChartParser({}).parse(chart_file);
+    const auto& track = song.track(SightRead::Instrument::Drums,
+                                   SightRead::Difficulty::Expert);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(track.notes().cbegin(), track.notes().cend(),
+                                  notes.cbegin(), notes.cend());
+}
+
 BOOST_AUTO_TEST_CASE(dynamics_are_read_correctly_from_chart)
 {
     const auto chart_file = section_string(
@@ -941,6 +1004,68 @@ BOOST_AUTO_TEST_CASE(custom_hopo_threshold_is_handled_correctly)
                           | SightRead::FLAGS_FIVE_FRET_GUITAR);
 }
 
+BOOST_AUTO_TEST_CASE(rederived_hopos_match_reparsing)
+{
+    const auto chart_file = section_string(
+        "ExpertSingle",
+        {{0, 0, 0}, {65, 1, 0}, {131, 2, 0}, {131, 5, 0}, {200, 3, 0},
+         {260, 4, 0}, {260, 6, 0}, {300, 0, 0}});
+    const SightRead::HopoThreshold threshold {
+        SightRead::HopoThresholdType::HopoFrequency, SightRead::Tick {96}};
+
+    const auto song = SightRead::ChartParser({}).parse(chart_file);
+    const auto reparsed_song
+        = SightRead::ChartParser({}).hopo_threshold(threshold).parse(
+            chart_file);
+    const auto rederived_song = song.with_hopo_threshold(threshold);
+    const auto& reparsed_notes
+        = reparsed_song
+              .track(SightRead::Instrument::Guitar,
+                     SightRead::Difficulty::Expert)
+              .notes();
+    const auto& rederived_notes
+        = rederived_song
+              .track(SightRead::Instrument::Guitar,
+                     SightRead::Difficulty::Expert)
+              .notes();
+
+    BOOST_REQUIRE_EQUAL(rederived_notes.size(), reparsed_notes.size());
+    for (auto i = 0U; i < reparsed_notes.size(); ++i) {
+        BOOST_CHECK_EQUAL(rederived_notes[i].flags, reparsed_notes[i].flags);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(several_hopo_thresholds_can_be_rederived_at_once)
+{
+    const auto chart_file
+        = section_string("ExpertSingle", {{0, 0, 0}, {65, 1, 0}, {131, 2, 0}});
+    const std::vector<SightRead::HopoThreshold> thresholds {
+        {SightRead::HopoThresholdType::HopoFrequency, SightRead::Tick {96}},
+        {SightRead::HopoThresholdType::HopoFrequency, SightRead::Tick {10}}};
+
+    const auto song
+        = SightRead::ChartParser({})
+              .hopo_threshold({SightRead::HopoThresholdType::EighthNote,
+                               SightRead::Tick {0}})
+              .parse(chart_file);
+    const auto songs = song.with_hopo_thresholds(thresholds);
+    const auto& long_notes = songs[0]
+                                 .track(SightRead::Instrument::Guitar,
+                                        SightRead::Difficulty::Expert)
+                                 .notes();
+    const auto& short_notes = songs[1]
+                                  .track(SightRead::Instrument::Guitar,
+                                         SightRead::Difficulty::Expert)
+                                  .notes();
+
+    BOOST_REQUIRE_EQUAL(songs.size(), 2U);
+    BOOST_CHECK_EQUAL(long_notes[2].flags,
+                      SightRead::FLAGS_HOPO
+                          | SightRead::FLAGS_FIVE_FRET_GUITAR);
+    BOOST_CHECK_EQUAL(short_notes[1].flags, SightRead::FLAGS_FIVE_FRET_GUITAR);
+    BOOST_CHECK_EQUAL(short_notes[2].flags, SightRead::FLAGS_FIVE_FRET_GUITAR);
+}
+
 BOOST_AUTO_TEST_CASE(not_done_on_drums)
 {
     const auto chart_file = section_string(
@@ -957,3 +1082,305 @@ BOOST_AUTO_TEST_CASE(not_done_on_drums)
 }
 
 BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(multithreaded_chart_parsing)
+
+BOOST_AUTO_TEST_CASE(multithreaded_parsing_matches_serial_parsing)
+{
+    const auto guitar_track
+        = section_string("ExpertSingle", {{768, 0, 0}, {832, 1, 0}});
+    const auto header = header_string({{"Resolution", "480"}});
+    const auto bass_track
+        = section_string("ExpertDoubleBass", {{768, 0, 0}, {832, 1, 100}});
+    const auto drum_track
+        = section_string("HardDrums", {{768, 0, 0}, {960, 1, 0}});
+    const auto chart_file = guitar_track + '\n' + header + '\n' + bass_track
+        + '\n' + drum_track;
+
+    const auto serial_song = SightRead::ChartParser({}).parse(chart_file);
+    const auto parallel_song
+        = SightRead::ChartParser({}).threads(4).parse(chart_file);
+    const auto serial_instruments = serial_song.instruments();
+    const auto parallel_instruments = parallel_song.instruments();
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        parallel_instruments.cbegin(), parallel_instruments.cend(),
+        serial_instruments.cbegin(), serial_instruments.cend());
+    for (auto instrument : serial_instruments) {
+        for (auto difficulty : serial_song.difficulties(instrument)) {
+            const auto& serial_track
+                = serial_song.track(instrument, difficulty);
+            const auto& parallel_track
+                = parallel_song.track(instrument, difficulty);
+            BOOST_CHECK_EQUAL_COLLECTIONS(parallel_track.notes().cbegin(),
+                                          parallel_track.notes().cend(),
+                                          serial_track.notes().cbegin(),
+                                          serial_track.notes().cend());
+            BOOST_CHECK_EQUAL(parallel_track.base_score(),
+                              serial_track.base_score());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(chart_probing)
+
+BOOST_AUTO_TEST_CASE(probe_summarises_tracks_and_length)
+{
+    const auto chart_file = header_string({{"Resolution", "192"}}) + '\n'
+        + section_string("ExpertSingle",
+                         {{768, 0, 0}, {768, 1, 0}, {960, 0, 192}, {960, 5, 0}})
+        + '\n' + section_string("EasySingle", {{0, 0, 0}});
+
+    const auto summary = SightRead::ChartParser({}).probe(chart_file);
+
+    BOOST_CHECK_EQUAL(summary.resolution, 192);
+    BOOST_REQUIRE_EQUAL(summary.tracks.size(), 2);
+    BOOST_CHECK_EQUAL(summary.tracks[0].instrument,
+                      SightRead::Instrument::Guitar);
+    BOOST_CHECK(summary.tracks[0].difficulty == SightRead::Difficulty::Easy);
+    BOOST_CHECK_EQUAL(summary.tracks[0].note_count, 1);
+    BOOST_CHECK(summary.tracks[1].difficulty == SightRead::Difficulty::Expert);
+    BOOST_CHECK_EQUAL(summary.tracks[1].note_count, 3);
+    BOOST_CHECK_EQUAL(summary.length, SightRead::Tick {1152});
+    BOOST_CHECK_CLOSE(summary.length_seconds.value(), 3.0, 0.0001);
+}
+
+BOOST_AUTO_TEST_CASE(probe_respects_permitted_instruments)
+{
+    const auto chart_file = section_string("ExpertSingle", {{768, 0, 0}})
+        + '\n' + section_string("ExpertDrums", {{768, 1, 0}, {768, 66, 0}});
+
+    const auto summary = SightRead::ChartParser({})
+                             .permit_instruments({SightRead::Instrument::Drums})
+                             .probe(chart_file);
+
+    BOOST_REQUIRE_EQUAL(summary.tracks.size(), 1);
+    BOOST_CHECK_EQUAL(summary.tracks[0].instrument,
+                      SightRead::Instrument::Drums);
+    BOOST_CHECK_EQUAL(summary.tracks[0].note_count, 1);
+}
+
+BOOST_AUTO_TEST_CASE(probe_throws_on_charts_without_notes)
+{
+    const auto chart_file = header_string({{"Resolution", "192"}});
+
+    BOOST_CHECK_THROW(
+        [&] { return SightRead::ChartParser({}).probe(chart_file); }(),
+        SightRead::ParseError);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(chart_parse_stats)
+
+BOOST_AUTO_TEST_CASE(parse_stats_are_filled_in)
+{
+    const auto chart_file = header_string({{"Resolution", "192"}}) + '\n'
+        + section_string("ExpertSingle", {{768, 0, 0}, {768, 1, 0}}) + '\n'
+        + section_string("HardDrums", {{768, 0, 0}});
+    SightRead::ParseStats stats;
+
+    const auto song
+        = SightRead::ChartParser({}).threads(2).parse(chart_file, stats);
+
+    BOOST_CHECK_EQUAL(stats.input_bytes, chart_file.size());
+    BOOST_CHECK_EQUAL(stats.event_count, 4);
+    BOOST_REQUIRE_EQUAL(stats.tracks.size(), 2);
+    BOOST_CHECK_EQUAL(stats.tracks[0].instrument,
+                      SightRead::Instrument::Guitar);
+    BOOST_CHECK(stats.tracks[0].difficulty == SightRead::Difficulty::Expert);
+    BOOST_CHECK_EQUAL(stats.tracks[0].event_count, 2);
+    BOOST_CHECK_EQUAL(stats.tracks[1].instrument,
+                      SightRead::Instrument::Drums);
+    BOOST_CHECK(stats.tracks[1].difficulty == SightRead::Difficulty::Hard);
+    BOOST_CHECK_EQUAL(stats.tracks[1].event_count, 1);
+    for (const auto& track : stats.tracks) {
+        BOOST_CHECK(track.note_track.time <= track.conversion.time);
+        BOOST_CHECK(track.conversion.time <= stats.total.time);
+    }
+    BOOST_CHECK(stats.tokenize.time <= stats.total.time);
+    BOOST_CHECK_EQUAL(stats.total.allocations, 0);
+}
+
+BOOST_AUTO_TEST_CASE(allocation_counter_is_used_if_set)
+{
+    const auto chart_file = section_string("ExpertSingle", {{768, 0, 0}});
+    static std::size_t counter_calls = 0;
+    counter_calls = 0;
+    SightRead::ParseStats stats;
+    stats.allocation_counter = [] { return counter_calls++; };
+
+    const auto song = SightRead::ChartParser({}).parse(chart_file, stats);
+
+    // Each phase calls the counter once at its start and once at its end.
+    BOOST_CHECK_GT(counter_calls, 0);
+    BOOST_CHECK_EQUAL(counter_calls % 2, 0);
+    BOOST_CHECK_EQUAL(stats.total.allocations, counter_calls - 1);
+    BOOST_CHECK_EQUAL(stats.tokenize.allocations, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(chart_memory_resources)
+
+class CountingResource : public std::pmr::memory_resource {
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes,
+                       std::size_t alignment) override
+    {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    [[nodiscard]] bool
+    do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+public:
+    std::size_t allocations {0};
+};
+
+BOOST_AUTO_TEST_CASE(intermediate_chart_uses_the_given_resource)
+{
+    const auto chart_file = header_string({{"Resolution", "192"}}) + '\n'
+        + section_string("ExpertSingle", {{768, 0, 0}, {960, 1, 0}});
+    CountingResource resource;
+
+    const auto song
+        = SightRead::ChartParser({}).memory_resource(&resource).parse(
+            chart_file);
+
+    BOOST_CHECK_GT(resource.allocations, 0);
+    BOOST_CHECK_EQUAL(
+        song.track(SightRead::Instrument::Guitar, SightRead::Difficulty::Expert)
+            .notes()
+            .size(),
+        2);
+}
+
+BOOST_AUTO_TEST_CASE(conversion_scratch_uses_the_chart_resource)
+{
+    const auto chart_file = section_string(
+        "ExpertDrums", {{768, 2, 0}, {768, 66, 0}, {960, 1, 0}, {960, 34, 0}},
+        {}, {{700, "solo"}, {1000, "soloend"}});
+    CountingResource resource;
+    const auto chart = SightRead::Detail::parse_chart(chart_file, &resource);
+    resource.allocations = 0;
+
+    const auto song = SightRead::Detail::ChartConverter({}).convert(chart);
+    const auto& notes = song.track(SightRead::Instrument::Drums,
+                                   SightRead::Difficulty::Expert)
+                            .notes();
+
+    BOOST_CHECK_GT(resource.allocations, 0);
+    BOOST_REQUIRE_EQUAL(notes.size(), 2);
+    BOOST_CHECK_EQUAL(notes[0].flags,
+                      SightRead::FLAGS_CYMBAL | SightRead::FLAGS_DRUMS);
+    BOOST_CHECK_EQUAL(notes[1].flags,
+                      SightRead::FLAGS_ACCENT | SightRead::FLAGS_DRUMS);
+}
+
+BOOST_AUTO_TEST_CASE(unsynchronised_resources_can_be_used_with_threads)
+{
+    std::string chart_file;
+    for (const auto* name :
+         {"EasyDrums", "MediumDrums", "HardDrums", "ExpertDrums",
+          "ExpertSingle", "ExpertDoubleBass"}) {
+        chart_file += section_string(
+            name, {{768, 2, 0}, {768, 66, 0}, {960, 1, 0}, {960, 34, 0}},
+            {}, {{700, "solo"}, {1000, "soloend"}});
+        chart_file += '\n';
+    }
+    std::pmr::monotonic_buffer_resource resource;
+
+    const auto song = SightRead::ChartParser({})
+                          .memory_resource(&resource)
+                          .threads(4)
+                          .parse(chart_file);
+    const auto expected_song = SightRead::ChartParser({}).parse(chart_file);
+
+    for (const auto instrument : expected_song.instruments()) {
+        for (const auto difficulty : expected_song.difficulties(instrument)) {
+            const auto& notes = song.track(instrument, difficulty).notes();
+            const auto& expected_notes
+                = expected_song.track(instrument, difficulty).notes();
+            BOOST_REQUIRE_EQUAL(notes.size(), expected_notes.size());
+            for (auto i = 0U; i < notes.size(); ++i) {
+                BOOST_CHECK_EQUAL(notes[i].flags, expected_notes[i].flags);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(chart_text_encodings)
+
+BOOST_AUTO_TEST_CASE(utf16_charts_are_parsed_like_utf8_ones)
+{
+    const auto utf8_file = header_string({{"Resolution", "480"}}) + '\n'
+        + section_string("ExpertSingle", {{768, 0, 0}, {960, 1, 0}});
+    std::string utf16_file {"\xFF\xFE"};
+    for (const auto c : utf8_file) {
+        utf16_file.push_back(c);
+        utf16_file.push_back('\0');
+    }
+
+    const auto song = SightRead::ChartParser({}).parse(utf16_file);
+
+    BOOST_CHECK_EQUAL(song.global_data().resolution(), 480);
+    BOOST_CHECK_EQUAL(
+        song.track(SightRead::Instrument::Guitar, SightRead::Difficulty::Expert)
+            .notes()
+            .size(),
+        2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(chart_try_parse)
+
+BOOST_AUTO_TEST_CASE(valid_charts_give_a_song)
+{
+    const auto chart_file = section_string("ExpertSingle", {{768, 0, 0}});
+
+    const auto result = SightRead::ChartParser({}).try_parse(chart_file);
+
+    BOOST_REQUIRE(std::holds_alternative<SightRead::Song>(result));
+    BOOST_CHECK(std::get<SightRead::Song>(result).has_instrument(
+        SightRead::Instrument::Guitar));
+}
+
+BOOST_AUTO_TEST_CASE(malformed_charts_give_the_error_and_its_offset)
+{
+    const std::string chart_file = "[ExpertSingle]\n{\n  768 = N 0 0\n"
+                                   "  960 = N 1\n}";
+
+    const auto result = SightRead::ChartParser({}).try_parse(chart_file);
+
+    BOOST_REQUIRE(std::holds_alternative<SightRead::ParseError>(result));
+    const auto& error = std::get<SightRead::ParseError>(result);
+    BOOST_CHECK(error.code() == SightRead::ParseErrorCode::MalformedData);
+    BOOST_CHECK_EQUAL(error.offset().value_or(0), chart_file.find("960"));
+}
+
+BOOST_AUTO_TEST_CASE(charts_without_notes_have_their_own_code)
+{
+    const auto result
+        = SightRead::ChartParser({}).try_parse(header_string({}));
+
+    BOOST_REQUIRE(std::holds_alternative<SightRead::ParseError>(result));
+    BOOST_CHECK(std::get<SightRead::ParseError>(result).code()
+                == SightRead::ParseErrorCode::NoNotes);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,130 @@
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "sightread/chartstreamparser.hpp"
+#include "sightread/tempomap.hpp"
+
+namespace {
+// Records every callback as a line of text, so runs can be compared.
+class RecordingChartVisitor : public SightRead::ChartVisitor {
+public:
+    std::vector<std::string> calls;
+    std::string skipped_section;
+
+    bool section_start(std::string_view name) override
+    {
+        if (name == skipped_section) {
+            return false;
+        }
+        calls.push_back("start " + std::string(name));
+        return true;
+    }
+
+    void section_end() override { calls.emplace_back("end"); }
+
+    void key_value(std::string_view key, std::string_view value) override
+    {
+        calls.push_back(std::string(key) + '=' + std::string(value));
+    }
+
+    void note(const SightRead::NoteEvent& event) override
+    {
+        calls.push_back("N " + std::to_string(event.position) + ' '
+                        + std::to_string(event.fret));
+    }
+
+    void event(const SightRead::Event& event) override
+    {
+        calls.push_back("E " + std::to_string(event.position) + ' '
+                        + std::string(event.data));
+    }
+};
+}
+
+BOOST_AUTO_TEST_SUITE(chart_stream_parser)
+
+BOOST_AUTO_TEST_CASE(chunk_boundaries_do_not_change_the_events)
+{
+    const std::string text
+        = "[Song]\r\n{\r\n  Name = Test\r\n}\r\n\r\n[ExpertSingle]\n"
+          "{\n768 = N 0 0\n768 = E solo\n}";
+    RecordingChartVisitor whole_visitor;
+    SightRead::ChartStreamParser whole_parser {whole_visitor};
+    whole_parser.finish(text);
+
+    for (auto chunk_size = 1U; chunk_size <= text.size(); ++chunk_size) {
+        RecordingChartVisitor visitor;
+        SightRead::ChartStreamParser parser {visitor};
+        for (auto i = 0U; i < text.size(); i += chunk_size) {
+            parser.feed(std::string_view {text}.substr(i, chunk_size));
+        }
+        parser.finish();
+
+        BOOST_CHECK_EQUAL_COLLECTIONS(visitor.calls.cbegin(),
+                                      visitor.calls.cend(),
+                                      whole_visitor.calls.cbegin(),
+                                      whole_visitor.calls.cend());
+    }
+    BOOST_CHECK_EQUAL(whole_visitor.calls.size(), 7);
+}
+
+BOOST_AUTO_TEST_CASE(visitor_can_skip_section_bodies)
+{
+    const std::string text = "[ExpertDrums]\n{\n768 = N\n}\n[ExpertSingle]\n"
+                             "{\n768 = N 0 0\n}";
+    const std::vector<std::string> expected_calls {"start ExpertSingle",
+                                                   "N 768 0", "end"};
+    RecordingChartVisitor visitor;
+    visitor.skipped_section = "ExpertDrums";
+    SightRead::ChartStreamParser parser {visitor};
+
+    parser.feed(text);
+    parser.finish();
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(visitor.calls.cbegin(), visitor.calls.cend(),
+                                  expected_calls.cbegin(),
+                                  expected_calls.cend());
+}
+
+BOOST_AUTO_TEST_CASE(finishing_inside_a_section_throws)
+{
+    RecordingChartVisitor visitor;
+    SightRead::ChartStreamParser parser {visitor};
+
+    parser.feed("[Song]\n{\nName = Test\n");
+
+    BOOST_CHECK_THROW(parser.finish(), SightRead::ParseError);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(chart_error_offsets)
+
+BOOST_AUTO_TEST_CASE(errors_give_the_offset_of_their_line_across_chunks)
+{
+    const std::string text = "[Song]\r\n{\r\n}\r\n  [ExpertSingle]\n"
+                             "{\n768 = N 0 0\n  960 = N\n}";
+    const auto bad_line_offset = text.find("960");
+
+    for (auto chunk_size = 1U; chunk_size <= text.size(); ++chunk_size) {
+        RecordingChartVisitor visitor;
+        SightRead::ChartStreamParser parser {visitor};
+        std::optional<std::size_t> offset;
+        try {
+            for (auto i = 0U; i < text.size(); i += chunk_size) {
+                parser.feed(std::string_view {text}.substr(i, chunk_size));
+            }
+            parser.finish();
+        } catch (const SightRead::ParseError& error) {
+            offset = error.offset();
+        }
+
+        BOOST_CHECK_EQUAL(offset.value_or(0), bad_line_offset);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
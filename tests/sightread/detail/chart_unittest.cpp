@@ -1,3 +1,5 @@
+#include <memory_resource>
+#include <optional>
 #include <tuple>
 
 #include <boost/test/unit_test.hpp>
@@ -5,7 +7,7 @@
 #include "sightread/detail/chart.hpp"
 #include "sightread/tempomap.hpp"
 
-namespace SightRead::Detail {
+namespace SightRead {
 bool operator==(const BpmEvent& lhs, const BpmEvent& rhs)
 {
     return std::tie(lhs.position, lhs.bpm) == std::tie(rhs.position, rhs.bpm);
@@ -185,6 +187,30 @@ BOOST_AUTO_TEST_CASE(e_events_are_read)
                                   events.cend());
 }
 
+BOOST_AUTO_TEST_CASE(e_events_with_multiple_spaces_keep_their_spacing)
+{
+    const char* text = "[Section]\n{\n1000 = E section  intro 1\n}";
+    const std::vector<SightRead::Detail::Event> events {
+        {1000, "section  intro 1"}};
+
+    const auto section = SightRead::Detail::parse_chart(text).sections[0];
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(section.events.cbegin(),
+                                  section.events.cend(), events.cbegin(),
+                                  events.cend());
+}
+
+BOOST_AUTO_TEST_CASE(e_event_data_borrows_from_input)
+{
+    const std::string_view text = "[Section]\n{\n1000 = E soloing\n}";
+
+    const auto section = SightRead::Detail::parse_chart(text).sections[0];
+    const auto offset = section.events.at(0).data.data() - text.data();
+
+    BOOST_TEST(offset >= 0);
+    BOOST_TEST(offset < static_cast<std::ptrdiff_t>(text.size()));
+}
+
 BOOST_AUTO_TEST_CASE(other_events_are_ignored)
 {
     const char* text = "[Section]\n{\n1105 = A 133\n}";
@@ -218,3 +244,74 @@ BOOST_AUTO_TEST_CASE(short_mid_section_lines_throw)
         }(),
         SightRead::ParseError);
 }
+
+BOOST_AUTO_TEST_CASE(sections_of_unpermitted_instruments_are_skipped)
+{
+    const char* text = "[Song]\n{\n}\n[ExpertDrums]\n{\n768 = N 1\n}\n"
+                       "[ExpertSingle]\n{\n768 = N 0 0\n}";
+
+    const auto chart = SightRead::Detail::parse_chart(
+        text, {SightRead::Instrument::Guitar});
+
+    BOOST_REQUIRE_EQUAL(chart.sections.size(), 2);
+    BOOST_CHECK_EQUAL(chart.sections[0].name, "Song");
+    BOOST_CHECK_EQUAL(chart.sections[1].name, "ExpertSingle");
+    BOOST_CHECK_EQUAL(chart.sections[1].note_events.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(unfinished_skipped_sections_still_throw)
+{
+    BOOST_CHECK_THROW(
+        [&] {
+            return SightRead::Detail::parse_chart(
+                "[ExpertDrums]\n{\n768 = N 1 0\n",
+                {SightRead::Instrument::Guitar});
+        }(),
+        SightRead::ParseError);
+}
+
+BOOST_AUTO_TEST_SUITE(chart_memory_resources)
+
+BOOST_AUTO_TEST_CASE(chart_is_allocated_from_the_given_resource)
+{
+    const char* text
+        = "[Song]\n{\nKey = Value\n}\n[ExpertSingle]\n{\n768 = N 0 0\n}";
+    std::pmr::monotonic_buffer_resource resource;
+
+    const auto chart = SightRead::Detail::parse_chart(text, &resource);
+
+    BOOST_REQUIRE_EQUAL(chart.sections.size(), 2);
+    BOOST_CHECK(chart.sections.get_allocator().resource() == &resource);
+    for (const auto& section : chart.sections) {
+        BOOST_CHECK(section.name.get_allocator().resource() == &resource);
+        BOOST_CHECK(section.key_value_pairs.get_allocator().resource()
+                    == &resource);
+        BOOST_CHECK(section.note_events.get_allocator().resource()
+                    == &resource);
+    }
+    BOOST_CHECK(chart.sections[0]
+                    .key_value_pairs.at("Key")
+                    .get_allocator()
+                    .resource()
+                == &resource);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(chart_section_splitting)
+
+BOOST_AUTO_TEST_CASE(sections_are_split_at_their_closing_braces)
+{
+    const std::string_view text
+        = "[Song]\r\n{\r\nKey = Value\r\n}\r\n  [ExpertSingle]\n{\n"
+          "768 = N 0 0\n}\n[ExpertDrums]\n{\n";
+
+    const auto sections = SightRead::Detail::split_chart_sections(text);
+
+    BOOST_REQUIRE_EQUAL(sections.size(), 3);
+    BOOST_CHECK_EQUAL(sections[0], "[Song]\r\n{\r\nKey = Value\r\n}");
+    BOOST_CHECK_EQUAL(sections[1], "[ExpertSingle]\n{\n768 = N 0 0\n}");
+    BOOST_CHECK_EQUAL(sections[2], "[ExpertDrums]\n{\n");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,59 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+
+#include <boost/test/unit_test.hpp>
+
+#include "sightread/detail/mappedfile.hpp"
+
+namespace {
+class TemporaryFile {
+private:
+    std::filesystem::path m_path;
+
+public:
+    TemporaryFile(const std::string& name, const std::string& contents)
+        : m_path {std::filesystem::temp_directory_path() / name}
+    {
+        std::ofstream stream {m_path, std::ios::binary};
+        stream << contents;
+    }
+    TemporaryFile(const TemporaryFile&) = delete;
+    TemporaryFile& operator=(const TemporaryFile&) = delete;
+    TemporaryFile(TemporaryFile&&) = delete;
+    TemporaryFile& operator=(TemporaryFile&&) = delete;
+    ~TemporaryFile() { std::filesystem::remove(m_path); }
+
+    [[nodiscard]] const std::filesystem::path& path() const { return m_path; }
+};
+}
+
+BOOST_AUTO_TEST_CASE(mapped_files_have_the_file_contents)
+{
+    const TemporaryFile file {"sightread_mapped_file_test", "abc"};
+
+    const SightRead::Detail::MappedFile mapped_file {file.path()};
+    const auto data = mapped_file.data();
+
+    const std::string contents {data.begin(), data.end()};
+    BOOST_CHECK_EQUAL(contents, "abc");
+}
+
+BOOST_AUTO_TEST_CASE(empty_files_can_be_mapped)
+{
+    const TemporaryFile file {"sightread_empty_mapped_file_test", ""};
+
+    const SightRead::Detail::MappedFile mapped_file {file.path()};
+
+    BOOST_TEST(mapped_file.data().empty());
+}
+
+BOOST_AUTO_TEST_CASE(missing_files_throw)
+{
+    const auto path = std::filesystem::temp_directory_path()
+        / "sightread_file_that_does_not_exist";
+
+    BOOST_CHECK_THROW([&] { SightRead::Detail::MappedFile file {path}; }(),
+                      std::system_error);
+}
@@ -1,3 +1,5 @@
+#include <memory_resource>
+#include <optional>
 #include <tuple>
 
 #include <boost/test/unit_test.hpp>
@@ -5,6 +7,20 @@
 #include "sightread/detail/midi.hpp"
 #include "sightread/tempomap.hpp"
 
+namespace SightRead {
+bool operator==(const MidiEvent& lhs, const MidiEvent& rhs)
+{
+    return std::tie(lhs.status, lhs.data) == std::tie(rhs.status, rhs.data);
+}
+
+std::ostream& operator<<(std::ostream& stream, const MidiEvent& event)
+{
+    stream << "{Status " << event.status << ", Data {";
+    stream << event.data.at(0) << ", " << event.data.at(1) << "}}";
+    return stream;
+}
+}
+
 namespace SightRead::Detail {
 bool operator==(const MetaEvent& lhs, const MetaEvent& rhs)
 {
@@ -24,18 +40,6 @@ std::ostream& operator<<(std::ostream& stream, const MetaEvent& event)
     return stream;
 }
 
-bool operator==(const MidiEvent& lhs, const MidiEvent& rhs)
-{
-    return std::tie(lhs.status, lhs.data) == std::tie(rhs.status, rhs.data);
-}
-
-std::ostream& operator<<(std::ostream& stream, const MidiEvent& event)
-{
-    stream << "{Status " << event.status << ", Data {";
-    stream << event.data.at(0) << ", " << event.data.at(1) << "}}";
-    return stream;
-}
-
 bool operator==(const SysexEvent& lhs, const SysexEvent& rhs)
 {
     return lhs.data == rhs.data;
@@ -355,3 +359,177 @@ BOOST_AUTO_TEST_CASE(sysex_event_with_too_high_length_throws)
 }
 
 BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(midi_views)
+
+BOOST_AUTO_TEST_CASE(meta_event_views_borrow_from_input)
+{
+    std::vector<std::uint8_t> track {0x4D, 0x54, 0x72, 0x6B, 0, 0,    0,   7,
+                                     0x60, 0xFF, 0x51, 3,    8, 0x6B, 0xC3};
+    const auto data = midi_from_tracks({track});
+
+    const auto midi = SightRead::Detail::parse_midi_view(data);
+    const auto& event = std::get<SightRead::Detail::MetaEventView>(
+        midi.tracks[0].events[0].event);
+
+    BOOST_CHECK_EQUAL(midi.tracks[0].events[0].time, 0x60);
+    BOOST_CHECK_EQUAL(event.type, 0x51);
+    BOOST_CHECK_EQUAL(event.data.size(), 3);
+    BOOST_CHECK(event.data.data() == data.data() + data.size() - 3);
+}
+
+BOOST_AUTO_TEST_CASE(sysex_event_views_borrow_from_input)
+{
+    std::vector<std::uint8_t> track {0x4D, 0x54, 0x72, 0x6B, 0, 0, 0,
+                                     6,    0x0,  0xF0, 3,    1, 2, 3};
+    const auto data = midi_from_tracks({track});
+
+    const auto midi = SightRead::Detail::parse_midi_view(data);
+    const auto& event = std::get<SightRead::Detail::SysexEventView>(
+        midi.tracks[0].events[0].event);
+
+    BOOST_CHECK_EQUAL(event.data.size(), 3);
+    BOOST_CHECK(event.data.data() == data.data() + data.size() - 3);
+}
+
+BOOST_AUTO_TEST_CASE(views_of_parsed_midi_match_direct_views)
+{
+    std::vector<std::uint8_t> track {
+        0x4D, 0x54, 0x72, 0x6B, 0, 0,    0,    17, 0, 0x94, 0x7F, 0x64, 0x10,
+        0x7F, 0x64, 0,    0xFF, 1, 2,    1,    2,  0, 0xF0, 1,    4};
+    const auto data = midi_from_tracks({track});
+
+    const auto owned = SightRead::Detail::parse_midi(data);
+    const auto direct = SightRead::Detail::parse_midi_view(data);
+    const auto indirect = SightRead::Detail::make_midi_view(owned);
+
+    BOOST_REQUIRE_EQUAL(direct.tracks.size(), 1);
+    BOOST_REQUIRE_EQUAL(indirect.tracks.size(), 1);
+    const auto& direct_events = direct.tracks[0].events;
+    const auto& indirect_events = indirect.tracks[0].events;
+    BOOST_REQUIRE_EQUAL(direct_events.size(), 4);
+    BOOST_REQUIRE_EQUAL(indirect_events.size(), 4);
+    for (auto i = 0U; i < direct_events.size(); ++i) {
+        BOOST_CHECK_EQUAL(direct_events[i].time, indirect_events[i].time);
+        BOOST_CHECK_EQUAL(direct_events[i].event.index(),
+                          indirect_events[i].event.index());
+    }
+    const auto& meta_event = std::get<SightRead::Detail::MetaEventView>(
+        indirect_events[2].event);
+    const auto& owned_meta_event = std::get<SightRead::Detail::MetaEvent>(
+        owned.tracks[0].events[2].event);
+    BOOST_CHECK(meta_event.data.data() == owned_meta_event.data.data());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(midi_indices)
+
+BOOST_AUTO_TEST_CASE(track_names_and_data_are_indexed)
+{
+    std::vector<std::uint8_t> named_track {
+        0x4D, 0x54, 0x72, 0x6B, 0, 0, 0, 12, 0,    0xFF,
+        3,    4,    0x42, 0x45, 0x41, 0x54, 0, 0x90, 0x0C, 0x64};
+    std::vector<std::uint8_t> unnamed_track {
+        0x4D, 0x54, 0x72, 0x6B, 0, 0, 0, 4, 0, 0x90, 0x0C, 0x64};
+    const auto data = midi_from_tracks({named_track, unnamed_track});
+
+    const auto index = SightRead::Detail::index_midi(data);
+
+    BOOST_REQUIRE_EQUAL(index.tracks.size(), 2);
+    BOOST_CHECK(index.tracks[0].name == "BEAT");
+    BOOST_CHECK_EQUAL(index.tracks[0].data.size(), 12);
+    BOOST_CHECK(!index.tracks[1].name.has_value());
+    BOOST_CHECK(index.tracks[1].data.data() == data.data() + data.size() - 4);
+}
+
+BOOST_AUTO_TEST_CASE(decoded_tracks_match_parsed_tracks)
+{
+    std::vector<std::uint8_t> track {0x4D, 0x54, 0x72, 0x6B, 0,    0,    0,
+                                     7,    0,    0x90, 0x0C, 0x64, 0x10, 0x0C,
+                                     0};
+    const auto data = midi_from_tracks({track});
+
+    const auto index = SightRead::Detail::index_midi(data);
+    const auto decoded = SightRead::Detail::decode_midi_track(index.tracks[0]);
+    const auto parsed = SightRead::Detail::parse_midi_view(data);
+
+    BOOST_REQUIRE_EQUAL(decoded.events.size(), 2);
+    BOOST_REQUIRE_EQUAL(parsed.tracks[0].events.size(), 2);
+    BOOST_CHECK_EQUAL(decoded.events[1].time, parsed.tracks[0].events[1].time);
+    BOOST_CHECK_EQUAL(decoded.events[1].time, 0x10);
+}
+
+BOOST_AUTO_TEST_CASE(events_after_track_name_are_not_decoded_by_index)
+{
+    std::vector<std::uint8_t> track {0x4D, 0x54, 0x72, 0x6B, 0, 0,    0,
+                                     8,    0,    0xFF, 3,    1, 0x58, 0,
+                                     0xF1, 0};
+    const auto data = midi_from_tracks({track});
+
+    const auto index = SightRead::Detail::index_midi(data);
+
+    BOOST_CHECK(index.tracks[0].name == "X");
+    BOOST_CHECK_THROW([&] { return SightRead::Detail::parse_midi(data); }(),
+                      SightRead::ParseError);
+}
+
+BOOST_AUTO_TEST_CASE(indices_and_decoded_tracks_use_the_given_resource)
+{
+    std::vector<std::uint8_t> track {
+        0x4D, 0x54, 0x72, 0x6B, 0,    0,    0,    24,   0,    0xFF, 3,
+        16,   0x50, 0x41, 0x52, 0x54, 0x20, 0x47, 0x55, 0x49, 0x54, 0x41,
+        0x52, 0x20, 0x43, 0x4F, 0x4F, 0x50, 0,    0x90, 0x0C, 0x64};
+    const auto data = midi_from_tracks({track});
+    std::pmr::monotonic_buffer_resource resource;
+
+    const auto index = SightRead::Detail::index_midi(data, &resource);
+    const auto decoded
+        = SightRead::Detail::decode_midi_track(index.tracks[0], &resource);
+
+    BOOST_CHECK(index.tracks.get_allocator().resource() == &resource);
+    BOOST_REQUIRE(index.tracks[0].name == "PART GUITAR COOP");
+    BOOST_CHECK(index.tracks[0].name->get_allocator().resource()
+                == &resource);
+    BOOST_CHECK(decoded.events.get_allocator().resource() == &resource);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(midi_error_offsets)
+
+BOOST_AUTO_TEST_CASE(errors_give_the_offset_of_their_chunk)
+{
+    const std::vector<std::uint8_t> data {
+        0x4D, 0x54, 0x68, 0x64, 0, 0, 0, 6, 0, 1, 0, 2, 0x01, 0xE0,
+        0x4D, 0x54, 0x72, 0x6B, 0, 0, 0, 4, 0, 0xFF, 0x2F, 0,
+        0x4D, 0x54, 0x72, 0x6B, 0, 0, 0, 2, 0, 0xFF};
+
+    std::optional<std::size_t> offset;
+    try {
+        const auto midi = SightRead::Detail::parse_midi(data);
+    } catch (const SightRead::ParseError& error) {
+        offset = error.offset();
+    }
+
+    BOOST_CHECK_EQUAL(offset.value_or(0), 26);
+}
+
+BOOST_AUTO_TEST_CASE(truncated_files_give_the_offset_of_the_unfinished_chunk)
+{
+    const std::vector<std::uint8_t> data {0x4D, 0x54, 0x68, 0x64, 0, 0, 0, 6,
+                                          0,    1,    0,    1,    0x01, 0xE0,
+                                          0x4D, 0x54, 0x72, 0x6B, 0,    0,
+                                          0,    4,    0};
+
+    std::optional<std::size_t> offset;
+    try {
+        const auto midi = SightRead::Detail::parse_midi(data);
+    } catch (const SightRead::ParseError& error) {
+        offset = error.offset();
+    }
+
+    BOOST_CHECK_EQUAL(offset.value_or(0), 14);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -695,6 +695,61 @@ BOOST_AUTO_TEST_CASE(chords_can_be_forced)
                           | SightRead::FLAGS_FIVE_FRET_GUITAR);
 }
 
+BOOST_AUTO_TEST_CASE(rederived_hopos_match_reconverting)
+{
+    SightRead::Detail::MidiTrack note_track {
+        {{0, {part_event("PART GUITAR")}},
+         {0, {SightRead::Detail::MidiEvent {0x90, {96, 64}}}},
+         {1, {SightRead::Detail::MidiEvent {0x80, {96, 0}}}},
+         {240, {SightRead::Detail::MidiEvent {0x90, {97, 64}}}},
+         {241, {SightRead::Detail::MidiEvent {0x80, {97, 0}}}},
+         {480, {SightRead::Detail::MidiEvent {0x90, {98, 64}}}},
+         {480, {SightRead::Detail::MidiEvent {0x90, {102, 64}}}},
+         {481, {SightRead::Detail::MidiEvent {0x80, {98, 0}}}},
+         {481, {SightRead::Detail::MidiEvent {0x80, {102, 0}}}},
+         {642, {SightRead::Detail::MidiEvent {0x90, {99, 64}}}},
+         {643, {SightRead::Detail::MidiEvent {0x80, {99, 0}}}},
+         {1200, {SightRead::Detail::MidiEvent {0x90, {100, 64}}}},
+         {1200, {SightRead::Detail::MidiEvent {0x90, {101, 64}}}},
+         {1201, {SightRead::Detail::MidiEvent {0x80, {100, 0}}}},
+         {1201, {SightRead::Detail::MidiEvent {0x80, {101, 0}}}},
+         {1280, {SightRead::Detail::MidiEvent {0x90, {96, 64}}}},
+         {1281, {SightRead::Detail::MidiEvent {0x80, {96, 0}}}},
+         {1520, {SightRead::Detail::MidiEvent {0x90, {96, 64}}}},
+         {1521, {SightRead::Detail::MidiEvent {0x80, {96, 0}}}}}};
+    const SightRead::Detail::Midi midi {480, {note_track}};
+    // The 162 tick gap before the blue note is within the .chart threshold
+    // for this resolution but not the MIDI one.
+    const SightRead::HopoThreshold threshold {
+        SightRead::HopoThresholdType::Resolution, SightRead::Tick {0}};
+
+    const auto song = guitar_only_converter()
+                          .hopo_threshold(
+                              {SightRead::HopoThresholdType::HopoFrequency,
+                               SightRead::Tick {300}})
+                          .convert(midi);
+    const auto reconverted_song
+        = guitar_only_converter().hopo_threshold(threshold).convert(midi);
+    const auto rederived_song = song.with_hopo_threshold(threshold);
+    const auto& reconverted_notes
+        = reconverted_song
+              .track(SightRead::Instrument::Guitar,
+                     SightRead::Difficulty::Expert)
+              .notes();
+    const auto& rederived_notes
+        = rederived_song
+              .track(SightRead::Instrument::Guitar,
+                     SightRead::Difficulty::Expert)
+              .notes();
+
+    BOOST_REQUIRE_EQUAL(rederived_notes.size(), reconverted_notes.size());
+    for (auto i = 0U; i < reconverted_notes.size(); ++i) {
+        BOOST_CHECK_EQUAL(rederived_notes[i].flags, reconverted_notes[i].flags);
+    }
+    BOOST_CHECK_EQUAL(rederived_notes[3].flags,
+                      SightRead::FLAGS_FIVE_FRET_GUITAR);
+}
+
 BOOST_AUTO_TEST_CASE(taps_are_read)
 {
     SightRead::Detail::MidiTrack note_track {
@@ -1091,6 +1146,30 @@ BOOST_AUTO_TEST_CASE(missing_disco_flip_end_event_just_ends_at_max_int)
                                   flips.cend());
 }
 
+BOOST_AUTO_TEST_CASE(disco_flips_with_invalid_difficulties_are_ignored)
+{
+    SightRead::Detail::MidiTrack note_track {
+        {{0, {part_event("PART DRUMS")}},
+         {15,
+          {SightRead::Detail::MetaEvent {1,
+                                         {0x5B, 0x6D, 0x69, 0x78, 0x20, 0x39,
+                                          0x20, 0x64, 0x72, 0x75, 0x6D, 0x73,
+                                          0x30, 0x64, 0x5D}}}},
+         {45, {SightRead::Detail::MidiEvent {0x90, {98, 64}}}},
+         {65, {SightRead::Detail::MidiEvent {0x80, {98, 0}}}},
+         {75,
+          {SightRead::Detail::MetaEvent {1,
+                                         {0x5B, 0x6D, 0x69, 0x78, 0x20, 0x39,
+                                          0x20, 0x64, 0x72, 0x75, 0x6D, 0x73,
+                                          0x30, 0x5D}}}}}};
+    const SightRead::Detail::Midi midi {192, {note_track}};
+    const auto song = drums_only_converter().convert(midi);
+    const auto& track = song.track(SightRead::Instrument::Drums,
+                                   SightRead::Difficulty::Expert);
+
+    BOOST_CHECK(track.disco_flips().empty());
+}
+
 BOOST_AUTO_TEST_CASE(drum_five_lane_to_four_lane_conversion_is_done_from_mid)
 {
     SightRead::Detail::MidiTrack note_track {
@@ -1259,3 +1338,122 @@ BOOST_AUTO_TEST_CASE(fortnite_instrument_notes_are_separated)
 }
 
 BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(multithreaded_conversion)
+
+BOOST_AUTO_TEST_CASE(multithreaded_conversion_matches_serial_conversion)
+{
+    SightRead::Detail::MidiTrack guitar_track {
+        {{0, {part_event("PART GUITAR")}},
+         {0, {SightRead::Detail::MidiEvent {0x90, {96, 64}}}},
+         {65, {SightRead::Detail::MidiEvent {0x80, {96, 0}}}}}};
+    SightRead::Detail::MidiTrack bass_track {
+        {{0, {part_event("PART BASS")}},
+         {192, {SightRead::Detail::MidiEvent {0x90, {97, 64}}}},
+         {257, {SightRead::Detail::MidiEvent {0x80, {97, 0}}}}}};
+    SightRead::Detail::MidiTrack drum_track {
+        {{0, {part_event("PART DRUMS")}},
+         {384, {SightRead::Detail::MidiEvent {0x90, {98, 64}}}},
+         {385, {SightRead::Detail::MidiEvent {0x80, {98, 0}}}}}};
+    const SightRead::Detail::Midi midi {
+        192, {{}, guitar_track, bass_track, drum_track}};
+    const auto converter
+        = SightRead::Detail::MidiConverter({}).permit_instruments(
+            {SightRead::Instrument::Guitar, SightRead::Instrument::Bass,
+             SightRead::Instrument::Drums});
+
+    const auto serial_song = converter.convert(midi);
+    const auto parallel_song = SightRead::Detail::MidiConverter(converter)
+                                   .threads(4)
+                                   .convert(midi);
+    const auto serial_instruments = serial_song.instruments();
+    const auto parallel_instruments = parallel_song.instruments();
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        parallel_instruments.cbegin(), parallel_instruments.cend(),
+        serial_instruments.cbegin(), serial_instruments.cend());
+    for (auto instrument : serial_instruments) {
+        const auto& serial_notes
+            = serial_song.track(instrument, SightRead::Difficulty::Expert)
+                  .notes();
+        const auto& parallel_notes
+            = parallel_song.track(instrument, SightRead::Difficulty::Expert)
+                  .notes();
+        BOOST_CHECK_EQUAL_COLLECTIONS(
+            parallel_notes.cbegin(), parallel_notes.cend(),
+            serial_notes.cbegin(), serial_notes.cend());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(multithreaded_conversion_rethrows_track_errors)
+{
+    SightRead::Detail::MidiTrack good_track {
+        {{0, {part_event("PART GUITAR")}},
+         {0, {SightRead::Detail::MidiEvent {0x90, {96, 64}}}},
+         {65, {SightRead::Detail::MidiEvent {0x80, {96, 0}}}}}};
+    SightRead::Detail::MidiTrack bad_track {
+        {{0, {part_event("PART BASS")}},
+         {768, {SightRead::Detail::MidiEvent {0x90, {97, 64}}}}}};
+    const SightRead::Detail::Midi midi {192, {{}, good_track, bad_track}};
+    const auto converter
+        = SightRead::Detail::MidiConverter({})
+              .permit_instruments(
+                  {SightRead::Instrument::Guitar, SightRead::Instrument::Bass})
+              .threads(2);
+
+    BOOST_CHECK_THROW([&] { return converter.convert(midi); }(),
+                      SightRead::ParseError);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_CASE(midi_summaries_count_notes_per_difficulty)
+{
+    const std::vector<std::uint8_t> tempo_track {0, 0xFF, 0x2F, 0};
+    const std::vector<std::uint8_t> guitar_track {
+        0,    0x90, 96,   64, 0x60, 0x80, 96, 0, 0,    0x90, 97, 64, 0,
+        0x90, 60,   64,   0,  0x90, 101,  64, 0x60, 0x80, 97,   0,  0,
+        0x80, 60,   0,    0,  0x80, 101,  0,  0,    0xFF, 0x2F, 0};
+    const SightRead::Detail::MidiIndex midi {
+        192, {{tempo_track, std::nullopt}, {guitar_track, "PART GUITAR"}}};
+
+    const auto summary
+        = SightRead::Detail::MidiConverter({})
+              .permit_instruments({SightRead::Instrument::Guitar})
+              .summarise(midi);
+
+    BOOST_CHECK_EQUAL(summary.resolution, 192);
+    BOOST_REQUIRE_EQUAL(summary.tracks.size(), 2);
+    BOOST_CHECK(summary.tracks[0].difficulty == SightRead::Difficulty::Easy);
+    BOOST_CHECK_EQUAL(summary.tracks[0].note_count, 1);
+    BOOST_CHECK(summary.tracks[1].difficulty == SightRead::Difficulty::Expert);
+    BOOST_CHECK_EQUAL(summary.tracks[1].note_count, 2);
+    BOOST_CHECK_EQUAL(summary.length, SightRead::Tick {192});
+    BOOST_CHECK_CLOSE(summary.length_seconds.value(), 0.5, 0.0001);
+}
+
+BOOST_AUTO_TEST_CASE(midi_parse_stats_are_filled_in)
+{
+    const std::vector<std::uint8_t> tempo_track {0, 0xFF, 0x2F, 0};
+    const std::vector<std::uint8_t> guitar_track {
+        0,    0x90, 96,   64, 0x60, 0x80, 96, 0, 0,    0x90, 97, 64, 0,
+        0x90, 60,   64,   0,  0x90, 101,  64, 0x60, 0x80, 97,   0,  0,
+        0x80, 60,   0,    0,  0x80, 101,  0,  0,    0xFF, 0x2F, 0};
+    const SightRead::Detail::MidiIndex midi {
+        192, {{tempo_track, std::nullopt}, {guitar_track, "PART GUITAR"}}};
+    SightRead::ParseStats stats;
+
+    const auto song
+        = SightRead::Detail::MidiConverter({})
+              .permit_instruments({SightRead::Instrument::Guitar})
+              .convert(midi, &stats);
+
+    BOOST_REQUIRE_EQUAL(stats.tracks.size(), 1);
+    BOOST_CHECK_EQUAL(stats.tracks[0].instrument,
+                      SightRead::Instrument::Guitar);
+    BOOST_CHECK(!stats.tracks[0].difficulty.has_value());
+    BOOST_CHECK_EQUAL(stats.tracks[0].event_count, 9);
+    BOOST_CHECK_EQUAL(stats.event_count, 10);
+    BOOST_CHECK(stats.tracks[0].note_track.time
+                <= stats.tracks[0].conversion.time);
+}
@@ -0,0 +1,81 @@
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+#include <boost/test/unit_test.hpp>
+
+#include "sightread/detail/textencoding.hpp"
+#include "sightread/tempomap.hpp"
+
+namespace {
+// Encodes UTF-16 code units in the given byte order.
+std::string utf16(std::u16string_view text, bool little_endian)
+{
+    std::string bytes;
+    for (const auto unit : text) {
+        const auto low = static_cast<char>(unit & 0xFFU); // NOLINT
+        const auto high = static_cast<char>(unit >> 8U); // NOLINT
+        bytes.push_back(little_endian ? low : high);
+        bytes.push_back(little_endian ? high : low);
+    }
+    return bytes;
+}
+}
+
+BOOST_AUTO_TEST_SUITE(chart_text_encoding)
+
+BOOST_AUTO_TEST_CASE(utf8_text_is_returned_as_is)
+{
+    const std::string_view text {"[Song]\n{\n}"};
+    std::pmr::string buffer;
+
+    const auto result = SightRead::Detail::to_utf8(text, buffer);
+
+    BOOST_CHECK_EQUAL(result.data(), text.data());
+    BOOST_CHECK_EQUAL(result.size(), text.size());
+}
+
+BOOST_AUTO_TEST_CASE(utf8_byte_order_marks_are_skipped)
+{
+    const std::string_view text {"\xEF\xBB\xBF[Song]"};
+    std::pmr::string buffer;
+
+    BOOST_CHECK_EQUAL(SightRead::Detail::to_utf8(text, buffer), "[Song]");
+}
+
+BOOST_AUTO_TEST_CASE(utf16_with_a_byte_order_mark_is_transcoded)
+{
+    const auto text
+        = utf16(u"\uFEFF[Song]\n{\n  Name = \"Caf\u00E9 \u20AC\"\n}", true);
+    std::pmr::string buffer;
+
+    BOOST_CHECK_EQUAL(SightRead::Detail::to_utf8(text, buffer),
+                      "[Song]\n{\n  Name = \"Caf\xC3\xA9 \xE2\x82\xAC\"\n}");
+}
+
+BOOST_AUTO_TEST_CASE(big_endian_utf16_without_a_byte_order_mark_is_detected)
+{
+    const auto text = utf16(u"[Song] \U0001F600!", false);
+    std::pmr::string buffer;
+
+    BOOST_CHECK_EQUAL(SightRead::Detail::to_utf8(text, buffer),
+                      "[Song] \xF0\x9F\x98\x80!");
+}
+
+BOOST_AUTO_TEST_CASE(malformed_utf16_throws)
+{
+    std::u16string unpaired_text {u"\uFEFF[]"};
+    unpaired_text.insert(2, 1, u'\xD800');
+    const auto unpaired = utf16(unpaired_text, true);
+    const auto odd_length = utf16(u"\uFEFF[Song]", true) + "x";
+    std::pmr::string buffer;
+
+    BOOST_CHECK_THROW(
+        [&] { return SightRead::Detail::to_utf8(unpaired, buffer); }(),
+        SightRead::ParseError);
+    BOOST_CHECK_THROW(
+        [&] { return SightRead::Detail::to_utf8(odd_length, buffer); }(),
+        SightRead::ParseError);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,163 @@
+#include <string>
+#include <string_view>
+
+#include <boost/test/unit_test.hpp>
+
+#include "sightread/chartparser.hpp"
+#include "sightread/incrementalchartparser.hpp"
+#include "testhelpers.hpp"
+
+namespace {
+std::string chart_file(int resolution, int drum_position)
+{
+    return "[Song]\n{\n    Resolution = " + std::to_string(resolution)
+        + "\n}\n[SyncTrack]\n{\n    0 = B 120000\n}\n[Events]\n{\n}\n"
+          "[ExpertSingle]\n{\n    768 = N 0 0\n    960 = N 1 0\n}\n"
+          "[ExpertDrums]\n{\n    "
+        + std::to_string(drum_position) + " = N 0 0\n}";
+}
+
+void check_matches_chart_parser(std::string_view data)
+{
+    SightRead::IncrementalChartParser parser {{}};
+
+    const auto song = parser.parse(data);
+    const auto expected = SightRead::ChartParser({}).parse(data);
+
+    BOOST_CHECK_EQUAL(song.global_data().resolution(),
+                      expected.global_data().resolution());
+    const auto& notes
+        = song.track(SightRead::Instrument::Guitar,
+                     SightRead::Difficulty::Expert)
+              .notes();
+    const auto& expected_notes
+        = expected
+              .track(SightRead::Instrument::Guitar,
+                     SightRead::Difficulty::Expert)
+              .notes();
+    BOOST_CHECK_EQUAL_COLLECTIONS(notes.cbegin(), notes.cend(),
+                                  expected_notes.cbegin(),
+                                  expected_notes.cend());
+}
+}
+
+BOOST_AUTO_TEST_SUITE(incremental_chart_parser)
+
+BOOST_AUTO_TEST_CASE(result_is_the_same_as_chart_parser)
+{
+    const auto data = chart_file(192, 768);
+    SightRead::IncrementalChartParser parser {{}};
+
+    const auto song = parser.parse(data);
+    const auto expected = SightRead::ChartParser({}).parse(data);
+
+    for (const auto instrument :
+         {SightRead::Instrument::Guitar, SightRead::Instrument::Drums}) {
+        const auto& notes
+            = song.track(instrument, SightRead::Difficulty::Expert).notes();
+        const auto& expected_notes
+            = expected.track(instrument, SightRead::Difficulty::Expert)
+                  .notes();
+        BOOST_CHECK_EQUAL_COLLECTIONS(notes.cbegin(), notes.cend(),
+                                      expected_notes.cbegin(),
+                                      expected_notes.cend());
+    }
+    BOOST_CHECK_EQUAL(song.global_data().resolution(), 192);
+}
+
+BOOST_AUTO_TEST_CASE(unchanged_sections_share_their_tracks)
+{
+    SightRead::IncrementalChartParser parser {{}};
+
+    const auto first = parser.parse(chart_file(192, 768));
+    const auto second = parser.parse(chart_file(192, 960));
+
+    BOOST_CHECK_EQUAL(&first.track(SightRead::Instrument::Guitar,
+                                   SightRead::Difficulty::Expert),
+                      &second.track(SightRead::Instrument::Guitar,
+                                    SightRead::Difficulty::Expert));
+    BOOST_CHECK_NE(&first.track(SightRead::Instrument::Drums,
+                                SightRead::Difficulty::Expert),
+                   &second.track(SightRead::Instrument::Drums,
+                                 SightRead::Difficulty::Expert));
+    BOOST_CHECK_EQUAL(second
+                          .track(SightRead::Instrument::Drums,
+                                 SightRead::Difficulty::Expert)
+                          .notes()[0]
+                          .position,
+                      SightRead::Tick {960});
+}
+
+BOOST_AUTO_TEST_CASE(shared_tracks_are_timed_with_the_new_tempo_map)
+{
+    SightRead::IncrementalChartParser parser {{}};
+    auto data = chart_file(192, 768);
+
+    const auto first = parser.parse(data);
+    data.replace(data.find("B 120000"), 8, "B 240000");
+    const auto second = parser.parse(data);
+
+    BOOST_CHECK_EQUAL(&first.track(SightRead::Instrument::Guitar,
+                                   SightRead::Difficulty::Expert),
+                      &second.track(SightRead::Instrument::Guitar,
+                                    SightRead::Difficulty::Expert));
+    BOOST_CHECK_EQUAL(
+        second.global_data().tempo_map().bpms().front().bpm, 240000);
+    BOOST_CHECK_EQUAL(first.global_data().tempo_map().bpms().front().bpm,
+                      120000);
+}
+
+BOOST_AUTO_TEST_CASE(changing_the_resolution_converts_every_track_again)
+{
+    SightRead::IncrementalChartParser parser {{}};
+
+    const auto first = parser.parse(chart_file(192, 768));
+    const auto second = parser.parse(chart_file(480, 768));
+
+    BOOST_CHECK_NE(&first.track(SightRead::Instrument::Guitar,
+                                SightRead::Difficulty::Expert),
+                   &second.track(SightRead::Instrument::Guitar,
+                                 SightRead::Difficulty::Expert));
+    BOOST_CHECK_EQUAL(second.global_data().resolution(), 480);
+}
+
+BOOST_AUTO_TEST_CASE(failed_parses_keep_the_previous_sections)
+{
+    SightRead::IncrementalChartParser parser {{}};
+
+    const auto first = parser.parse(chart_file(192, 768));
+    BOOST_CHECK_THROW([&] { return parser.parse("[ExpertSingle]\n{\n"); }(),
+                      SightRead::ParseError);
+    const auto second = parser.parse(chart_file(192, 768));
+
+    BOOST_CHECK_EQUAL(&first.track(SightRead::Instrument::Guitar,
+                                   SightRead::Difficulty::Expert),
+                      &second.track(SightRead::Instrument::Guitar,
+                                    SightRead::Difficulty::Expert));
+}
+
+BOOST_AUTO_TEST_CASE(utf8_byte_order_marks_are_skipped)
+{
+    const auto data = "\xEF\xBB\xBF" + chart_file(480, 768);
+
+    const auto song = SightRead::IncrementalChartParser({}).parse(data);
+
+    BOOST_CHECK_EQUAL(song.global_data().resolution(), 480);
+    check_matches_chart_parser(data);
+}
+
+BOOST_AUTO_TEST_CASE(utf16_charts_are_transcoded)
+{
+    std::string data {"\xFF\xFE"};
+    for (const auto c : chart_file(480, 768)) {
+        data.push_back(c);
+        data.push_back('\0');
+    }
+
+    const auto song = SightRead::IncrementalChartParser({}).parse(data);
+
+    BOOST_CHECK_EQUAL(song.global_data().resolution(), 480);
+    check_matches_chart_parser(data);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
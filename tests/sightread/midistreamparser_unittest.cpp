@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "sightread/midistreamparser.hpp"
+#include "sightread/tempomap.hpp"
+
+namespace {
+std::vector<std::uint8_t>
+midi_from_tracks(const std::vector<std::vector<std::uint8_t>>& track_sections)
+{
+    std::vector<std::uint8_t> data {0x4D, 0x54, 0x68, 0x64, 0, 0, 0, 6, 0, 1};
+    auto count = track_sections.size();
+    data.push_back((count >> 8) & 0xFF);
+    data.push_back(count & 0xFF);
+    data.push_back(1);
+    data.push_back(0xE0);
+    for (const auto& track : track_sections) {
+        for (auto byte : track) {
+            data.push_back(byte);
+        }
+    }
+    return data;
+}
+
+// Records every callback as a line of text, so runs can be compared.
+class RecordingMidiVisitor : public SightRead::MidiVisitor {
+public:
+    std::vector<std::string> calls;
+
+    void header(int ticks_per_quarter_note, int track_count) override
+    {
+        calls.push_back("header " + std::to_string(ticks_per_quarter_note)
+                        + ' ' + std::to_string(track_count));
+    }
+
+    bool track_start(const SightRead::MidiTrackIndex& track) override
+    {
+        calls.emplace_back("start " + track.name.value_or("unnamed"));
+        return track.name != "SKIP";
+    }
+
+    void track_end() override { calls.emplace_back("end"); }
+
+    void meta_event(int time, const SightRead::MetaEventView& event) override
+    {
+        calls.push_back("meta " + std::to_string(time) + ' '
+                        + std::to_string(event.type));
+    }
+
+    void midi_event(int time, const SightRead::MidiEvent& event) override
+    {
+        calls.push_back("midi " + std::to_string(time) + ' '
+                        + std::to_string(event.status) + ' '
+                        + std::to_string(event.data[0]));
+    }
+};
+}
+
+BOOST_AUTO_TEST_SUITE(midi_stream_parser)
+
+BOOST_AUTO_TEST_CASE(chunk_boundaries_do_not_change_the_events)
+{
+    std::vector<std::uint8_t> skipped_track {
+        0x4D, 0x54, 0x72, 0x6B, 0, 0, 0, 12, 0,    0xFF,
+        3,    4,    0x53, 0x4B, 0x49, 0x50, 0, 0x90, 0x0C, 0x64};
+    std::vector<std::uint8_t> empty_track {0x4D, 0x54, 0x72, 0x6B, 0, 0, 0, 0};
+    std::vector<std::uint8_t> note_track {0x4D, 0x54, 0x72, 0x6B, 0,    0,
+                                          0,    7,    0,    0x90, 0x0C, 0x64,
+                                          0x10, 0x0C, 0};
+    const auto data
+        = midi_from_tracks({skipped_track, empty_track, note_track});
+    const std::vector<std::string> expected_calls {
+        "header 480 3",  "start SKIP",    "start unnamed",  "end",
+        "start unnamed", "midi 0 144 12", "midi 16 144 12", "end"};
+
+    for (auto chunk_size = 1U; chunk_size <= data.size(); ++chunk_size) {
+        RecordingMidiVisitor visitor;
+        SightRead::MidiStreamParser parser {visitor};
+        const std::span<const std::uint8_t> span {data};
+        for (auto i = 0U; i < data.size(); i += chunk_size) {
+            parser.feed(span.subspan(i, std::min<std::size_t>(
+                                            chunk_size, data.size() - i)));
+        }
+        parser.finish();
+
+        BOOST_CHECK_EQUAL_COLLECTIONS(visitor.calls.cbegin(),
+                                      visitor.calls.cend(),
+                                      expected_calls.cbegin(),
+                                      expected_calls.cend());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(finishing_inside_a_track_throws)
+{
+    std::vector<std::uint8_t> track {0x4D, 0x54, 0x72, 0x6B, 0,   0,
+                                     0,    4,    0,    0x90, 0x0C};
+    const auto data = midi_from_tracks({track});
+    RecordingMidiVisitor visitor;
+    SightRead::MidiStreamParser parser {visitor};
+
+    parser.feed(data);
+
+    BOOST_CHECK_THROW(parser.finish(), SightRead::ParseError);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,92 @@
+#include <boost/test/unit_test.hpp>
+
+#include "sightread/notetrackindex.hpp"
+#include "testhelpers.hpp"
+
+namespace {
+SightRead::NoteTrack make_track()
+{
+    std::vector<SightRead::Note> notes {make_note(0), make_note(192),
+                                        make_note(384), make_note(576),
+                                        make_note(768)};
+    std::vector<SightRead::StarPower> phrases {
+        {SightRead::Tick {0}, SightRead::Tick {100}},
+        {SightRead::Tick {384}, SightRead::Tick {100}}};
+    SightRead::NoteTrack track {notes, phrases, SightRead::TrackType::FiveFret,
+                                std::make_shared<SightRead::SongGlobalData>()};
+    track.solos({{SightRead::Tick {0}, SightRead::Tick {200}, 100},
+                 {SightRead::Tick {576}, SightRead::Tick {768}, 100}});
+    track.drum_fills({{SightRead::Tick {150}, SightRead::Tick {50}}});
+    track.disco_flips({{SightRead::Tick {700}, SightRead::Tick {10}}});
+    return track;
+}
+}
+
+BOOST_AUTO_TEST_SUITE(note_track_index_window_queries)
+
+BOOST_AUTO_TEST_CASE(notes_are_found_by_position_in_ticks)
+{
+    const auto track = make_track();
+    const SightRead::NoteTrackIndex index {track, SightRead::TempoMap {}};
+
+    const auto notes
+        = index.notes(SightRead::Tick {192}, SightRead::Tick {576});
+    const auto none = index.notes(SightRead::Tick {200}, SightRead::Tick {300});
+
+    BOOST_REQUIRE_EQUAL(notes.size(), 3);
+    BOOST_CHECK_EQUAL(notes.data(), track.notes().data() + 1);
+    BOOST_CHECK(none.empty());
+}
+
+BOOST_AUTO_TEST_CASE(notes_are_found_by_position_in_seconds)
+{
+    const auto track = make_track();
+    const SightRead::TempoMap tempo_map {
+        {}, {{SightRead::Tick {384}, 240000}}, {}, 192};
+    const SightRead::NoteTrackIndex index {track, tempo_map};
+
+    // At 120 BPM then 240 BPM from tick 384, the notes are at 0, 0.5, 1.0,
+    // 1.25 and 1.5 seconds.
+    const auto notes
+        = index.notes(SightRead::Second {0.75}, SightRead::Second {1.25});
+
+    BOOST_REQUIRE_EQUAL(notes.size(), 2);
+    BOOST_CHECK_EQUAL(notes[0].position, SightRead::Tick {384});
+    BOOST_CHECK_EQUAL(notes[1].position, SightRead::Tick {576});
+}
+
+BOOST_AUTO_TEST_CASE(phrases_overlapping_the_window_are_found)
+{
+    const auto track = make_track();
+    const SightRead::NoteTrackIndex index {track, SightRead::TempoMap {}};
+
+    const auto sp
+        = index.sp_phrases(SightRead::Tick {50}, SightRead::Tick {400});
+    const auto solos
+        = index.solos(SightRead::Second {1.4}, SightRead::Second {1.6});
+    const auto fills
+        = index.drum_fills(SightRead::Tick {190}, SightRead::Tick {190});
+    const auto flips
+        = index.disco_flips(SightRead::Tick {0}, SightRead::Tick {699});
+
+    BOOST_CHECK_EQUAL(sp.size(), 2);
+    BOOST_REQUIRE_EQUAL(solos.size(), 1);
+    BOOST_CHECK_EQUAL(solos[0].start, SightRead::Tick {576});
+    BOOST_CHECK_EQUAL(fills.size(), 1);
+    BOOST_CHECK(flips.empty());
+}
+
+BOOST_AUTO_TEST_CASE(unsorted_phrases_throw)
+{
+    auto track = make_track();
+    track.drum_fills({{SightRead::Tick {300}, SightRead::Tick {50}},
+                      {SightRead::Tick {150}, SightRead::Tick {50}}});
+
+    const SightRead::TempoMap tempo_map;
+
+    BOOST_CHECK_THROW(
+        [&] { return SightRead::NoteTrackIndex(track, tempo_map); }(),
+        std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,133 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "sightread/parsecache.hpp"
+#include "testhelpers.hpp"
+
+namespace {
+std::string chart_file(int note_count)
+{
+    std::string text = "[ExpertSingle]\n{\n";
+    for (auto i = 0; i < note_count; ++i) {
+        text += "    " + std::to_string(i * 192) + " = N 0 0\n"; // NOLINT
+    }
+    return text + "}";
+}
+}
+
+BOOST_AUTO_TEST_SUITE(parse_cache)
+
+BOOST_AUTO_TEST_CASE(identical_files_are_only_parsed_once)
+{
+    SightRead::ParseCache cache {1U << 20U};
+    const SightRead::ChartParser parser {{}};
+    const auto first_text = chart_file(4);
+    const auto second_text = chart_file(4);
+
+    const auto first = cache.parse(parser, first_text);
+    const auto second = cache.parse(parser, second_text);
+    const auto stats = cache.stats();
+
+    BOOST_CHECK_EQUAL(first.get(), second.get());
+    BOOST_CHECK_EQUAL(first->track(SightRead::Instrument::Guitar,
+                                   SightRead::Difficulty::Expert)
+                          .notes()
+                          .size(),
+                      4);
+    BOOST_CHECK_EQUAL(stats.hits, 1);
+    BOOST_CHECK_EQUAL(stats.misses, 1);
+    BOOST_CHECK_EQUAL(stats.entries, 1);
+    BOOST_CHECK_GT(stats.bytes, 0);
+}
+
+BOOST_AUTO_TEST_CASE(settings_are_part_of_the_key)
+{
+    SightRead::ParseCache cache {1U << 20U};
+    const auto text = chart_file(4);
+
+    const auto first = cache.parse(SightRead::ChartParser({}), text);
+    const auto second
+        = cache.parse(SightRead::ChartParser({}).parse_solos(false), text);
+    const auto third
+        = cache.parse(SightRead::ChartParser({"Name", "", ""}), text);
+    const auto fourth
+        = cache.parse(SightRead::ChartParser({}).threads(2), text);
+
+    BOOST_CHECK_NE(first.get(), second.get());
+    BOOST_CHECK_NE(first.get(), third.get());
+    BOOST_CHECK_EQUAL(first.get(), fourth.get());
+    BOOST_CHECK_EQUAL(third->global_data().name(), "Name");
+}
+
+BOOST_AUTO_TEST_CASE(least_recently_used_songs_are_evicted_first)
+{
+    const SightRead::ChartParser parser {{}};
+    const auto texts = {chart_file(1), chart_file(2), chart_file(3)};
+    std::size_t budget = 0;
+    for (const auto& text : texts) {
+        SightRead::ParseCache sizing_cache {1U << 20U};
+        (void)sizing_cache.parse(parser, text);
+        budget += sizing_cache.stats().bytes;
+    }
+    // Room for the last two songs, but not all three.
+    budget -= 1;
+    SightRead::ParseCache cache {budget};
+
+    const auto first = cache.parse(parser, chart_file(1));
+    (void)cache.parse(parser, chart_file(2));
+    (void)cache.parse(parser, chart_file(1));
+    (void)cache.parse(parser, chart_file(3));
+    const auto stats = cache.stats();
+    const auto first_again = cache.parse(parser, chart_file(1));
+
+    BOOST_CHECK_EQUAL(stats.evictions, 1);
+    BOOST_CHECK_EQUAL(stats.entries, 2);
+    BOOST_CHECK_LE(stats.bytes, budget);
+    BOOST_CHECK_EQUAL(first.get(), first_again.get());
+}
+
+BOOST_AUTO_TEST_CASE(songs_bigger_than_the_budget_are_not_cached)
+{
+    SightRead::ParseCache cache {1};
+    const SightRead::ChartParser parser {{}};
+
+    const auto song = cache.parse(parser, chart_file(4));
+
+    BOOST_CHECK_EQUAL(song->global_data().resolution(), 192);
+    BOOST_CHECK_EQUAL(cache.stats().entries, 0);
+    BOOST_CHECK_EQUAL(cache.stats().bytes, 0);
+}
+
+BOOST_AUTO_TEST_CASE(parse_errors_are_not_cached)
+{
+    SightRead::ParseCache cache {1U << 20U};
+    const SightRead::MidiParser parser {{}};
+    const std::vector<std::uint8_t> bad_midi {0x4D, 0x54, 0x68, 0x64};
+
+    for (auto i = 0; i < 2; ++i) {
+        BOOST_CHECK_THROW([&] { return cache.parse(parser, bad_midi); }(),
+                          SightRead::ParseError);
+    }
+
+    BOOST_CHECK_EQUAL(cache.stats().misses, 2);
+    BOOST_CHECK_EQUAL(cache.stats().entries, 0);
+}
+
+BOOST_AUTO_TEST_CASE(speeding_up_a_copy_leaves_the_cached_song_alone)
+{
+    SightRead::ParseCache cache {1U << 20U};
+    const SightRead::ChartParser parser {{}};
+    const auto text = chart_file(4);
+
+    auto copy = *cache.parse(parser, text);
+    copy.speedup(200);
+    const auto cached = cache.parse(parser, text);
+
+    BOOST_CHECK_EQUAL(cached->global_data().tempo_map().bpms().front().bpm,
+                      120000);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -75,6 +75,55 @@ BOOST_AUTO_TEST_CASE(difficulties_returns_the_difficulties_for_an_instrument)
                                   drum_difficulties.cend());
 }
 
+BOOST_AUTO_TEST_CASE(slot_views_report_size_and_membership)
+{
+    SightRead::NoteTrack guitar_track {
+        {make_note(192)},
+        {},
+        SightRead::TrackType::FiveFret,
+        std::make_shared<SightRead::SongGlobalData>()};
+    SightRead::Song song;
+    song.add_note_track(SightRead::Instrument::Bass,
+                        SightRead::Difficulty::Hard, guitar_track);
+    song.add_note_track(SightRead::Instrument::Keys,
+                        SightRead::Difficulty::Easy, guitar_track);
+
+    const auto instruments = song.instruments();
+    const auto bass_difficulties
+        = song.difficulties(SightRead::Instrument::Bass);
+
+    BOOST_CHECK_EQUAL(instruments.size(), 2U);
+    BOOST_CHECK(instruments.contains(SightRead::Instrument::Keys));
+    BOOST_CHECK(!instruments.contains(SightRead::Instrument::Guitar));
+    BOOST_CHECK_EQUAL(bass_difficulties.size(), 1U);
+    BOOST_CHECK(bass_difficulties.contains(SightRead::Difficulty::Hard));
+    BOOST_CHECK(song.difficulties(SightRead::Instrument::Drums).empty());
+}
+
+BOOST_AUTO_TEST_CASE(has_instrument_and_has_track_match_added_tracks)
+{
+    SightRead::NoteTrack guitar_track {
+        {make_note(192)},
+        {},
+        SightRead::TrackType::FiveFret,
+        std::make_shared<SightRead::SongGlobalData>()};
+    SightRead::Song song;
+    song.add_note_track(SightRead::Instrument::Bass,
+                        SightRead::Difficulty::Hard, guitar_track);
+
+    BOOST_CHECK(song.has_instrument(SightRead::Instrument::Bass));
+    BOOST_CHECK(!song.has_instrument(SightRead::Instrument::Guitar));
+    BOOST_CHECK(song.has_track(SightRead::Instrument::Bass,
+                               SightRead::Difficulty::Hard));
+    BOOST_CHECK(!song.has_track(SightRead::Instrument::Bass,
+                                SightRead::Difficulty::Expert));
+    BOOST_CHECK_THROW([&] {
+        return song.track(SightRead::Instrument::Bass,
+                          SightRead::Difficulty::Expert);
+    }(),
+                      std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_CASE(unison_phrase_positions_is_correct)
 {
     SightRead::NoteTrack guitar_track {
@@ -116,6 +165,27 @@ BOOST_AUTO_TEST_CASE(unison_phrase_positions_is_correct)
     BOOST_CHECK_EQUAL(unison_phrases[0], SightRead::Tick {768});
 }
 
+BOOST_AUTO_TEST_CASE(unison_phrases_need_two_different_instruments)
+{
+    SightRead::NoteTrack track {
+        {make_note(768)},
+        {{SightRead::Tick {768}, SightRead::Tick {100}}},
+        SightRead::TrackType::FiveFret,
+        std::make_shared<SightRead::SongGlobalData>()};
+    SightRead::Song song;
+    song.add_note_track(SightRead::Instrument::Guitar,
+                        SightRead::Difficulty::Expert, track);
+    song.add_note_track(SightRead::Instrument::Guitar,
+                        SightRead::Difficulty::Hard, track);
+
+    BOOST_CHECK(song.unison_phrase_positions().empty());
+
+    song.add_note_track(SightRead::Instrument::Bass,
+                        SightRead::Difficulty::Expert, track);
+
+    BOOST_CHECK_EQUAL(song.unison_phrase_positions().size(), 1);
+}
+
 BOOST_AUTO_TEST_SUITE(speedup)
 
 BOOST_AUTO_TEST_CASE(song_name_is_updated)
@@ -162,4 +232,58 @@ BOOST_AUTO_TEST_CASE(throws_on_zero_speed)
     BOOST_CHECK_THROW([&] { song.speedup(0); }(), std::invalid_argument);
 }
 
+BOOST_AUTO_TEST_CASE(with_speed_leaves_the_original_song_alone)
+{
+    SightRead::Song song;
+    song.global_data().name("TestName");
+
+    const auto fast_song = song.with_speed(200);
+
+    BOOST_CHECK_EQUAL(fast_song.global_data().name(), "TestName (200%)");
+    BOOST_CHECK_EQUAL(fast_song.global_data().tempo_map().bpms().front().bpm,
+                      240000);
+    BOOST_CHECK_EQUAL(song.global_data().name(), "TestName");
+    BOOST_CHECK_EQUAL(song.global_data().tempo_map().bpms().front().bpm,
+                      120000);
+}
+
+BOOST_AUTO_TEST_CASE(with_speed_shares_note_tracks)
+{
+    SightRead::NoteTrack guitar_track {
+        {make_note(192)},
+        {},
+        SightRead::TrackType::FiveFret,
+        std::make_shared<SightRead::SongGlobalData>()};
+    SightRead::Song song;
+    song.add_note_track(SightRead::Instrument::Guitar,
+                        SightRead::Difficulty::Expert, guitar_track);
+
+    const auto fast_song = song.with_speed(150);
+
+    BOOST_CHECK_EQUAL(
+        &fast_song.track(SightRead::Instrument::Guitar,
+                         SightRead::Difficulty::Expert),
+        &song.track(SightRead::Instrument::Guitar,
+                    SightRead::Difficulty::Expert));
+}
+
+BOOST_AUTO_TEST_CASE(speedup_does_not_affect_copies)
+{
+    SightRead::Song song;
+    auto copy = song;
+
+    copy.speedup(200);
+
+    BOOST_CHECK_EQUAL(song.global_data().tempo_map().bpms().front().bpm,
+                      120000);
+}
+
+BOOST_AUTO_TEST_CASE(with_speed_throws_on_non_positive_speeds)
+{
+    const SightRead::Song song;
+
+    BOOST_CHECK_THROW([&] { return song.with_speed(0); }(),
+                      std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,145 @@
+#include <boost/test/unit_test.hpp>
+
+#include "sightread/chartparser.hpp"
+#include "sightread/songcache.hpp"
+#include "testhelpers.hpp"
+
+namespace {
+SightRead::Song make_song()
+{
+    const std::string chart_file
+        = "[Song]\n{\n    Resolution = 192\n}\n"
+          "[SyncTrack]\n{\n    0 = TS 4\n    0 = B 120000\n"
+          "    768 = TS 3 3\n    960 = B 150000\n}\n"
+          "[Events]\n{\n    768 = E \"section Verse\"\n}\n"
+          "[ExpertSingle]\n{\n    0 = E solo\n    192 = N 0 96\n"
+          "    192 = N 1 0\n    384 = N 5 0\n    576 = N 2 0\n"
+          "    576 = S 2 200\n    800 = E soloend\n}\n"
+          "[ExpertDrums]\n{\n    192 = N 0 0\n    192 = N 66 0\n"
+          "    384 = N 32 0\n    576 = S 2 200\n}";
+
+    return SightRead::ChartParser({"TestName", "GMS", "NotGMS"})
+        .parse(chart_file);
+}
+}
+
+BOOST_AUTO_TEST_SUITE(song_cache_round_trips)
+
+BOOST_AUTO_TEST_CASE(metadata_and_tempo_map_are_preserved)
+{
+    const auto song = make_song();
+
+    const auto loaded
+        = SightRead::SongCache::load(SightRead::SongCache::save(song));
+    const auto& tempo_map = loaded.global_data().tempo_map();
+    const auto& old_tempo_map = song.global_data().tempo_map();
+
+    BOOST_CHECK_EQUAL(loaded.global_data().name(), "TestName");
+    BOOST_CHECK_EQUAL(loaded.global_data().artist(), "GMS");
+    BOOST_CHECK_EQUAL(loaded.global_data().charter(), "NotGMS");
+    BOOST_CHECK_EQUAL(loaded.global_data().resolution(), 192);
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        loaded.global_data().practice_sections().cbegin(),
+        loaded.global_data().practice_sections().cend(),
+        song.global_data().practice_sections().cbegin(),
+        song.global_data().practice_sections().cend());
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        tempo_map.bpms().cbegin(), tempo_map.bpms().cend(),
+        old_tempo_map.bpms().cbegin(), old_tempo_map.bpms().cend());
+    for (const auto beat : {0.0, 3.5, 4.5, 7.0, 12.0}) {
+        const SightRead::Beat beats {beat};
+        BOOST_CHECK_EQUAL(tempo_map.to_seconds(beats).value(),
+                          old_tempo_map.to_seconds(beats).value());
+        BOOST_CHECK_EQUAL(tempo_map.to_measures(beats).value(),
+                          old_tempo_map.to_measures(beats).value());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(note_tracks_are_preserved)
+{
+    const auto song = make_song();
+
+    const auto loaded
+        = SightRead::SongCache::load(SightRead::SongCache::save(song));
+
+    const auto instruments = loaded.instruments();
+    const auto old_instruments = song.instruments();
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(instruments.cbegin(), instruments.cend(),
+                                  old_instruments.cbegin(),
+                                  old_instruments.cend());
+    for (const auto instrument : old_instruments) {
+        const auto& track
+            = loaded.track(instrument, SightRead::Difficulty::Expert);
+        const auto& old_track
+            = song.track(instrument, SightRead::Difficulty::Expert);
+        const auto settings = SightRead::DrumSettings::default_settings();
+        BOOST_CHECK_EQUAL_COLLECTIONS(
+            track.notes().cbegin(), track.notes().cend(),
+            old_track.notes().cbegin(), old_track.notes().cend());
+        BOOST_CHECK_EQUAL(track.sp_phrases().size(),
+                          old_track.sp_phrases().size());
+        BOOST_CHECK_EQUAL_COLLECTIONS(
+            track.solos(settings).cbegin(), track.solos(settings).cend(),
+            old_track.solos(settings).cbegin(),
+            old_track.solos(settings).cend());
+        BOOST_CHECK_EQUAL_COLLECTIONS(
+            track.drum_fills().cbegin(), track.drum_fills().cend(),
+            old_track.drum_fills().cbegin(), old_track.drum_fills().cend());
+        BOOST_CHECK_EQUAL(track.base_score(), old_track.base_score());
+        BOOST_CHECK(track.track_type() == old_track.track_type());
+        BOOST_CHECK_EQUAL(track.resolution(),
+                          loaded.global_data().resolution());
+    }
+    BOOST_CHECK_EQUAL_COLLECTIONS(loaded.unison_phrase_positions().cbegin(),
+                                  loaded.unison_phrase_positions().cend(),
+                                  song.unison_phrase_positions().cbegin(),
+                                  song.unison_phrase_positions().cend());
+}
+
+BOOST_AUTO_TEST_CASE(saving_a_loaded_song_gives_the_same_bytes)
+{
+    const auto data = SightRead::SongCache::save(make_song());
+
+    const auto resaved
+        = SightRead::SongCache::save(SightRead::SongCache::load(data));
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(resaved.cbegin(), resaved.cend(),
+                                  data.cbegin(), data.cend());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(invalid_song_caches_are_rejected)
+
+BOOST_AUTO_TEST_CASE(data_without_the_magic_number_throws)
+{
+    auto data = SightRead::SongCache::save(make_song());
+    data[0] = 'X';
+
+    BOOST_CHECK_THROW([&] { return SightRead::SongCache::load(data); }(),
+                      SightRead::ParseError);
+}
+
+BOOST_AUTO_TEST_CASE(other_versions_throw)
+{
+    auto data = SightRead::SongCache::save(make_song());
+    data[4] ^= 0xFF;
+
+    BOOST_CHECK_THROW([&] { return SightRead::SongCache::load(data); }(),
+                      SightRead::ParseError);
+}
+
+BOOST_AUTO_TEST_CASE(truncated_data_throws)
+{
+    const auto data = SightRead::SongCache::save(make_song());
+
+    for (auto size = 0U; size < data.size(); ++size) {
+        const std::span<const std::uint8_t> truncated {data.data(), size};
+        BOOST_CHECK_THROW(
+            [&] { return SightRead::SongCache::load(truncated); }(),
+            SightRead::ParseError);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
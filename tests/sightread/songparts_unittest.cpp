@@ -88,6 +88,44 @@ BOOST_AUTO_TEST_CASE(notes_of_different_colours_are_dealt_with_separately)
                                   required_notes.cend());
 }
 
+BOOST_AUTO_TEST_CASE(drum_duplicates_are_removed_without_merging_lanes)
+{
+    std::vector<SightRead::Note> notes {
+        make_drum_note(768, SightRead::DRUM_RED),
+        make_drum_note(768, SightRead::DRUM_RED, SightRead::FLAGS_GHOST),
+        make_drum_note(768, SightRead::DRUM_YELLOW)};
+    SightRead::NoteTrack track {notes,
+                                {},
+                                SightRead::TrackType::Drums,
+                                std::make_shared<SightRead::SongGlobalData>()};
+    std::vector<SightRead::Note> required_notes {
+        make_drum_note(768, SightRead::DRUM_RED, SightRead::FLAGS_GHOST),
+        make_drum_note(768, SightRead::DRUM_YELLOW)};
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(track.notes().cbegin(), track.notes().cend(),
+                                  required_notes.cbegin(),
+                                  required_notes.cend());
+}
+
+BOOST_AUTO_TEST_CASE(fortnite_notes_at_the_same_time_are_kept_separate)
+{
+    std::vector<SightRead::Note> notes {
+        make_note(768, 0, SightRead::FIVE_FRET_RED),
+        make_note(768, 0, SightRead::FIVE_FRET_GREEN),
+        make_note(768, 0, SightRead::FIVE_FRET_GREEN)};
+    SightRead::NoteTrack track {notes,
+                                {},
+                                SightRead::TrackType::FortniteFestival,
+                                std::make_shared<SightRead::SongGlobalData>()};
+    const auto& track_notes = track.notes();
+
+    BOOST_REQUIRE_EQUAL(track_notes.size(), 2);
+    BOOST_CHECK_EQUAL(track_notes[0].colours(),
+                      1 << SightRead::FIVE_FRET_RED);
+    BOOST_CHECK_EQUAL(track_notes[1].colours(),
+                      1 << SightRead::FIVE_FRET_GREEN);
+}
+
 BOOST_AUTO_TEST_CASE(open_and_non_open_notes_of_same_pos_and_length_are_merged)
 {
     std::vector<SightRead::Note> notes {
@@ -212,6 +250,26 @@ BOOST_AUTO_TEST_CASE(solos_do_take_into_account_drum_settings)
                                   required_solos.cend());
 }
 
+BOOST_AUTO_TEST_CASE(drum_solos_are_updated_when_solos_are_set_again)
+{
+    std::vector<SightRead::Note> notes {
+        make_drum_note(0, SightRead::DRUM_KICK),
+        make_drum_note(192, SightRead::DRUM_RED)};
+    SightRead::NoteTrack track {notes,
+                                {},
+                                SightRead::TrackType::Drums,
+                                std::make_shared<SightRead::SongGlobalData>()};
+    track.solos({{SightRead::Tick {0}, SightRead::Tick {1}, 100}});
+    track.solos({{SightRead::Tick {192}, SightRead::Tick {193}, 100}});
+    std::vector<SightRead::Solo> required_solos {
+        {SightRead::Tick {192}, SightRead::Tick {193}, 100}};
+    const auto& solo_output = track.solos({true, true, true, false});
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(solo_output.cbegin(), solo_output.cend(),
+                                  required_solos.cbegin(),
+                                  required_solos.cend());
+}
+
 BOOST_AUTO_TEST_SUITE(automatic_drum_activation_zone_generation_is_correct)
 
 BOOST_AUTO_TEST_CASE(automatic_zones_are_created)
@@ -254,6 +312,28 @@ BOOST_AUTO_TEST_CASE(automatic_zones_have_250ms_of_leniency)
                                   fills.cend());
 }
 
+BOOST_AUTO_TEST_CASE(automatic_zones_are_spaced_out_in_dense_tracks)
+{
+    std::vector<SightRead::Note> notes;
+    for (auto i = 0; i <= 48; ++i) {
+        notes.push_back(make_drum_note(192 * i));
+    }
+    SightRead::NoteTrack track {notes,
+                                {},
+                                SightRead::TrackType::Drums,
+                                std::make_shared<SightRead::SongGlobalData>()};
+    std::vector<SightRead::DrumFill> fills {
+        {SightRead::Tick {384}, SightRead::Tick {384}},
+        {SightRead::Tick {3456}, SightRead::Tick {384}},
+        {SightRead::Tick {6528}, SightRead::Tick {384}}};
+
+    track.generate_drum_fills({});
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(track.drum_fills().cbegin(),
+                                  track.drum_fills().cend(), fills.cbegin(),
+                                  fills.cend());
+}
+
 BOOST_AUTO_TEST_CASE(automatic_zones_handle_skipped_measures_correctly)
 {
     std::vector<SightRead::Note> notes {make_drum_note(768),
@@ -332,6 +412,37 @@ BOOST_AUTO_TEST_CASE(fill_ends_remain_snapped_to_measure)
                                   fills.cend());
 }
 
+// The fill start lands just short of tick 384 here, so this catches any
+// change in rounding in the TempoMap's conversions.
+BOOST_AUTO_TEST_CASE(fill_positions_are_stable_with_several_tempo_changes)
+{
+    std::vector<SightRead::Note> notes {
+        make_drum_note(768), make_drum_note(1536), make_drum_note(2304),
+        make_drum_note(3072), make_drum_note(3840)};
+    SightRead::TempoMap tempo_map {{},
+                                   {{SightRead::Tick {0}, 230000},
+                                    {SightRead::Tick {969}, 183000},
+                                    {SightRead::Tick {1748}, 94000},
+                                    {SightRead::Tick {2925}, 107000}},
+                                   {},
+                                   192};
+
+    auto global_data = std::make_shared<SightRead::SongGlobalData>();
+    global_data->tempo_map(tempo_map);
+
+    SightRead::NoteTrack track {
+        notes, {}, SightRead::TrackType::Drums, global_data};
+    std::vector<SightRead::DrumFill> fills {
+        {SightRead::Tick {383}, SightRead::Tick {385}},
+        {SightRead::Tick {3456}, SightRead::Tick {384}}};
+
+    track.generate_drum_fills(tempo_map);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(track.drum_fills().cbegin(),
+                                  track.drum_fills().cend(), fills.cbegin(),
+                                  fills.cend());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE(base_score_for_average_multiplier_is_correct)
@@ -441,6 +552,35 @@ BOOST_AUTO_TEST_CASE(base_score_is_correctly_handled_with_open_note_merging)
     BOOST_CHECK_EQUAL(track.base_score(), 50);
 }
 
+BOOST_AUTO_TEST_CASE(negative_sustains_count_towards_base_score)
+{
+    std::vector<SightRead::Note> single_notes {make_note(0, -100)};
+    std::vector<SightRead::Note> chord_notes {
+        make_note(0, -100), make_note(0, -50, SightRead::FIVE_FRET_RED)};
+    std::vector<SightRead::Note> open_notes {
+        make_note(0, -100), make_note(0, -100, SightRead::FIVE_FRET_OPEN)};
+
+    SightRead::NoteTrack single_track {
+        single_notes,
+        {},
+        SightRead::TrackType::FiveFret,
+        std::make_shared<SightRead::SongGlobalData>()};
+    SightRead::NoteTrack chord_track {
+        chord_notes,
+        {},
+        SightRead::TrackType::FiveFret,
+        std::make_shared<SightRead::SongGlobalData>()};
+    SightRead::NoteTrack open_track {
+        open_notes,
+        {},
+        SightRead::TrackType::FiveFret,
+        std::make_shared<SightRead::SongGlobalData>()};
+
+    BOOST_CHECK_EQUAL(single_track.base_score(), 38);
+    BOOST_CHECK_EQUAL(chord_track.base_score(), 82);
+    BOOST_CHECK_EQUAL(open_track.base_score(), 38);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE(base_score_is_correct_for_drums)
@@ -538,6 +678,23 @@ BOOST_AUTO_TEST_CASE(hmx_gh_snapping)
     BOOST_CHECK_EQUAL(new_notes[0].colours(), 1 | 2);
 }
 
+BOOST_AUTO_TEST_CASE(fortnite_notes_are_snapped_but_not_merged)
+{
+    const std::vector<SightRead::Note> notes {
+        make_note(0, 0, SightRead::FIVE_FRET_GREEN),
+        make_note(5, 0, SightRead::FIVE_FRET_RED)};
+    const SightRead::NoteTrack track {notes,
+                                      {},
+                                      SightRead::TrackType::FortniteFestival,
+                                      make_resolution(480)};
+    auto new_track = track.snap_chords(SightRead::Tick {10});
+    const auto& new_notes = new_track.notes();
+
+    BOOST_CHECK_EQUAL(new_notes.size(), 2);
+    BOOST_CHECK_EQUAL(new_notes[1].position, SightRead::Tick {0});
+    BOOST_CHECK_EQUAL(new_notes[1].colours(), 2);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_CASE(disable_dynamics_is_correct)
@@ -559,3 +716,127 @@ BOOST_AUTO_TEST_CASE(disable_dynamics_is_correct)
     BOOST_CHECK_EQUAL_COLLECTIONS(track.notes().cbegin(), track.notes().cend(),
                                   new_notes.cbegin(), new_notes.cend());
 }
+
+BOOST_AUTO_TEST_SUITE(combined_transforms_match_individual_transforms)
+
+BOOST_AUTO_TEST_CASE(rvalue_transforms_match_copying_transforms)
+{
+    std::vector<SightRead::Note> notes {
+        make_note(0, 65), make_note(2, 70, SightRead::FIVE_FRET_RED),
+        make_note(192, 200, SightRead::FIVE_FRET_YELLOW)};
+    const SightRead::NoteTrack track {
+        notes, {}, SightRead::TrackType::FiveFret,
+        std::make_shared<SightRead::SongGlobalData>()};
+
+    const auto copied_track
+        = track.trim_sustains().snap_chords(SightRead::Tick {5});
+    auto moved_track = track;
+    moved_track = std::move(moved_track).trim_sustains().snap_chords(
+        SightRead::Tick {5});
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        moved_track.notes().cbegin(), moved_track.notes().cend(),
+        copied_track.notes().cbegin(), copied_track.notes().cend());
+    BOOST_CHECK_EQUAL(moved_track.base_score(), copied_track.base_score());
+}
+
+BOOST_AUTO_TEST_CASE(transform_matches_chained_transforms)
+{
+    std::vector<SightRead::Note> notes {
+        make_drum_note(0, SightRead::DRUM_RED, SightRead::FLAGS_GHOST),
+        make_drum_note(3, SightRead::DRUM_YELLOW),
+        make_drum_note(192, SightRead::DRUM_RED, SightRead::FLAGS_ACCENT)};
+    const SightRead::NoteTrack track {
+        notes, {}, SightRead::TrackType::Drums,
+        std::make_shared<SightRead::SongGlobalData>()};
+    SightRead::NoteTrackTransforms transforms;
+    transforms.trim_sustains = true;
+    transforms.snap_gap = SightRead::Tick {5};
+    transforms.disable_dynamics = true;
+
+    const auto transformed_track = track.transform(transforms);
+    auto chained_track
+        = track.trim_sustains().snap_chords(SightRead::Tick {5});
+    chained_track.disable_dynamics();
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        transformed_track.notes().cbegin(), transformed_track.notes().cend(),
+        chained_track.notes().cbegin(), chained_track.notes().cend());
+    BOOST_CHECK_EQUAL(transformed_track.base_score(),
+                      chained_track.base_score());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(note_columns_match_notes)
+
+BOOST_AUTO_TEST_CASE(columns_have_positions_colours_and_flags)
+{
+    std::vector<SightRead::Note> notes {
+        make_chord(0,
+                   {{SightRead::FIVE_FRET_GREEN, 0},
+                    {SightRead::FIVE_FRET_RED, 0}}),
+        make_note(192, 0, SightRead::FIVE_FRET_BLUE)};
+    notes[1].flags = static_cast<SightRead::NoteFlags>(
+        notes[1].flags | SightRead::FLAGS_TAP);
+    const SightRead::NoteColumns columns {notes};
+
+    std::vector<SightRead::Tick> positions {SightRead::Tick {0},
+                                            SightRead::Tick {192}};
+    std::vector<std::uint8_t> colours {0b11, 0b1000};
+    std::vector<SightRead::NoteFlags> flags {notes[0].flags, notes[1].flags};
+
+    BOOST_CHECK_EQUAL(columns.size(), 2U);
+    BOOST_CHECK_EQUAL_COLLECTIONS(columns.positions().begin(),
+                                  columns.positions().end(), positions.cbegin(),
+                                  positions.cend());
+    BOOST_CHECK_EQUAL_COLLECTIONS(columns.colours().begin(),
+                                  columns.colours().end(), colours.cbegin(),
+                                  colours.cend());
+    BOOST_CHECK_EQUAL_COLLECTIONS(columns.flags().begin(),
+                                  columns.flags().end(), flags.cbegin(),
+                                  flags.cend());
+}
+
+BOOST_AUTO_TEST_CASE(only_lengths_of_used_lanes_are_stored)
+{
+    std::vector<SightRead::Note> notes {
+        make_chord(0,
+                   {{SightRead::FIVE_FRET_RED, 100},
+                    {SightRead::FIVE_FRET_ORANGE, 50}})};
+    const SightRead::NoteColumns columns {notes};
+
+    std::vector<SightRead::Tick> lengths {SightRead::Tick {100},
+                                          SightRead::Tick {50}};
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(columns.lengths(0).begin(),
+                                  columns.lengths(0).end(), lengths.cbegin(),
+                                  lengths.cend());
+    BOOST_CHECK_EQUAL(columns.length(0, SightRead::FIVE_FRET_ORANGE),
+                      SightRead::Tick {50});
+    BOOST_CHECK_EQUAL(columns.length(0, SightRead::FIVE_FRET_GREEN),
+                      SightRead::Tick {-1});
+}
+
+BOOST_AUTO_TEST_CASE(notes_can_be_rebuilt_from_columns)
+{
+    std::vector<SightRead::Note> notes {
+        make_note(0, 100, SightRead::FIVE_FRET_BLUE),
+        make_chord(192, {{SightRead::FIVE_FRET_YELLOW, 20},
+                         {SightRead::FIVE_FRET_OPEN, 40}})};
+    SightRead::NoteTrack track {notes,
+                                {},
+                                SightRead::TrackType::FiveFret,
+                                std::make_shared<SightRead::SongGlobalData>()};
+    const auto columns = track.note_columns();
+
+    std::vector<SightRead::Note> rebuilt_notes;
+    for (auto i = 0U; i < columns.size(); ++i) {
+        rebuilt_notes.push_back(columns.note(i));
+    }
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(rebuilt_notes.cbegin(), rebuilt_notes.cend(),
+                                  track.notes().cbegin(), track.notes().cend());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
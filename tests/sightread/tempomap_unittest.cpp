@@ -219,6 +219,22 @@ BOOST_AUTO_TEST_CASE(beats_to_seconds_conversion_works_correctly_after_speedup)
                       0.0001);
 }
 
+BOOST_AUTO_TEST_CASE(speedup_rescales_times_after_tempo_changes)
+{
+    const SightRead::TempoMap tempo_map {
+        {}, {{SightRead::Tick {0}, 120000}, {SightRead::Tick {768}, 240000}},
+        {}, 192};
+
+    const auto speedup = tempo_map.speedup(200);
+
+    BOOST_CHECK_CLOSE(speedup.to_seconds(SightRead::Beat {4}).value(), 1.0,
+                      0.0001);
+    BOOST_CHECK_CLOSE(speedup.to_seconds(SightRead::Beat {6}).value(), 1.25,
+                      0.0001);
+    BOOST_CHECK_CLOSE(speedup.to_beats(SightRead::Second {1.25}).value(), 6.0,
+                      0.0001);
+}
+
 BOOST_AUTO_TEST_CASE(beats_to_measures_conversion_works_correctly)
 {
     SightRead::TempoMap tempo_map {{{SightRead::Tick {0}, 5, 4},
@@ -292,3 +308,144 @@ BOOST_AUTO_TEST_CASE(seconds_to_measures_conversion_works_correctly)
             measures.at(i), 0.0001);
     }
 }
+
+BOOST_AUTO_TEST_CASE(conversions_are_correct_with_many_tempo_changes)
+{
+    std::vector<SightRead::BPM> bpms;
+    for (auto i = 0; i < 40; ++i) {
+        bpms.push_back({SightRead::Tick {200 * i}, 120000 + 1000 * (i % 2)});
+    }
+    SightRead::TempoMap tempo_map {
+        {{SightRead::Tick {0}, 4, 4}, {SightRead::Tick {3000}, 3, 4}},
+        bpms,
+        {},
+        200};
+    auto expected_time = 0.0;
+    for (auto i = 0; i < 30; ++i) {
+        expected_time += 60.0 / (120.0 + (i % 2));
+    }
+    // Tick 6000 is beat 30, which is measure 15 / 4 + 15 / 3 = 8.75.
+    const SightRead::Tick ticks {6000};
+    const SightRead::Measure measures {8.75};
+    const SightRead::Second seconds {expected_time};
+
+    BOOST_CHECK_CLOSE(tempo_map.to_seconds(ticks).value(), expected_time,
+                      0.0001);
+    BOOST_CHECK_CLOSE(tempo_map.to_seconds(measures).value(), expected_time,
+                      0.0001);
+    BOOST_CHECK_CLOSE(tempo_map.to_beats(seconds).value(), 30.0, 0.0001);
+    BOOST_CHECK_CLOSE(tempo_map.to_measures(seconds).value(), 8.75, 0.0001);
+    BOOST_CHECK_EQUAL(tempo_map.to_ticks(seconds), ticks);
+}
+
+BOOST_AUTO_TEST_SUITE(batch_conversions_match_single_conversions)
+
+BOOST_AUTO_TEST_CASE(ticks_to_seconds_batch_conversion_matches)
+{
+    SightRead::TempoMap tempo_map {
+        {{SightRead::Tick {0}, 4, 4}},
+        {{SightRead::Tick {0}, 150000},
+         {SightRead::Tick {800}, 200000},
+         {SightRead::Tick {1200}, 90000}},
+        {},
+        200};
+    const std::vector<SightRead::Tick> ticks {
+        SightRead::Tick {0},    SightRead::Tick {400},  SightRead::Tick {800},
+        SightRead::Tick {800},  SightRead::Tick {1000}, SightRead::Tick {1200},
+        SightRead::Tick {5000}};
+    std::vector<SightRead::Second> seconds(ticks.size(), SightRead::Second {0});
+
+    tempo_map.to_seconds(ticks, seconds);
+
+    for (auto i = 0U; i < ticks.size(); ++i) {
+        BOOST_CHECK_EQUAL(seconds[i].value(),
+                          tempo_map.to_seconds(ticks[i]).value());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(beats_to_measures_and_od_beats_batch_conversion_matches)
+{
+    SightRead::TempoMap tempo_map {
+        {{SightRead::Tick {0}, 5, 4},
+         {SightRead::Tick {1000}, 4, 4},
+         {SightRead::Tick {1200}, 4, 16}},
+        {},
+        {SightRead::Tick {0}, SightRead::Tick {200}, SightRead::Tick {500}},
+        200};
+    const std::vector<SightRead::Beat> beats {
+        SightRead::Beat {-1.0}, SightRead::Beat {0.0}, SightRead::Beat {2.5},
+        SightRead::Beat {5.0}, SightRead::Beat {8.0}};
+    std::vector<SightRead::Measure> measures(beats.size(),
+                                             SightRead::Measure {0});
+    std::vector<SightRead::OdBeat> od_beats(beats.size(),
+                                            SightRead::OdBeat {0});
+
+    tempo_map.to_measures(beats, measures);
+    tempo_map.to_od_beats(beats, od_beats);
+
+    for (auto i = 0U; i < beats.size(); ++i) {
+        BOOST_CHECK_EQUAL(measures[i].value(),
+                          tempo_map.to_measures(beats[i]).value());
+        BOOST_CHECK_EQUAL(od_beats[i].value(),
+                          tempo_map.to_od_beats(beats[i]).value());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(cursor_handles_positions_going_backwards)
+{
+    SightRead::TempoMap tempo_map {
+        {},
+        {{SightRead::Tick {0}, 150000}, {SightRead::Tick {800}, 200000}},
+        {},
+        200};
+    auto cursor = tempo_map.cursor();
+
+    const auto late_time = cursor.to_seconds(SightRead::Tick {1600});
+    const auto early_time = cursor.to_seconds(SightRead::Tick {400});
+    const auto early_beat = cursor.to_beats(early_time);
+
+    BOOST_CHECK_EQUAL(late_time.value(),
+                      tempo_map.to_seconds(SightRead::Tick {1600}).value());
+    BOOST_CHECK_EQUAL(early_time.value(),
+                      tempo_map.to_seconds(SightRead::Tick {400}).value());
+    BOOST_CHECK_EQUAL(early_beat.value(),
+                      tempo_map.to_beats(early_time).value());
+}
+
+BOOST_AUTO_TEST_CASE(cursor_measure_and_tick_conversions_match)
+{
+    SightRead::TempoMap tempo_map {
+        {{SightRead::Tick {0}, 5, 4}, {SightRead::Tick {1000}, 3, 4}},
+        {{SightRead::Tick {0}, 150000},
+         {SightRead::Tick {700}, 200000},
+         {SightRead::Tick {1500}, 90000}},
+        {},
+        200};
+    const std::vector<SightRead::Measure> measures {
+        SightRead::Measure {0.0}, SightRead::Measure {0.5},
+        SightRead::Measure {1.0}, SightRead::Measure {2.0},
+        SightRead::Measure {4.0}, SightRead::Measure {9.0}};
+    auto cursor = tempo_map.cursor();
+
+    for (const auto measure : measures) {
+        const auto seconds = tempo_map.to_seconds(measure);
+
+        BOOST_CHECK_EQUAL(cursor.to_beats(measure).value(),
+                          tempo_map.to_beats(measure).value());
+        BOOST_CHECK_EQUAL(cursor.to_seconds(measure).value(), seconds.value());
+        BOOST_CHECK_EQUAL(cursor.to_ticks(seconds).value(),
+                          tempo_map.to_ticks(seconds).value());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(mismatched_span_sizes_throw)
+{
+    const SightRead::TempoMap tempo_map;
+    const std::vector<SightRead::Tick> ticks {SightRead::Tick {0}};
+    std::vector<SightRead::Second> seconds;
+
+    BOOST_CHECK_THROW([&] { tempo_map.to_seconds(ticks, seconds); }(),
+                      std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()